@@ -0,0 +1,304 @@
+#include "AssetPack.h"
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+static uint64_t alignPackOffset(uint64_t offset)
+{
+    return (offset + ASSET_PACK_ALIGNMENT - 1) & ~(ASSET_PACK_ALIGNMENT - 1);
+}
+
+AssetPack::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Asset Pack Exception";
+    errorDescription = description;
+    return;
+}
+
+AssetPack::Exception::~Exception(void)
+{
+    return;
+}
+
+AssetPack::AssetPack(const std::string &path)
+    : file(std::make_shared<const FileView>(path))
+{
+    const unsigned char *bytes = file->getData();
+    size_t size = file->getSize();
+
+    AssetPackHeader header{};
+    if (size < sizeof(header))
+    {
+        AP_EXCEPT(path + " is too small to be an asset pack");
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != ASSET_PACK_VERSION)
+    {
+        AP_EXCEPT(path + " is not an asset pack of this version");
+    }
+
+    // The mapping is page aligned and entries follow the 16 byte header, so they are read in place
+    uint64_t entriesEnd = sizeof(header) + sizeof(AssetPackEntry) * static_cast<uint64_t>(header.entryCount);
+    if (entriesEnd + header.namesSize > size)
+    {
+        AP_EXCEPT(path + " is truncated");
+    }
+    entries = reinterpret_cast<const AssetPackEntry *>(bytes + sizeof(header));
+    entryCount = header.entryCount;
+    names = reinterpret_cast<const char *>(bytes + entriesEnd);
+
+    // Checked once here, lookups then trust the table
+    for (uint32_t i = 0; i < entryCount; i++)
+    {
+        const AssetPackEntry &entry = entries[i];
+        if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header.namesSize ||
+            entry.offset > size ||
+            entry.storedSize > size - entry.offset ||
+            entry.offset % ASSET_PACK_ALIGNMENT != 0 ||
+            (entry.compression == static_cast<uint32_t>(AssetCompression::Stored) && entry.storedSize != entry.size) ||
+            entry.compression > static_cast<uint32_t>(AssetCompression::Lz4) ||
+            entry.pathHash != hashPath(std::string(names + entry.nameOffset, entry.nameLength)))
+        {
+            AP_EXCEPT(path + " has a corrupt table of contents");
+        }
+        if (i > 0 && entries[i - 1].pathHash > entry.pathHash)
+        {
+            AP_EXCEPT(path + " table of contents is not sorted");
+        }
+    }
+    return;
+}
+
+AssetPack::~AssetPack(void)
+{
+    return;
+}
+
+uint64_t AssetPack::hashPath(const std::string &path)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : path)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+const AssetPackEntry *AssetPack::find(const std::string &path) const
+{
+    uint64_t hash = hashPath(path);
+    const AssetPackEntry *end = entries + entryCount;
+    const AssetPackEntry *entry = std::lower_bound(entries, end, hash, [](const AssetPackEntry &e, uint64_t h)
+                                                   { return e.pathHash < h; });
+
+    // Colliding hashes sit next to each other, told apart by their paths
+    for (; entry != end && entry->pathHash == hash; entry++)
+    {
+        if (entry->nameLength == path.size() && std::memcmp(names + entry->nameOffset, path.data(), path.size()) == 0)
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::contains(const std::string &path) const
+{
+    return find(path) != nullptr;
+}
+
+std::shared_ptr<const FileView> AssetPack::open(const std::string &path, bool populate) const
+{
+    const AssetPackEntry *entry = find(path);
+    if (entry == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (entry->compression == static_cast<uint32_t>(AssetCompression::Stored))
+    {
+        return std::make_shared<const FileView>(file, entry->offset, entry->size, path, populate);
+    }
+
+    std::vector<uint32_t> words((entry->size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    if (!decompressLz4Block(file->getData() + entry->offset,
+                            entry->storedSize,
+                            reinterpret_cast<unsigned char *>(words.data()),
+                            entry->size))
+    {
+        AP_EXCEPT("Failed to unpack " + path + " from " + file->getPath());
+    }
+    return std::make_shared<const FileView>(std::move(words), entry->size, path);
+}
+
+uint32_t AssetPack::getFileCount(void) const
+{
+    return entryCount;
+}
+
+const std::string &AssetPack::getPath(void) const
+{
+    return file->getPath();
+}
+
+AssetPackWriter::AssetPackWriter(void)
+{
+    return;
+}
+
+AssetPackWriter::~AssetPackWriter(void)
+{
+    return;
+}
+
+void AssetPackWriter::add(const std::string &packPath, const std::string &sourcePath)
+{
+    auto existing = std::find_if(files.begin(), files.end(), [&packPath](const std::pair<std::string, std::string> &f)
+                                 { return f.first == packPath; });
+    if (existing != files.end())
+    {
+        existing->second = sourcePath;
+        return;
+    }
+    files.push_back({packPath, sourcePath});
+    return;
+}
+
+size_t AssetPackWriter::getFileCount(void) const
+{
+    return files.size();
+}
+
+bool AssetPackWriter::write(const std::string &path, bool compress) const
+{
+    // Table order is the lookup order
+    std::vector<std::pair<std::string, std::string>> sorted = files;
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b)
+              {
+                  uint64_t hashA = AssetPack::hashPath(a.first);
+                  uint64_t hashB = AssetPack::hashPath(b.first);
+                  return hashA != hashB ? hashA < hashB : a.first < b.first;
+              });
+
+    AssetPackHeader header{};
+    std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(sorted.size());
+
+    std::vector<AssetPackEntry> entries(sorted.size());
+    std::string names;
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        entries[i].pathHash = AssetPack::hashPath(sorted[i].first);
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        entries[i].nameLength = static_cast<uint32_t>(sorted[i].first.size());
+        names += sorted[i].first;
+    }
+    header.namesSize = static_cast<uint32_t>(names.size());
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            return false;
+        }
+
+        // Table is filled in as contents are written, then written again over its placeholder
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(sizeof(AssetPackEntry) * entries.size()));
+        out.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        const char padding[ASSET_PACK_ALIGNMENT] = {};
+        std::vector<unsigned char> packed;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            FileView source(sorted[i].second);
+
+            const unsigned char *stored = source.getData();
+            entries[i].size = source.getSize();
+            entries[i].storedSize = source.getSize();
+            entries[i].compression = static_cast<uint32_t>(AssetCompression::Stored);
+            if (compress && source.getSize() > 0)
+            {
+                compressLz4Block(source.getData(), source.getSize(), packed);
+                if (packed.size() <= source.getSize() * (1.0 - ASSET_PACK_MIN_SAVING))
+                {
+                    stored = packed.data();
+                    entries[i].storedSize = packed.size();
+                    entries[i].compression = static_cast<uint32_t>(AssetCompression::Lz4);
+                }
+            }
+
+            uint64_t position = static_cast<uint64_t>(out.tellp());
+            entries[i].offset = alignPackOffset(position);
+            out.write(padding, static_cast<std::streamsize>(entries[i].offset - position));
+            out.write(reinterpret_cast<const char *>(stored), static_cast<std::streamsize>(entries[i].storedSize));
+        }
+
+        out.seekp(sizeof(header));
+        out.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(sizeof(AssetPackEntry) * entries.size()));
+        if (!out.good())
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+// Written while mounting at startup, read by every asset load after
+static std::mutex mountMutex;
+static std::vector<std::shared_ptr<const AssetPack>> mountedPacks;
+
+void mountAssetPack(std::shared_ptr<const AssetPack> pack)
+{
+    std::lock_guard<std::mutex> lock(mountMutex);
+    mountedPacks.push_back(pack);
+    return;
+}
+
+bool isAssetPacked(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mountMutex);
+    return std::any_of(mountedPacks.begin(), mountedPacks.end(), [&path](const std::shared_ptr<const AssetPack> &pack)
+                       { return pack->contains(path); });
+}
+
+std::shared_ptr<const FileView> openPackedAsset(const std::string &path, bool populate)
+{
+    std::vector<std::shared_ptr<const AssetPack>> packs;
+    {
+        std::lock_guard<std::mutex> lock(mountMutex);
+        packs = mountedPacks;
+    }
+    // Unpacking happens outside the lock, newest mount first
+    for (auto pack = packs.rbegin(); pack != packs.rend(); pack++)
+    {
+        std::shared_ptr<const FileView> view = (*pack)->open(path, populate);
+        if (view != nullptr)
+        {
+            return view;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const FileView> openAsset(const std::string &path, bool populate)
+{
+    std::shared_ptr<const FileView> view = openPackedAsset(path, populate);
+    if (view != nullptr)
+    {
+        return view;
+    }
+    return std::make_shared<const FileView>(path, populate);
+}
@@ -0,0 +1,571 @@
+#include "AssetStreamer.h"
+#include "MemoryHandler.h"
+
+AssetStreamer::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Asset Streamer Exception";
+    errorDescription = description;
+    return;
+}
+
+AssetStreamer::Exception::~Exception(void)
+{
+    return;
+}
+
+AssetStreamer::AssetStreamer(VkDevice device,
+                             VkQueue queue,
+                             uint32_t queueFamilyIndex,
+                             MemoryHandler &memoryHandler,
+                             TextureHandler &textureHandler,
+                             JobSystem &jobSystem)
+    : device(device), queue(queue), memory(memoryHandler), textures(textureHandler), jobs(jobSystem)
+{
+    formats = textures.support;
+    maxDecodesInFlight = std::max<size_t>(jobs.getThreadCount() * 2, 2);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+    {
+        AS_EXCEPT("Failed to create upload command pool");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        AS_EXCEPT("Failed to allocate upload command buffer");
+    }
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.pNext = nullptr;
+    fenceInfo.flags = 0;
+    if (vkCreateFence(device, &fenceInfo, nullptr, &uploadFence) != VK_SUCCESS)
+    {
+        AS_EXCEPT("Failed to create upload fence");
+    }
+
+    ioThread = std::thread(&AssetStreamer::ioLoop, this);
+    return;
+}
+
+AssetStreamer::~AssetStreamer(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        stopping = true;
+        for (auto &request : queued)
+        {
+            request->state = AssetState::Cancelled;
+        }
+        queued.clear();
+    }
+    requestAvailable.notify_all();
+    ioThread.join();
+
+    // Decode jobs hold a pointer back to the streamer
+    {
+        std::unique_lock<std::mutex> lock(requestMutex);
+        decodeFinished.wait(lock, [this](void) { return decodesInFlight == 0; });
+    }
+
+    if (batchPending)
+    {
+        vkWaitForFences(device, 1, &uploadFence, VK_TRUE, UINT64_MAX);
+        finishBatch();
+    }
+    releaseEvicted(UINT64_MAX);
+
+    vkDestroyFence(device, uploadFence, nullptr);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    return;
+}
+
+bool AssetStreamer::isSettled(AssetState state)
+{
+    return state == AssetState::Resident ||
+           state == AssetState::Evicted ||
+           state == AssetState::Cancelled ||
+           state == AssetState::Failed;
+}
+
+AssetHandle AssetStreamer::requestTexture(const std::string &path, const glm::vec3 &position, float bias)
+{
+    auto request = std::make_shared<Request>();
+    request->type = AssetType::Texture;
+    request->path = path;
+    request->position = position;
+    request->bias = bias;
+    return enqueue(request);
+}
+
+AssetHandle AssetStreamer::requestModel(ModelClass &model, const glm::vec3 &position, float bias)
+{
+    auto request = std::make_shared<Request>();
+    request->type = AssetType::Model;
+    request->path = model.typeName;
+    request->model = &model;
+    request->position = position;
+    request->bias = bias;
+    return enqueue(request);
+}
+
+AssetHandle AssetStreamer::enqueue(std::shared_ptr<Request> request)
+{
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+
+        // Two requests for one model would have workers writing the same object
+        for (const auto &existing : requests)
+        {
+            Request &other = *existing.second;
+            if (other.type != request->type ||
+                other.path != request->path ||
+                other.model != request->model)
+            {
+                continue;
+            }
+            // Evicted but not freed yet, a second upload of the path would collide with it
+            auto pending = std::find_if(evicted.begin(), evicted.end(), [&other](const auto &entry)
+                                        { return entry.first.get() == &other; });
+            if (pending != evicted.end())
+            {
+                evicted.erase(pending);
+                other.state = AssetState::Resident;
+                return other.handle;
+            }
+            if (other.state != AssetState::Evicted &&
+                other.state != AssetState::Cancelled &&
+                other.state != AssetState::Failed)
+            {
+                return other.handle;
+            }
+        }
+
+        request->handle = nextHandle++;
+        request->priority = glm::distance(request->position, lastCameraPosition) + request->bias;
+        requests[request->handle] = request;
+        queued.push_back(request);
+    }
+    requestAvailable.notify_one();
+    return request->handle;
+}
+
+bool AssetStreamer::cancel(AssetHandle handle)
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    auto found = requests.find(handle);
+    if (found == requests.end() || isSettled(found->second->state))
+    {
+        return false;
+    }
+
+    // Requests already past the queues are dropped by the stage holding them
+    std::shared_ptr<Request> request = found->second;
+    if (request->state == AssetState::Queued)
+    {
+        queued.erase(std::find(queued.begin(), queued.end(), request));
+    }
+    else if (request->state == AssetState::Ready)
+    {
+        ready.erase(std::find(ready.begin(), ready.end(), request));
+        request->texture.reset();
+    }
+    request->state = AssetState::Cancelled;
+    return true;
+}
+
+bool AssetStreamer::evict(AssetHandle handle)
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    auto found = requests.find(handle);
+    if (found == requests.end() ||
+        found->second->type != AssetType::Texture ||
+        found->second->state != AssetState::Resident)
+    {
+        return false;
+    }
+    found->second->state = AssetState::Evicted;
+    evicted.push_back({found->second, frame});
+    return true;
+}
+
+void AssetStreamer::updatePriorities(const glm::vec3 &cameraPosition)
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    lastCameraPosition = cameraPosition;
+    for (auto *list : {&queued, &ready})
+    {
+        for (auto &request : *list)
+        {
+            request->priority = glm::distance(request->position, cameraPosition) + request->bias;
+        }
+    }
+    return;
+}
+
+AssetState AssetStreamer::getState(AssetHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    auto found = requests.find(handle);
+    if (found == requests.end())
+    {
+        AS_EXCEPT("Unknown asset handle");
+    }
+    return found->second->state;
+}
+
+bool AssetStreamer::isResident(AssetHandle handle) const
+{
+    return getState(handle) == AssetState::Resident;
+}
+
+size_t AssetStreamer::getPendingCount(void) const
+{
+    std::lock_guard<std::mutex> lock(requestMutex);
+    size_t pending = 0;
+    for (const auto &request : requests)
+    {
+        pending += isSettled(request.second->state) ? 0 : 1;
+    }
+    return pending;
+}
+
+/*
+    Reads one file at a time, most urgent first; Stalls while
+    enough decodes are in flight so memory use stays bounded
+*/
+void AssetStreamer::ioLoop(void)
+{
+    auto byPriority = [](const std::shared_ptr<Request> &a, const std::shared_ptr<Request> &b) {
+        return a->priority < b->priority;
+    };
+
+    while (true)
+    {
+        std::shared_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(requestMutex);
+            requestAvailable.wait(lock, [this](void) {
+                return stopping || (!queued.empty() && decodesInFlight < maxDecodesInFlight);
+            });
+            if (stopping)
+            {
+                return;
+            }
+            auto next = std::min_element(queued.begin(), queued.end(), byPriority);
+            request = *next;
+            queued.erase(next);
+            request->state = AssetState::Reading;
+        }
+
+        // Models are generated in code for now and have no file to read
+        std::shared_ptr<const FileView> file;
+        bool readable = true;
+        if (request->type == AssetType::Texture)
+        {
+            // Populated here so workers never stall on the disk while decoding
+            try
+            {
+                file = openAsset(TextureHandler::getSourcePath(request->path, formats), true);
+            }
+            catch (ExceptionHandler &e)
+            {
+                std::cout << "[-] Failed to stream " << request->path << " : " << e.getErrorDescription() << std::endl;
+                readable = false;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            if (request->state == AssetState::Cancelled)
+            {
+                continue;
+            }
+            if (!readable)
+            {
+                request->state = AssetState::Failed;
+                continue;
+            }
+            request->state = AssetState::Decoding;
+            decodesInFlight++;
+        }
+
+        jobs.submit([this, request, file = std::move(file)](void) mutable {
+            decode(request, std::move(file));
+        });
+    }
+}
+
+// Runs on a worker thread
+void AssetStreamer::decode(std::shared_ptr<Request> request, std::shared_ptr<const FileView> file)
+{
+    std::shared_ptr<const TextureData> texture;
+    bool decoded = true;
+    try
+    {
+        if (request->type == AssetType::Texture)
+        {
+            texture = TextureHandler::prepare(request->path, std::move(file), formats);
+        }
+        else
+        {
+            decoded = request->model->loadModelData();
+        }
+    }
+    catch (ExceptionHandler &e)
+    {
+        std::cout << "[-] Failed to stream " << request->path << " : " << e.getErrorDescription() << std::endl;
+        decoded = false;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << "[-] Failed to stream " << request->path << " : " << e.what() << std::endl;
+        decoded = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        decodesInFlight--;
+        if (request->state != AssetState::Cancelled)
+        {
+            if (decoded)
+            {
+                request->texture = texture;
+                request->uploadBytes = 0;
+                if (texture != nullptr)
+                {
+                    for (const auto &level : texture->levels)
+                    {
+                        request->uploadBytes += level.getSize();
+                    }
+                }
+                else
+                {
+                    request->uploadBytes = request->model->vertexDataSize + request->model->indexDataSize;
+                }
+                request->state = AssetState::Ready;
+                ready.push_back(request);
+            }
+            else
+            {
+                request->state = AssetState::Failed;
+            }
+        }
+
+        // Under the lock, once decodesInFlight reaches 0 the destructor may destroy the condition variables
+        requestAvailable.notify_one();
+        decodeFinished.notify_all();
+    }
+    return;
+}
+
+void AssetStreamer::pump(void)
+{
+    // Frames that could read what was evicted MAX_FRAMES_IN_FLIGHT frames ago have completed
+    const uint64_t framesInFlight = static_cast<uint64_t>(MAX_FRAMES_IN_FLIGHT);
+    frame++;
+    if (frame >= framesInFlight)
+    {
+        releaseEvicted(frame - framesInFlight);
+    }
+
+    if (batchPending)
+    {
+        if (vkGetFenceStatus(device, uploadFence) != VK_SUCCESS)
+        {
+            return;
+        }
+        finishBatch();
+    }
+    startBatch();
+    return;
+}
+
+/*
+    Only one batch is in flight at a time, texture staging and
+    retired geometry buffers are released as a whole once it completes
+*/
+void AssetStreamer::startBatch(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        if (ready.empty())
+        {
+            return;
+        }
+        std::sort(ready.begin(), ready.end(), [](const auto &a, const auto &b) { return a->priority < b->priority; });
+
+        VkDeviceSize batchBytes = 0;
+        size_t count = 0;
+        while (count < ready.size() &&
+               (count == 0 || batchBytes + ready[count]->uploadBytes <= ASSET_UPLOAD_BUDGET))
+        {
+            batchBytes += ready[count]->uploadBytes;
+            ready[count]->state = AssetState::Uploading;
+            count++;
+        }
+        batch.assign(ready.begin(), ready.begin() + count);
+        ready.erase(ready.begin(), ready.begin() + count);
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pNext = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        AS_EXCEPT("Failed to begin upload command buffer");
+    }
+
+    // Payloads are no longer touched by other stages once uploading
+    std::vector<std::shared_ptr<Request>> failed;
+    for (auto &request : batch)
+    {
+        // Both uploads throw before recording anything, the rest of the batch is still submitted
+        try
+        {
+            if (request->type == AssetType::Texture)
+            {
+                textures.upload(commandBuffer, request->path, *request->texture);
+                request->texture.reset();
+            }
+            else
+            {
+                ModelClass &model = *request->model;
+                request->geometry = memory.geometry->allocate(model.vertexDataSize, model.indexDataSize);
+                memory.geometry->upload(commandBuffer, request->geometry, model.vertices.data(), model.indices.data());
+            }
+        }
+        catch (ExceptionHandler &e)
+        {
+            std::cout << "[-] Failed to stream " << request->path << " : " << e.getErrorDescription() << std::endl;
+            failed.push_back(request);
+        }
+        catch (std::exception &e)
+        {
+            std::cout << "[-] Failed to stream " << request->path << " : " << e.what() << std::endl;
+            failed.push_back(request);
+        }
+    }
+
+    for (auto &request : failed)
+    {
+        // Nothing was copied into it, the geometry can go now
+        if (request->geometry != GEOMETRY_INVALID_HANDLE)
+        {
+            memory.geometry->free(request->geometry);
+            request->geometry = GEOMETRY_INVALID_HANDLE;
+        }
+        request->texture.reset();
+        batch.erase(std::find(batch.begin(), batch.end(), request));
+    }
+    if (!failed.empty())
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        for (auto &request : failed)
+        {
+            if (request->state != AssetState::Cancelled)
+            {
+                request->state = AssetState::Failed;
+            }
+        }
+    }
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        AS_EXCEPT("Failed to end upload command buffer");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = nullptr;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    vkResetFences(device, 1, &uploadFence);
+    if (vkQueueSubmit(queue, 1, &submitInfo, uploadFence) != VK_SUCCESS)
+    {
+        AS_EXCEPT("Failed to submit upload batch");
+    }
+    batchPending = true;
+    return;
+}
+
+void AssetStreamer::finishBatch(void)
+{
+    textures.releaseStaging();
+    memory.geometry->releaseRetired();
+
+    std::vector<std::shared_ptr<Request>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        for (auto &request : batch)
+        {
+            if (request->state == AssetState::Cancelled)
+            {
+                dropped.push_back(request);
+                continue;
+            }
+            request->state = AssetState::Resident;
+            if (request->type == AssetType::Model)
+            {
+                request->model->geometry = request->geometry;
+            }
+        }
+    }
+
+    // Cancelled while their copies were running
+    for (auto &request : dropped)
+    {
+        freeAsset(*request);
+    }
+
+    batch.clear();
+    batchPending = false;
+    return;
+}
+
+void AssetStreamer::releaseEvicted(uint64_t completedFrame)
+{
+    std::vector<std::shared_ptr<Request>> released;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        size_t count = 0;
+        while (count < evicted.size() && evicted[count].second <= completedFrame)
+        {
+            released.push_back(evicted[count].first);
+            count++;
+        }
+        evicted.erase(evicted.begin(), evicted.begin() + count);
+    }
+
+    for (auto &request : released)
+    {
+        freeAsset(*request);
+    }
+    return;
+}
+
+void AssetStreamer::freeAsset(const Request &request)
+{
+    if (request.type == AssetType::Texture)
+    {
+        textures.unload(request.path);
+    }
+    else
+    {
+        memory.geometry->free(request.geometry);
+    }
+    return;
+}
@@ -0,0 +1,503 @@
+#include "BatchMath.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define BATCH_MATH_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define BATCH_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+glm::mat4 composeTransform(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    float xx = rotation.x * rotation.x;
+    float yy = rotation.y * rotation.y;
+    float zz = rotation.z * rotation.z;
+    float xy = rotation.x * rotation.y;
+    float xz = rotation.x * rotation.z;
+    float yz = rotation.y * rotation.z;
+    float wx = rotation.w * rotation.x;
+    float wy = rotation.w * rotation.y;
+    float wz = rotation.w * rotation.z;
+
+    glm::mat4 matrix;
+    matrix[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x,
+                          2.0f * (xy + wz) * scale.x,
+                          2.0f * (xz - wy) * scale.x,
+                          0.0f);
+    matrix[1] = glm::vec4(2.0f * (xy - wz) * scale.y,
+                          (1.0f - 2.0f * (xx + zz)) * scale.y,
+                          2.0f * (yz + wx) * scale.y,
+                          0.0f);
+    matrix[2] = glm::vec4(2.0f * (xz + wy) * scale.z,
+                          2.0f * (yz - wx) * scale.z,
+                          (1.0f - 2.0f * (xx + yy)) * scale.z,
+                          0.0f);
+    matrix[3] = glm::vec4(position, 1.0f);
+    return matrix;
+}
+
+/*
+    Each path has a compose and a multiply kernel. lhsStride is 1 for
+    an array of left hand matrices and 0 for one shared matrix, so the
+    same kernel serves both multiplyMatrices overloads
+*/
+namespace
+{
+    struct BatchKernels
+    {
+        void (*compose)(const glm::vec3 *, const glm::quat *, const glm::vec3 *, glm::mat4 *, size_t);
+        void (*multiply)(const glm::mat4 *, size_t, const glm::mat4 *, glm::mat4 *, size_t);
+    };
+
+    void composeScalar(const glm::vec3 *positions,
+                       const glm::quat *rotations,
+                       const glm::vec3 *scales,
+                       glm::mat4 *out,
+                       size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = composeTransform(positions[i], rotations[i], scales[i]);
+        }
+        return;
+    }
+
+    void multiplyScalar(const glm::mat4 *lhs, size_t lhsStride, const glm::mat4 *rhs, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = lhs[i * lhsStride] * rhs[i];
+        }
+        return;
+    }
+
+#ifdef BATCH_MATH_X86
+    // Lane j of the four registers becomes column `column` of out[j]
+    inline void storeColumns(glm::mat4 *out, int column, __m128 x, __m128 y, __m128 z, __m128 w)
+    {
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&out[0][column].x, x);
+        _mm_storeu_ps(&out[1][column].x, y);
+        _mm_storeu_ps(&out[2][column].x, z);
+        _mm_storeu_ps(&out[3][column].x, w);
+        return;
+    }
+
+    // Four quaternions as x, y, z, w registers
+    inline void loadRotations(const glm::quat *rotations, __m128 &x, __m128 &y, __m128 &z, __m128 &w)
+    {
+        x = _mm_loadu_ps(&rotations[0].x);
+        y = _mm_loadu_ps(&rotations[1].x);
+        z = _mm_loadu_ps(&rotations[2].x);
+        w = _mm_loadu_ps(&rotations[3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        return;
+    }
+
+    inline __m128 gather(const glm::vec3 *vectors, int component)
+    {
+        return _mm_set_ps(vectors[3][component], vectors[2][component], vectors[1][component], vectors[0][component]);
+    }
+
+    // Four transforms side by side, one lane each
+    void composeSSE(const glm::vec3 *positions,
+                    const glm::quat *rotations,
+                    const glm::vec3 *scales,
+                    glm::mat4 *out,
+                    size_t count)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x, y, z, w;
+            loadRotations(rotations + i, x, y, z, w);
+            __m128 sx = gather(scales + i, 0);
+            __m128 sy = gather(scales + i, 1);
+            __m128 sz = gather(scales + i, 2);
+
+            __m128 xx = _mm_mul_ps(x, x);
+            __m128 yy = _mm_mul_ps(y, y);
+            __m128 zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y);
+            __m128 xz = _mm_mul_ps(x, z);
+            __m128 yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x);
+            __m128 wy = _mm_mul_ps(w, y);
+            __m128 wz = _mm_mul_ps(w, z);
+
+            storeColumns(out + i, 0,
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+                         zero);
+            storeColumns(out + i, 1,
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+                         zero);
+            storeColumns(out + i, 2,
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+                         zero);
+            storeColumns(out + i, 3,
+                         gather(positions + i, 0),
+                         gather(positions + i, 1),
+                         gather(positions + i, 2),
+                         one);
+        }
+        composeScalar(positions + i, rotations + i, scales + i, out + i, count - i);
+        return;
+    }
+
+    void multiplySSE(const glm::mat4 *lhs, size_t lhsStride, const glm::mat4 *rhs, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::mat4 &a = lhs[i * lhsStride];
+            __m128 a0 = _mm_loadu_ps(&a[0].x);
+            __m128 a1 = _mm_loadu_ps(&a[1].x);
+            __m128 a2 = _mm_loadu_ps(&a[2].x);
+            __m128 a3 = _mm_loadu_ps(&a[3].x);
+            for (int column = 0; column < 4; column++)
+            {
+                const glm::vec4 &b = rhs[i][column];
+                __m128 result = _mm_mul_ps(a0, _mm_set1_ps(b.x));
+                result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b.y)));
+                result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b.z)));
+                result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b.w)));
+                _mm_storeu_ps(&out[i][column].x, result);
+            }
+        }
+        return;
+    }
+
+    __attribute__((target("avx2,fma"))) inline __m256 join(__m128 low, __m128 high)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+    }
+
+    // Eight transforms per step, loads and stores go through the SSE helpers a half at a time
+    __attribute__((target("avx2,fma"))) void composeAVX2(const glm::vec3 *positions,
+                                                         const glm::quat *rotations,
+                                                         const glm::vec3 *scales,
+                                                         glm::mat4 *out,
+                                                         size_t count)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128 x0, y0, z0, w0, x1, y1, z1, w1;
+            loadRotations(rotations + i, x0, y0, z0, w0);
+            loadRotations(rotations + i + 4, x1, y1, z1, w1);
+            __m256 x = join(x0, x1);
+            __m256 y = join(y0, y1);
+            __m256 z = join(z0, z1);
+            __m256 w = join(w0, w1);
+            __m256 sx = join(gather(scales + i, 0), gather(scales + i + 4, 0));
+            __m256 sy = join(gather(scales + i, 1), gather(scales + i + 4, 1));
+            __m256 sz = join(gather(scales + i, 2), gather(scales + i + 4, 2));
+
+            __m256 xx = _mm256_mul_ps(x, x);
+            __m256 yy = _mm256_mul_ps(y, y);
+            __m256 zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y);
+            __m256 xz = _mm256_mul_ps(x, z);
+            __m256 yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x);
+            __m256 wy = _mm256_mul_ps(w, y);
+            __m256 wz = _mm256_mul_ps(w, z);
+
+            __m256 columns[3][3] = {
+                {_mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+                 _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+                 _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx)},
+                {_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+                 _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+                 _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy)},
+                {_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+                 _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+                 _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz)}};
+
+            for (int column = 0; column < 3; column++)
+            {
+                const __m256 *c = columns[column];
+                storeColumns(out + i, column,
+                             _mm256_castps256_ps128(c[0]),
+                             _mm256_castps256_ps128(c[1]),
+                             _mm256_castps256_ps128(c[2]),
+                             zero);
+                storeColumns(out + i + 4, column,
+                             _mm256_extractf128_ps(c[0], 1),
+                             _mm256_extractf128_ps(c[1], 1),
+                             _mm256_extractf128_ps(c[2], 1),
+                             zero);
+            }
+            for (size_t half = 0; half < 8; half += 4)
+            {
+                storeColumns(out + i + half, 3,
+                             gather(positions + i + half, 0),
+                             gather(positions + i + half, 1),
+                             gather(positions + i + half, 2),
+                             _mm_set1_ps(1.0f));
+            }
+        }
+        composeSSE(positions + i, rotations + i, scales + i, out + i, count - i);
+        return;
+    }
+
+    // Two result columns per step, each 128 bit lane broadcasts its own column's elements
+    __attribute__((target("avx2,fma"))) void multiplyAVX2(const glm::mat4 *lhs,
+                                                          size_t lhsStride,
+                                                          const glm::mat4 *rhs,
+                                                          glm::mat4 *out,
+                                                          size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::mat4 &a = lhs[i * lhsStride];
+            __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a[0].x));
+            __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a[1].x));
+            __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a[2].x));
+            __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&a[3].x));
+            for (int column = 0; column < 4; column += 2)
+            {
+                __m256 b = _mm256_loadu_ps(&rhs[i][column].x);
+                __m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00));
+                result = _mm256_fmadd_ps(a1, _mm256_permute_ps(b, 0x55), result);
+                result = _mm256_fmadd_ps(a2, _mm256_permute_ps(b, 0xAA), result);
+                result = _mm256_fmadd_ps(a3, _mm256_permute_ps(b, 0xFF), result);
+                _mm256_storeu_ps(&out[i][column].x, result);
+            }
+        }
+        return;
+    }
+
+    const BatchKernels sseKernels = {composeSSE, multiplySSE};
+    const BatchKernels avx2Kernels = {composeAVX2, multiplyAVX2};
+#endif
+
+#ifdef BATCH_MATH_NEON
+    // Lane j of columns becomes column `column` of out[j]
+    inline void storeColumns(glm::mat4 *out, int column, float32x4x4_t columns)
+    {
+        float interleaved[16];
+        vst4q_f32(interleaved, columns);
+        for (int j = 0; j < 4; j++)
+        {
+            vst1q_f32(&out[j][column].x, vld1q_f32(interleaved + j * 4));
+        }
+        return;
+    }
+
+    void composeNEON(const glm::vec3 *positions,
+                     const glm::quat *rotations,
+                     const glm::vec3 *scales,
+                     glm::mat4 *out,
+                     size_t count)
+    {
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t two = vdupq_n_f32(2.0f);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            // Structured loads split interleaved components into registers
+            float32x4x4_t q = vld4q_f32(&rotations[i].x);
+            float32x4x3_t s = vld3q_f32(&scales[i].x);
+            float32x4x3_t p = vld3q_f32(&positions[i].x);
+            float32x4_t x = q.val[0], y = q.val[1], z = q.val[2], w = q.val[3];
+
+            float32x4_t xx = vmulq_f32(x, x);
+            float32x4_t yy = vmulq_f32(y, y);
+            float32x4_t zz = vmulq_f32(z, z);
+            float32x4_t xy = vmulq_f32(x, y);
+            float32x4_t xz = vmulq_f32(x, z);
+            float32x4_t yz = vmulq_f32(y, z);
+            float32x4_t wx = vmulq_f32(w, x);
+            float32x4_t wy = vmulq_f32(w, y);
+            float32x4_t wz = vmulq_f32(w, z);
+
+            storeColumns(out + i, 0, {{vmulq_f32(vfmsq_f32(one, two, vaddq_f32(yy, zz)), s.val[0]),
+                                       vmulq_f32(vmulq_f32(two, vaddq_f32(xy, wz)), s.val[0]),
+                                       vmulq_f32(vmulq_f32(two, vsubq_f32(xz, wy)), s.val[0]),
+                                       zero}});
+            storeColumns(out + i, 1, {{vmulq_f32(vmulq_f32(two, vsubq_f32(xy, wz)), s.val[1]),
+                                       vmulq_f32(vfmsq_f32(one, two, vaddq_f32(xx, zz)), s.val[1]),
+                                       vmulq_f32(vmulq_f32(two, vaddq_f32(yz, wx)), s.val[1]),
+                                       zero}});
+            storeColumns(out + i, 2, {{vmulq_f32(vmulq_f32(two, vaddq_f32(xz, wy)), s.val[2]),
+                                       vmulq_f32(vmulq_f32(two, vsubq_f32(yz, wx)), s.val[2]),
+                                       vmulq_f32(vfmsq_f32(one, two, vaddq_f32(xx, yy)), s.val[2]),
+                                       zero}});
+            storeColumns(out + i, 3, {{p.val[0], p.val[1], p.val[2], one}});
+        }
+        composeScalar(positions + i, rotations + i, scales + i, out + i, count - i);
+        return;
+    }
+
+    void multiplyNEON(const glm::mat4 *lhs, size_t lhsStride, const glm::mat4 *rhs, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::mat4 &a = lhs[i * lhsStride];
+            float32x4_t a0 = vld1q_f32(&a[0].x);
+            float32x4_t a1 = vld1q_f32(&a[1].x);
+            float32x4_t a2 = vld1q_f32(&a[2].x);
+            float32x4_t a3 = vld1q_f32(&a[3].x);
+            for (int column = 0; column < 4; column++)
+            {
+                float32x4_t b = vld1q_f32(&rhs[i][column].x);
+                float32x4_t result = vmulq_laneq_f32(a0, b, 0);
+                result = vfmaq_laneq_f32(result, a1, b, 1);
+                result = vfmaq_laneq_f32(result, a2, b, 2);
+                result = vfmaq_laneq_f32(result, a3, b, 3);
+                vst1q_f32(&out[i][column].x, result);
+            }
+        }
+        return;
+    }
+
+    const BatchKernels neonKernels = {composeNEON, multiplyNEON};
+#endif
+
+    const BatchKernels scalarKernels = {composeScalar, multiplyScalar};
+
+    const BatchKernels *getKernels(BatchMathPath path)
+    {
+        switch (path)
+        {
+#ifdef BATCH_MATH_X86
+        case BatchMathPath::SSE:
+            return &sseKernels;
+        case BatchMathPath::AVX2:
+            return &avx2Kernels;
+#endif
+#ifdef BATCH_MATH_NEON
+        case BatchMathPath::NEON:
+            return &neonKernels;
+#endif
+        default:
+            return &scalarKernels;
+        }
+    }
+
+    BatchMathPath detectPath(void)
+    {
+#ifdef BATCH_MATH_X86
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        {
+            return BatchMathPath::AVX2;
+        }
+        return BatchMathPath::SSE;
+#elif defined(BATCH_MATH_NEON)
+        return BatchMathPath::NEON;
+#else
+        return BatchMathPath::Scalar;
+#endif
+    }
+
+    struct ActivePath
+    {
+        std::atomic<BatchMathPath> path{detectPath()};
+        std::atomic<const BatchKernels *> kernels{getKernels(path)};
+    };
+
+    ActivePath &getActivePath(void)
+    {
+        static ActivePath active;
+        return active;
+    }
+
+    const BatchKernels &getActiveKernels(void)
+    {
+        return *getActivePath().kernels.load(std::memory_order_relaxed);
+    }
+}
+
+BatchMathPath getBatchMathPath(void)
+{
+    return getActivePath().path.load(std::memory_order_relaxed);
+}
+
+bool isBatchMathPathSupported(BatchMathPath path)
+{
+    switch (path)
+    {
+    case BatchMathPath::Scalar:
+        return true;
+#ifdef BATCH_MATH_X86
+    case BatchMathPath::SSE:
+        return true;
+    case BatchMathPath::AVX2:
+        return detectPath() == BatchMathPath::AVX2;
+#endif
+#ifdef BATCH_MATH_NEON
+    case BatchMathPath::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+void setBatchMathPath(BatchMathPath path)
+{
+    if (!isBatchMathPathSupported(path))
+    {
+        path = BatchMathPath::Scalar;
+    }
+    ActivePath &active = getActivePath();
+    active.path.store(path, std::memory_order_relaxed);
+    active.kernels.store(getKernels(path), std::memory_order_relaxed);
+    return;
+}
+
+const char *getBatchMathPathName(BatchMathPath path)
+{
+    switch (path)
+    {
+    case BatchMathPath::SSE:
+        return "SSE";
+    case BatchMathPath::AVX2:
+        return "AVX2";
+    case BatchMathPath::NEON:
+        return "NEON";
+    default:
+        return "Scalar";
+    }
+}
+
+void composeTransforms(const glm::vec3 *positions,
+                       const glm::quat *rotations,
+                       const glm::vec3 *scales,
+                       glm::mat4 *out,
+                       size_t count)
+{
+    getActiveKernels().compose(positions, rotations, scales, out, count);
+    return;
+}
+
+void multiplyMatrices(const glm::mat4 *lhs, const glm::mat4 *rhs, glm::mat4 *out, size_t count)
+{
+    getActiveKernels().multiply(lhs, 1, rhs, out, count);
+    return;
+}
+
+void multiplyMatrices(const glm::mat4 &lhs, const glm::mat4 *rhs, glm::mat4 *out, size_t count)
+{
+    getActiveKernels().multiply(&lhs, 0, rhs, out, count);
+    return;
+}
@@ -0,0 +1,651 @@
+#include "Benchmark.h"
+#include "BatchMath.h"
+#include "DrawData.h"
+#include "EntitySystems.h"
+#include "Meshlet.h"
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+void runBenchmarks(void)
+{
+    std::cout << "[+] Running benchmarks" << std::endl;
+    benchmarkEntityLayout(100000);
+    benchmarkTransformHierarchy(1000, 9, 10);
+    benchmarkJobOverhead(100000);
+    benchmarkJobScaling(1000000);
+    benchmarkBatchMath(100000);
+    benchmarkDrawDataRecording(DRAW_DATA_MAX_DRAWS);
+    benchmarkMeshlets(200);
+    return;
+}
+
+/*
+    Previous layout : every model type owned a vector of instance
+    objects, each carrying all of its data side by side
+*/
+namespace
+{
+    struct LegacyInstance
+    {
+        glm::vec3 position;
+        glm::quat rotation;
+        glm::vec3 scale;
+        glm::mat4 worldMatrix;
+        glm::vec4 worldBounds;
+        bool visible = false;
+    };
+
+    struct LegacyModel
+    {
+        MeshBounds bounds;
+        std::vector<LegacyInstance> instances;
+    };
+}
+
+void benchmarkEntityLayout(size_t entityCount)
+{
+    const int iterations = 50;
+    const MeshId meshCount = 8;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> spread(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    EntityStore store;
+    std::vector<LegacyModel> legacy(meshCount);
+    for (MeshId mesh = 0; mesh < meshCount; mesh++)
+    {
+        MeshBounds bounds{};
+        bounds.radius = 0.5f + mesh * 0.25f;
+        store.addMesh(bounds);
+        legacy[mesh].bounds = bounds;
+    }
+
+    for (size_t i = 0; i < entityCount; i++)
+    {
+        glm::vec3 position = {spread(random), spread(random), spread(random)};
+        glm::quat rotation = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+        glm::vec3 scale = glm::vec3(1.0f + 0.5f * unit(random));
+        MeshId mesh = static_cast<MeshId>(i % meshCount);
+
+        Entity entity = store.create(COMPONENT_TRANSFORM | COMPONENT_MESH);
+        store.setTransform(entity, position, rotation, scale);
+        store.setMesh(entity, mesh);
+
+        LegacyInstance instance{};
+        instance.position = position;
+        instance.rotation = rotation;
+        instance.scale = scale;
+        legacy[mesh].instances.push_back(instance);
+    }
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, -250.0f), glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 500.0f);
+    Frustum frustum = Frustum::fromMatrix(proj * view);
+
+    std::vector<InstanceData> instances;
+    std::vector<InstanceBatch> batches;
+    std::vector<InstanceData> legacyInstances;
+    size_t visibleCount = 0;
+    size_t legacyVisibleCount = 0;
+
+    // Every entity moves each iteration like the legacy layout assumed
+    double storeTransform = measureMilliseconds([&](void) {
+        for (auto &archetype : store.getArchetypes())
+        {
+            std::fill(archetype.transformFlags.begin(), archetype.transformFlags.end(), TRANSFORM_LOCAL_DIRTY);
+            archetype.transformsDirty = true;
+        }
+        updateWorldMatrices(store);
+        updateWorldBounds(store);
+    },
+                                                iterations);
+    double storeCull = measureMilliseconds([&](void) { visibleCount = cullEntities(store, frustum); }, iterations);
+    double storePack = measureMilliseconds([&](void) { packInstances(store, instances, batches); }, iterations);
+
+    double legacyTransform = measureMilliseconds([&](void) {
+        for (auto &model : legacy)
+        {
+            for (auto &instance : model.instances)
+            {
+                instance.worldMatrix = composeTransform(instance.position, instance.rotation, instance.scale);
+                const glm::mat4 &world = instance.worldMatrix;
+                float scale = std::max({glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                                        glm::dot(glm::vec3(world[1]), glm::vec3(world[1])),
+                                        glm::dot(glm::vec3(world[2]), glm::vec3(world[2]))});
+                glm::vec3 center = glm::vec3(world * glm::vec4(model.bounds.center, 1.0f));
+                instance.worldBounds = glm::vec4(center, model.bounds.radius * std::sqrt(scale));
+            }
+        }
+    },
+                                                 iterations);
+    double legacyCull = measureMilliseconds([&](void) {
+        legacyVisibleCount = 0;
+        for (auto &model : legacy)
+        {
+            for (auto &instance : model.instances)
+            {
+                instance.visible = frustum.intersectsSphere(glm::vec3(instance.worldBounds), instance.worldBounds.w);
+                legacyVisibleCount += instance.visible ? 1 : 0;
+            }
+        }
+    },
+                                            iterations);
+    double legacyPack = measureMilliseconds([&](void) {
+        legacyInstances.clear();
+        for (const auto &model : legacy)
+        {
+            for (const auto &instance : model.instances)
+            {
+                if (instance.visible)
+                {
+                    legacyInstances.push_back({instance.worldMatrix, instance.worldMatrix});
+                }
+            }
+        }
+    },
+                                            iterations);
+
+    if (visibleCount != legacyVisibleCount || instances.size() != legacyInstances.size())
+    {
+        std::cout << "\t[-] Self check : Layouts disagree on visible entities" << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "\t[+] Entity layout, " << entityCount << " entities, " << visibleCount << " visible (ms per pass)" << std::endl
+              << "\t\tPass        Store     Legacy" << std::endl
+              << "\t\tTransform   " << storeTransform << "     " << legacyTransform << std::endl
+              << "\t\tCull        " << storeCull << "     " << legacyCull << std::endl
+              << "\t\tPack        " << storePack << "     " << legacyPack << std::endl;
+    return;
+}
+
+void benchmarkTransformHierarchy(size_t rootCount, size_t childCount, size_t grandchildCount)
+{
+    const int iterations = 50;
+    JobSystem jobs;
+    TransformHierarchy serial;
+    TransformHierarchy parallel(&jobs);
+    EntityStore store;
+
+    std::vector<TransformNode> serialRoots;
+    std::vector<TransformNode> parallelRoots;
+    for (auto *hierarchy : {&serial, &parallel})
+    {
+        auto &roots = hierarchy == &serial ? serialRoots : parallelRoots;
+        for (size_t i = 0; i < rootCount; i++)
+        {
+            TransformNode root = hierarchy->create();
+            hierarchy->setLocal(root, glm::vec3(static_cast<float>(i), 0.0f, 0.0f));
+            roots.push_back(root);
+            for (size_t j = 0; j < childCount; j++)
+            {
+                TransformNode child = hierarchy->create(root);
+                hierarchy->setLocal(child, glm::vec3(0.0f, static_cast<float>(j), 0.0f));
+                for (size_t k = 0; k < grandchildCount; k++)
+                {
+                    TransformNode grandchild = hierarchy->create(child);
+                    hierarchy->setLocal(grandchild, glm::vec3(0.0f, 0.0f, static_cast<float>(k)));
+                }
+            }
+        }
+        hierarchy->update(store);
+    }
+
+    // Moves every step-th root, its whole subtree follows
+    float serialOffset = 0.0f;
+    float parallelOffset = 0.0f;
+    auto moveRoots = [&](TransformHierarchy &hierarchy, const std::vector<TransformNode> &roots, size_t step) {
+        float &offset = &hierarchy == &serial ? serialOffset : parallelOffset;
+        offset += 0.01f;
+        for (size_t i = 0; i < roots.size(); i += step)
+        {
+            hierarchy.setLocal(roots[i], glm::vec3(static_cast<float>(i), offset, 0.0f));
+        }
+        return hierarchy.update(store);
+    };
+
+    double serialAll = measureMilliseconds([&](void) { moveRoots(serial, serialRoots, 1); }, iterations);
+    double parallelAll = measureMilliseconds([&](void) { moveRoots(parallel, parallelRoots, 1); }, iterations);
+    double serialFew = measureMilliseconds([&](void) { moveRoots(serial, serialRoots, 100); }, iterations);
+    double parallelFew = measureMilliseconds([&](void) { moveRoots(parallel, parallelRoots, 100); }, iterations);
+    size_t staticComputed = 0;
+    double serialStatic = measureMilliseconds([&](void) { staticComputed += serial.update(store); }, iterations);
+    double parallelStatic = measureMilliseconds([&](void) { staticComputed += parallel.update(store); }, iterations);
+
+    // Both were built in the same order, the last node is the deepest
+    TransformNode last = static_cast<TransformNode>(serial.getNodeCount() - 1);
+    if (serial.getWorldMatrix(last) != parallel.getWorldMatrix(last))
+    {
+        std::cout << "\t[-] Self check : Serial and parallel hierarchies disagree" << std::endl;
+    }
+    if (staticComputed != 0)
+    {
+        std::cout << "\t[-] Self check : Static hierarchy recomputed " << staticComputed << " nodes" << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "\t[+] Transform hierarchy, " << serial.getNodeCount() << " nodes, "
+              << jobs.getThreadCount() << " threads (ms per update)" << std::endl
+              << "\t\tMoved       Serial    Parallel" << std::endl
+              << "\t\tAll         " << serialAll << "     " << parallelAll << std::endl
+              << "\t\t1%          " << serialFew << "     " << parallelFew << std::endl
+              << "\t\tNone        " << serialStatic << "     " << parallelStatic << std::endl;
+    return;
+}
+
+void benchmarkJobOverhead(size_t jobCount)
+{
+    const int iterations = 20;
+    JobSystem jobs;
+    std::atomic<size_t> executed = 0;
+
+    // Empty jobs, everything measured is queueing, stealing and counting
+    double single = measureMilliseconds([&](void) {
+        JobCounter counter;
+        for (size_t i = 0; i < jobCount; i++)
+        {
+            jobs.run([&executed](void) { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        }
+        jobs.wait(counter);
+    },
+                                        iterations);
+
+    // Each job waits on the one before it
+    const size_t chainLength = jobCount / 10;
+    double chained = measureMilliseconds([&](void) {
+        std::vector<std::unique_ptr<JobCounter>> counters;
+        counters.push_back(std::make_unique<JobCounter>());
+        jobs.run([&executed](void) { executed.fetch_add(1, std::memory_order_relaxed); }, counters.back().get());
+        for (size_t i = 1; i < chainLength; i++)
+        {
+            JobCounter &dependency = *counters.back();
+            counters.push_back(std::make_unique<JobCounter>());
+            jobs.runAfter(dependency, [&executed](void) { executed.fetch_add(1, std::memory_order_relaxed); }, counters.back().get());
+        }
+        jobs.wait(*counters.back());
+    },
+                                         iterations);
+
+    if (executed != (jobCount + chainLength) * iterations)
+    {
+        std::cout << "\t[-] Self check : " << executed << " jobs ran, expected "
+                  << (jobCount + chainLength) * iterations << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "\t[+] Job overhead, " << jobs.getThreadCount() << " threads (ns per job)" << std::endl
+              << "\t\tIndependent " << single * 1000000.0 / jobCount << std::endl
+              << "\t\tChained     " << chained * 1000000.0 / chainLength << std::endl;
+    return;
+}
+
+void benchmarkJobScaling(size_t itemCount)
+{
+    const int iterations = 10;
+    std::vector<glm::vec3> positions(itemCount, glm::vec3(1.0f, 2.0f, 3.0f));
+    std::vector<glm::quat> rotations(itemCount, glm::normalize(glm::quat(0.9f, 0.1f, 0.2f, 0.3f)));
+    std::vector<glm::mat4> matrices(itemCount);
+    auto compose = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            matrices[i] = composeTransform(positions[i], rotations[i], glm::vec3(1.0f));
+        }
+    };
+
+    std::cout << "\t[+] Job scaling, " << itemCount << " transforms (ms per pass)" << std::endl
+              << "\t\tThreads     Time      Speedup" << std::endl;
+
+    // Powers of two, then the full width when the core count is not one
+    const size_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    double baseline = 0.0;
+    for (size_t threads : threadCounts)
+    {
+        JobSystem jobs(threads - 1);
+        double time = measureMilliseconds([&](void) {
+            JobCounter counter;
+            jobs.parallelFor(itemCount, ENTITY_BATCH_SIZE, compose, counter);
+            jobs.wait(counter);
+        },
+                                          iterations);
+        baseline = threads == 1 ? time : baseline;
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "\t\t" << std::left << std::setw(12) << threads << std::setw(10) << time
+                  << std::setprecision(2) << baseline / time << "x" << std::right << std::endl;
+    }
+    return;
+}
+
+void benchmarkBatchMath(size_t transformCount)
+{
+    const int iterations = 20;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+    std::vector<glm::vec3> positions(transformCount);
+    std::vector<glm::quat> rotations(transformCount);
+    std::vector<glm::vec3> scales(transformCount);
+    for (size_t i = 0; i < transformCount; i++)
+    {
+        positions[i] = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+        rotations[i] = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+        scales[i] = glm::vec3(size(random), size(random), size(random));
+    }
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+                               glm::lookAt(glm::vec3(0.0f, -3.0f, -8.0f), glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+
+    std::vector<glm::mat4> models(transformCount);
+    std::vector<glm::mat4> parents(transformCount);
+    std::vector<glm::mat4> expected(transformCount);
+    std::vector<glm::mat4> results(transformCount);
+
+    // Each kernel's per element glm baseline, then the batch call
+    struct Kernel
+    {
+        const char *name;
+        std::function<void(void)> element;
+        std::function<void(void)> batch;
+    };
+    std::vector<Kernel> kernels = {
+        {"Compose",
+         [&](void) {
+             for (size_t i = 0; i < transformCount; i++)
+             {
+                 expected[i] = glm::translate(glm::mat4(1.0f), positions[i]) *
+                               glm::mat4_cast(rotations[i]) *
+                               glm::scale(glm::mat4(1.0f), scales[i]);
+             }
+         },
+         [&](void) { composeTransforms(positions.data(), rotations.data(), scales.data(), results.data(), transformCount); }},
+        {"Multiply",
+         [&](void) {
+             for (size_t i = 0; i < transformCount; i++)
+             {
+                 expected[i] = parents[i] * models[i];
+             }
+         },
+         [&](void) { multiplyMatrices(parents.data(), models.data(), results.data(), transformCount); }},
+        {"ViewProj",
+         [&](void) {
+             for (size_t i = 0; i < transformCount; i++)
+             {
+                 expected[i] = viewProjection * models[i];
+             }
+         },
+         [&](void) { multiplyMatrices(viewProjection, models.data(), results.data(), transformCount); }}};
+
+    std::vector<BatchMathPath> paths;
+    for (BatchMathPath path : {BatchMathPath::Scalar, BatchMathPath::SSE, BatchMathPath::AVX2, BatchMathPath::NEON})
+    {
+        if (isBatchMathPathSupported(path))
+        {
+            paths.push_back(path);
+        }
+    }
+
+    const BatchMathPath detected = getBatchMathPath();
+    std::cout << "\t[+] Batch math, " << transformCount << " transforms, "
+              << getBatchMathPathName(detected) << " picked (ms per pass)" << std::endl
+              << "\t\tKernel      glm       ";
+    for (BatchMathPath path : paths)
+    {
+        std::cout << std::left << std::setw(10) << getBatchMathPathName(path) << std::right;
+    }
+    std::cout << std::endl;
+
+    composeTransforms(positions.data(), rotations.data(), scales.data(), models.data(), transformCount);
+    std::rotate_copy(models.begin(), models.begin() + 1, models.end(), parents.begin());
+
+    for (const auto &kernel : kernels)
+    {
+        double element = measureMilliseconds(kernel.element, iterations);
+        std::cout << std::fixed << std::setprecision(3)
+                  << "\t\t" << std::left << std::setw(12) << kernel.name << std::setw(10) << element;
+
+        float worstError = 0.0f;
+        for (BatchMathPath path : paths)
+        {
+            setBatchMathPath(path);
+            std::cout << std::setw(10) << measureMilliseconds(kernel.batch, iterations);
+            for (size_t i = 0; i < transformCount; i++)
+            {
+                for (int column = 0; column < 4; column++)
+                {
+                    glm::vec4 difference = glm::abs(results[i][column] - expected[i][column]);
+                    worstError = std::max({worstError, difference.x, difference.y, difference.z, difference.w});
+                }
+            }
+        }
+        std::cout << std::right << std::endl;
+
+        // Paths differ from glm only by rounding and FMA contraction
+        if (worstError > 1e-3f)
+        {
+            std::cout << "\t[-] Self check : " << kernel.name << " off by " << worstError << std::endl;
+        }
+    }
+    setBatchMathPath(detected);
+    return;
+}
+
+void benchmarkDrawDataRecording(size_t drawCount)
+{
+    const int iterations = 200;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<DrawConstants> draws(drawCount);
+    for (size_t i = 0; i < drawCount; i++)
+    {
+        draws[i].model = glm::translate(glm::mat4(1.0f), glm::vec3(unit(random), unit(random), unit(random)) * 100.0f);
+        draws[i].textureIndex = static_cast<uint32_t>(i % 64);
+    }
+
+    // What recording leaves behind, a command stream of tokens and the mapped slots
+    struct Token
+    {
+        uint32_t type;
+        uint32_t value;
+    };
+    std::vector<char> stream(drawCount * (sizeof(Token) * 2 + sizeof(DrawConstants)));
+    std::vector<char> slots(drawCount * 256);
+    size_t checksum = 0;
+
+    auto pushConstants = [&](void) {
+        char *out = stream.data();
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            Token push = {1, sizeof(DrawConstants)};
+            memcpy(out, &push, sizeof(push));
+            memcpy(out + sizeof(push), &draws[i], sizeof(DrawConstants));
+            out += sizeof(push) + sizeof(DrawConstants);
+        }
+        checksum += static_cast<size_t>(out - stream.data());
+    };
+    auto dynamicUniform = [&](size_t stride) {
+        char *out = stream.data();
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            memcpy(slots.data() + i * stride, &draws[i], sizeof(DrawConstants));
+            Token bind = {2, static_cast<uint32_t>(i * stride)};
+            memcpy(out, &bind, sizeof(bind));
+            out += sizeof(bind);
+        }
+        checksum += static_cast<size_t>(out - stream.data());
+    };
+    auto instanceTable = [&](void) {
+        char *out = stream.data();
+        for (size_t i = 0; i < drawCount; i++)
+        {
+            memcpy(slots.data() + i * sizeof(DrawConstants), &draws[i], sizeof(DrawConstants));
+            Token draw = {3, static_cast<uint32_t>(i)};
+            memcpy(out, &draw, sizeof(draw));
+            out += sizeof(draw);
+        }
+        checksum += static_cast<size_t>(out - stream.data());
+    };
+
+    std::cout << "\t[+] Draw data recording on the CPU, " << drawCount << " draws of " << sizeof(DrawConstants)
+              << " bytes (ns per draw)" << std::endl
+              << "\t\tNot a per device result, the engine's draw data tuner times the paths on the GPU" << std::endl
+              << "\t\tPath        Stride    Time" << std::endl;
+
+    struct Row
+    {
+        DrawDataPath path;
+        size_t stride;
+        std::function<void(void)> job;
+    };
+    std::vector<Row> rows = {
+        {DrawDataPath::PushConstants, sizeof(DrawConstants), pushConstants},
+        {DrawDataPath::DynamicUniform, 128, [&](void) { dynamicUniform(128); }},
+        {DrawDataPath::DynamicUniform, 256, [&](void) { dynamicUniform(256); }},
+        {DrawDataPath::InstanceTable, sizeof(DrawConstants), instanceTable}};
+
+    for (const auto &row : rows)
+    {
+        double time = measureMilliseconds(row.job, iterations);
+        std::cout << std::fixed << std::setprecision(2)
+                  << "\t\t" << std::left << std::setw(12) << getDrawDataPathName(row.path)
+                  << std::setw(10) << row.stride << time * 1000000.0 / drawCount << std::right << std::endl;
+    }
+
+    if (checksum == 0)
+    {
+        std::cout << "\t[-] Self check : nothing was recorded" << std::endl;
+    }
+    return;
+}
+
+void benchmarkMeshlets(uint32_t gridSize)
+{
+    const int iterations = 20;
+    const float size = static_cast<float>(gridSize);
+
+    // Flat on z = 0 and facing +z under the pipeline's clockwise front face
+    std::vector<Vertex> vertices;
+    std::vector<uint16_t> indices;
+    vertices.reserve(static_cast<size_t>(gridSize + 1) * (gridSize + 1));
+    for (uint32_t y = 0; y <= gridSize; y++)
+    {
+        for (uint32_t x = 0; x <= gridSize; x++)
+        {
+            vertices.push_back({glm::vec4(static_cast<float>(x) - size * 0.5f, static_cast<float>(y) - size * 0.5f, 0.0f, 1.0f),
+                                glm::vec4(1.0f)});
+        }
+    }
+    if (vertices.size() > UINT16_MAX + 1)
+    {
+        std::cout << "\t[-] Self check : Meshlet grid of " << gridSize << " needs 32 bit indices" << std::endl;
+        return;
+    }
+    for (uint32_t y = 0; y < gridSize; y++)
+    {
+        for (uint32_t x = 0; x < gridSize; x++)
+        {
+            uint16_t corner = static_cast<uint16_t>(y * (gridSize + 1) + x);
+            uint16_t right = static_cast<uint16_t>(corner + 1);
+            uint16_t up = static_cast<uint16_t>(corner + gridSize + 1);
+            uint16_t across = static_cast<uint16_t>(up + 1);
+            indices.insert(indices.end(), {corner, up, right, right, up, across});
+        }
+    }
+    const size_t triangleCount = indices.size() / 3;
+
+    MeshletData meshlets;
+    bool built = true;
+    double buildTime = measureMilliseconds([&](void) { built = buildMeshlets(vertices, indices, meshlets); }, iterations);
+    if (!built || !validateMeshletCoverage(indices, meshlets))
+    {
+        std::cout << "\t[-] Self check : Meshlets of the grid do not match it" << std::endl;
+        return;
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "\t[+] Meshlets, " << triangleCount << " triangles in " << meshlets.meshlets.size()
+              << " meshlets, built in " << buildTime << " ms" << std::endl
+              << "\t\tView        Ranges    Triangles   Time (ms)" << std::endl;
+
+    struct View
+    {
+        const char *name;
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+    const std::vector<View> views = {
+        {"Front", glm::vec3(0.0f, 0.0f, size * 2.0f), glm::vec3(0.0f)},
+        {"Behind", glm::vec3(0.0f, 0.0f, -size * 2.0f), glm::vec3(0.0f)},
+        {"Close", glm::vec3(-size * 0.25f, -size * 0.25f, size * 0.125f), glm::vec3(-size * 0.25f, -size * 0.25f, 0.0f)}};
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, size * 10.0f);
+    for (const auto &view : views)
+    {
+        glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+        Frustum frustum = Frustum::fromMatrix(projection * glm::lookAt(view.eye, view.target, up));
+
+        std::vector<MeshletDrawRange> ranges;
+        double time = measureMilliseconds([&](void) {
+            ranges.clear();
+            cullMeshlets(meshlets, glm::mat4(1.0f), frustum, view.eye, ranges);
+        },
+                                          iterations);
+
+        std::vector<bool> drawn(triangleCount, false);
+        size_t drawnCount = 0;
+        for (const auto &range : ranges)
+        {
+            for (uint32_t i = range.firstIndex / 3; i < (range.firstIndex + range.indexCount) / 3; i++)
+            {
+                drawn[i] = true;
+            }
+            drawnCount += range.indexCount / 3;
+        }
+
+        // Culling may keep hidden triangles but must never drop one in view
+        size_t missing = 0;
+        size_t inView = 0;
+        for (size_t i = 0; i < triangleCount; i++)
+        {
+            glm::vec3 centroid = (glm::vec3(vertices[meshlets.indices[i * 3]].pos) +
+                                  glm::vec3(vertices[meshlets.indices[i * 3 + 1]].pos) +
+                                  glm::vec3(vertices[meshlets.indices[i * 3 + 2]].pos)) /
+                                 3.0f;
+            if (view.eye.z > 0.0f && frustum.intersectsSphere(centroid, 0.0f))
+            {
+                inView++;
+                missing += drawn[i] ? 0 : 1;
+            }
+        }
+        if (missing > 0)
+        {
+            std::cout << "\t[-] Self check : " << view.name << " culled " << missing << " triangles in view" << std::endl;
+        }
+        if (inView == 0 && drawnCount > 0)
+        {
+            std::cout << "\t[-] Self check : " << view.name << " drew " << drawnCount << " triangles facing away" << std::endl;
+        }
+        if (inView > 0 && inView < triangleCount && drawnCount == triangleCount)
+        {
+            std::cout << "\t[-] Self check : " << view.name << " culled nothing outside the frustum" << std::endl;
+        }
+
+        std::cout << "\t\t" << std::left << std::setw(12) << view.name << std::setw(10) << ranges.size()
+                  << std::setw(12) << drawnCount << std::right << time << std::endl;
+    }
+    return;
+}
@@ -0,0 +1,294 @@
+#include "BindlessDescriptors.h"
+
+#include <algorithm>
+#include <array>
+
+// Shaders may read any binding from any stage
+const VkShaderStageFlags BINDLESS_STAGES = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+const VkDescriptorBindingFlags BINDLESS_BINDING_FLAGS = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+BindlessDescriptors::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Bindless Descriptors Exception";
+    errorDescription = description;
+    return;
+}
+
+BindlessDescriptors::Exception::~Exception(void)
+{
+    return;
+}
+
+BindlessDescriptors::BindlessDescriptors(VkDevice device,
+                                         const VkPhysicalDeviceDescriptorIndexingProperties &limits,
+                                         uint32_t maxTextures,
+                                         uint32_t maxBuffers)
+    : device(device)
+{
+    textures.capacity = std::min({maxTextures,
+                                  limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                  limits.maxDescriptorSetUpdateAfterBindSampledImages});
+    buffers.capacity = std::min({maxBuffers,
+                                 limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                                 limits.maxDescriptorSetUpdateAfterBindStorageBuffers});
+    if (textures.capacity == 0 || buffers.capacity == 0)
+    {
+        BD_EXCEPT("Device allows no update-after-bind textures or storage buffers");
+    }
+
+    std::cout << "[+] Creating bindless set with " << textures.capacity << " textures and "
+              << buffers.capacity << " buffers" << std::endl;
+    createLayout();
+    createSet();
+    return;
+}
+
+BindlessDescriptors::~BindlessDescriptors(void)
+{
+    cleanup();
+    return;
+}
+
+bool BindlessDescriptors::isSupported(const VkPhysicalDeviceDescriptorIndexingFeatures &features)
+{
+    return features.runtimeDescriptorArray &&
+           features.descriptorBindingPartiallyBound &&
+           features.descriptorBindingUpdateUnusedWhilePending &&
+           features.descriptorBindingSampledImageUpdateAfterBind &&
+           features.descriptorBindingStorageBufferUpdateAfterBind &&
+           features.shaderSampledImageArrayNonUniformIndexing &&
+           features.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+void BindlessDescriptors::createLayout(void)
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = BINDLESS_TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = textures.capacity;
+    bindings[0].stageFlags = BINDLESS_STAGES;
+    bindings[0].pImmutableSamplers = nullptr;
+
+    bindings[1].binding = BINDLESS_BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = buffers.capacity;
+    bindings[1].stageFlags = BINDLESS_STAGES;
+    bindings[1].pImmutableSamplers = nullptr;
+
+    std::array<VkDescriptorBindingFlags, 2> bindingFlags = {BINDLESS_BINDING_FLAGS, BINDLESS_BINDING_FLAGS};
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.pNext = nullptr;
+    flagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    flagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        BD_EXCEPT("Failed to create bindless descriptor layout");
+    }
+    return;
+}
+
+void BindlessDescriptors::createSet(void)
+{
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = textures.capacity;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = buffers.capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        BD_EXCEPT("Failed to create bindless descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS)
+    {
+        BD_EXCEPT("Failed to allocate bindless descriptor set");
+    }
+    return;
+}
+
+uint32_t BindlessDescriptors::SlotArray::acquire(void)
+{
+    if (!freeSlots.empty())
+    {
+        uint32_t index = freeSlots.back();
+        freeSlots.pop_back();
+        return index;
+    }
+    if (next < capacity)
+    {
+        return next++;
+    }
+    return BINDLESS_INVALID_INDEX;
+}
+
+void BindlessDescriptors::SlotArray::release(uint32_t index, uint64_t frame)
+{
+    if (index >= next)
+    {
+        return;
+    }
+    retired.push_back({index, frame});
+    return;
+}
+
+void BindlessDescriptors::SlotArray::recycle(uint64_t completedFrame)
+{
+    // Retired in frame order, the oldest are at the front
+    size_t count = 0;
+    while (count < retired.size() && retired[count].second <= completedFrame)
+    {
+        freeSlots.push_back(retired[count].first);
+        count++;
+    }
+    retired.erase(retired.begin(), retired.begin() + count);
+    return;
+}
+
+uint32_t BindlessDescriptors::addTexture(VkImageView view, VkSampler sampler)
+{
+    uint32_t index = textures.acquire();
+    if (index == BINDLESS_INVALID_INDEX)
+    {
+        return index;
+    }
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = view;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = BINDLESS_TEXTURE_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+    write.pBufferInfo = nullptr;
+    write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return index;
+}
+
+uint32_t BindlessDescriptors::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    uint32_t index = buffers.acquire();
+    if (index == BINDLESS_INVALID_INDEX)
+    {
+        return index;
+    }
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = BINDLESS_BUFFER_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = &bufferInfo;
+    write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return index;
+}
+
+// The descriptor is left in place, partially bound slots are never read once nothing indexes them
+void BindlessDescriptors::removeTexture(uint32_t index)
+{
+    textures.release(index, frame);
+    return;
+}
+
+void BindlessDescriptors::removeBuffer(uint32_t index)
+{
+    buffers.release(index, frame);
+    return;
+}
+
+void BindlessDescriptors::advanceFrame(void)
+{
+    const uint64_t framesInFlight = static_cast<uint64_t>(MAX_FRAMES_IN_FLIGHT);
+    frame++;
+    if (frame < framesInFlight)
+    {
+        return;
+    }
+    textures.recycle(frame - framesInFlight);
+    buffers.recycle(frame - framesInFlight);
+    return;
+}
+
+VkDescriptorSetLayout BindlessDescriptors::getLayout(void) const
+{
+    return layout;
+}
+
+VkDescriptorSet BindlessDescriptors::getSet(void) const
+{
+    return set;
+}
+
+uint32_t BindlessDescriptors::getTextureCapacity(void) const
+{
+    return textures.capacity;
+}
+
+uint32_t BindlessDescriptors::getBufferCapacity(void) const
+{
+    return buffers.capacity;
+}
+
+void BindlessDescriptors::cleanup(void)
+{
+    // Destroying the pool frees the set
+    if (pool != nullptr)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+        pool = nullptr;
+        set = nullptr;
+    }
+    if (layout != nullptr)
+    {
+        vkDestroyDescriptorSetLayout(device, layout, nullptr);
+        layout = nullptr;
+    }
+    return;
+}
@@ -1,14 +1,19 @@
 #include "Camera.h"
 
+#include <algorithm>
+#include <cmath>
+
 Camera::Camera(int extentWidth, int extentHeight)
-    : viewWidth(extentWidth), viewHeight(extentHeight)
+    : aspectRatio(static_cast<float>(extentWidth) / static_cast<float>(std::max(extentHeight, 1)))
 {
     viewMatrix = glm::mat4(1.0);
     projMatrix = glm::mat4(1.0);
+    viewProjMatrix = glm::mat4(1.0);
 
-    lookAt = DEFAULT_FORWARD_VECTOR;
+    forward = DEFAULT_FORWARD_VECTOR;
 
     position = {0.0f, -3.0f, -8.0f};
+    update();
     return;
 }
 
@@ -17,54 +22,159 @@ Camera::~Camera(void)
     return;
 }
 
+void Camera::moveForward(float deltaTime)
+{
+    position += forward * MOVE_SPEED * deltaTime;
+    viewDirty = true;
+    return;
+}
 
-void Camera::moveForward(void)
+void Camera::moveBackward(float deltaTime)
 {
-    position.z += 0.2f;
+    position -= forward * MOVE_SPEED * deltaTime;
+    viewDirty = true;
     return;
 }
 
-void Camera::moveBackward(void)
+void Camera::moveLeft(float deltaTime)
 {
-    position.z -= 0.2f;
+    position -= glm::normalize(glm::cross(forward, DEFAULT_UP_VECTOR)) * MOVE_SPEED * deltaTime;
+    viewDirty = true;
     return;
 }
 
-void Camera::moveLeft(void)
+void Camera::moveRight(float deltaTime)
 {
-    position.x -= 0.2f;
+    position += glm::normalize(glm::cross(forward, DEFAULT_UP_VECTOR)) * MOVE_SPEED * deltaTime;
+    viewDirty = true;
     return;
 }
 
-void Camera::moveRight(void)
+void Camera::moveUp(float deltaTime)
 {
-    position.x += 0.2f;
+    position += DEFAULT_UP_VECTOR * MOVE_SPEED * deltaTime;
+    viewDirty = true;
     return;
 }
 
-void Camera::moveUp(void)
+void Camera::moveDown(float deltaTime)
 {
-    position.y -= 0.2f;
+    position += DEFAULT_DOWN_VECTOR * MOVE_SPEED * deltaTime;
+    viewDirty = true;
     return;
 }
 
-void Camera::moveDown(void)
+void Camera::rotate(glm::vec3 rotateBy)
 {
-    position.y += 0.2f;
+    if (rotateBy.x == 0.0f && rotateBy.y == 0.0f)
+    {
+        return;
+    }
+    pitch = std::clamp(pitch + rotateBy.x, -MAX_PITCH, MAX_PITCH);
+    yaw = std::fmod(yaw + rotateBy.y, 360.0f);
+
+    // Pitching up looks towards the world up vector, which points along -y
+    float pitchRadians = glm::radians(pitch);
+    float yawRadians = glm::radians(yaw);
+    forward = glm::vec3(std::cos(pitchRadians) * std::sin(yawRadians),
+                        -std::sin(pitchRadians),
+                        std::cos(pitchRadians) * std::cos(yawRadians));
+    viewDirty = true;
     return;
 }
 
-void Camera::update(void)
+void Camera::setAspectRatio(float ratio)
 {
+    if (ratio == aspectRatio || !(ratio > 0.0f))
+    {
+        return;
+    }
+    aspectRatio = ratio;
+    projectionDirty = true;
     return;
 }
 
-void Camera::rotate(glm::vec3 rotateBy)
+void Camera::setReverseZ(bool enabled)
 {
+    if (enabled == reverseZ)
+    {
+        return;
+    }
+    reverseZ = enabled;
+    projectionDirty = true;
     return;
 }
 
-glm::vec3 Camera::getPosition(void)
+bool Camera::update(void)
+{
+    if (!viewDirty && !projectionDirty)
+    {
+        return false;
+    }
+
+    if (viewDirty)
+    {
+        viewMatrix = glm::lookAt(position, position + forward, DEFAULT_UP_VECTOR);
+    }
+
+    if (projectionDirty)
+    {
+        if (reverseZ)
+        {
+            // clip z is nearZ and clip w is -z, depth = nearZ / distance
+            float focalLength = 1.0f / std::tan(fovRadians * 0.5f);
+            projMatrix = glm::mat4(0.0f);
+            projMatrix[0][0] = focalLength / aspectRatio;
+            projMatrix[1][1] = focalLength;
+            projMatrix[2][3] = -1.0f;
+            projMatrix[3][2] = nearZ;
+        }
+        else
+        {
+            projMatrix = glm::perspective(fovRadians, aspectRatio, nearZ, farZ);
+        }
+        // Vulkan's clip space y points down
+        projMatrix[1][1] *= -1;
+    }
+
+    viewProjMatrix = projMatrix * viewMatrix;
+    frustum = Frustum::fromMatrix(viewProjMatrix);
+    viewDirty = false;
+    projectionDirty = false;
+    return true;
+}
+
+glm::vec3 Camera::getPosition(void) const
 {
     return position;
-}
\ No newline at end of file
+}
+
+glm::vec3 Camera::getForward(void) const
+{
+    return forward;
+}
+
+bool Camera::isReverseZ(void) const
+{
+    return reverseZ;
+}
+
+const glm::mat4 &Camera::getView(void) const
+{
+    return viewMatrix;
+}
+
+const glm::mat4 &Camera::getProjection(void) const
+{
+    return projMatrix;
+}
+
+const glm::mat4 &Camera::getViewProjection(void) const
+{
+    return viewProjMatrix;
+}
+
+const Frustum &Camera::getFrustum(void) const
+{
+    return frustum;
+}
@@ -0,0 +1,299 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <array>
+
+/*
+    Descriptors of each type a pool holds per set it can allocate,
+    generous for uniform buffers which most sets are made of
+*/
+const std::array<std::pair<VkDescriptorType, float>, 7> DESCRIPTOR_POOL_RATIOS = {{
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+}};
+
+DescriptorAllocator::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Descriptor Allocator Exception";
+    errorDescription = description;
+    return;
+}
+
+DescriptorAllocator::Exception::~Exception(void)
+{
+    return;
+}
+
+DescriptorWrite DescriptorWrite::forBuffer(uint32_t binding,
+                                           VkDescriptorType type,
+                                           VkBuffer buffer,
+                                           VkDeviceSize offset,
+                                           VkDeviceSize range)
+{
+    DescriptorWrite write;
+    write.binding = binding;
+    write.type = type;
+    write.buffer.buffer = buffer;
+    write.buffer.offset = offset;
+    write.buffer.range = range;
+    return write;
+}
+
+DescriptorWrite DescriptorWrite::forImage(uint32_t binding,
+                                          VkDescriptorType type,
+                                          VkImageView view,
+                                          VkSampler sampler,
+                                          VkImageLayout layout)
+{
+    DescriptorWrite write;
+    write.binding = binding;
+    write.type = type;
+    write.image.imageView = view;
+    write.image.sampler = sampler;
+    write.image.imageLayout = layout;
+    return write;
+}
+
+bool DescriptorWrite::operator==(const DescriptorWrite &other) const
+{
+    return binding == other.binding &&
+           type == other.type &&
+           buffer.buffer == other.buffer.buffer &&
+           buffer.offset == other.buffer.offset &&
+           buffer.range == other.buffer.range &&
+           image.imageView == other.image.imageView &&
+           image.sampler == other.image.sampler &&
+           image.imageLayout == other.image.imageLayout;
+}
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device)
+    : device(device)
+{
+    return;
+}
+
+DescriptorAllocator::~DescriptorAllocator(void)
+{
+    cleanup();
+    return;
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets)
+{
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (const auto &[type, ratio] : DESCRIPTOR_POOL_RATIOS)
+    {
+        sizes.push_back({type, static_cast<uint32_t>(ratio * maxSets)});
+    }
+
+    // Sets are never freed one by one, pools are reset whole
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = 0;
+    poolInfo.maxSets = maxSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    poolInfo.pPoolSizes = sizes.data();
+
+    VkDescriptorPool pool = nullptr;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        DA_EXCEPT("Failed to create descriptor pool");
+    }
+    return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::allocateFrom(PoolChain &chain, VkDescriptorSetLayout layout)
+{
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    // A full pool stays full until reset, later allocations start past it
+    while (true)
+    {
+        bool created = false;
+        if (chain.current == chain.pools.size())
+        {
+            uint32_t maxSets = std::min(DESCRIPTOR_SETS_PER_POOL << std::min<size_t>(chain.pools.size(), 16),
+                                        DESCRIPTOR_MAX_SETS_PER_POOL);
+            chain.pools.push_back(createPool(maxSets));
+            created = true;
+        }
+
+        allocInfo.descriptorPool = chain.pools[chain.current];
+        VkDescriptorSet set = nullptr;
+        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+        if (result == VK_SUCCESS)
+        {
+            return set;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+        {
+            DA_EXCEPT("Failed to allocate descriptor set");
+        }
+        // An empty pool that cannot hold the set never will
+        if (created)
+        {
+            DA_EXCEPT("Descriptor set does not fit an empty pool");
+        }
+        chain.current++;
+    }
+}
+
+void DescriptorAllocator::resetChain(PoolChain &chain)
+{
+    for (size_t i = 0; i < chain.pools.size() && i <= chain.current; i++)
+    {
+        vkResetDescriptorPool(device, chain.pools[i], 0);
+    }
+    chain.current = 0;
+    return;
+}
+
+void DescriptorAllocator::destroyChain(PoolChain &chain)
+{
+    for (auto &pool : chain.pools)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    chain.pools.clear();
+    chain.current = 0;
+    return;
+}
+
+void DescriptorAllocator::beginFrame(uint32_t frame)
+{
+    if (frame >= frames.size())
+    {
+        frames.resize(frame + 1);
+    }
+    currentFrame = frame;
+
+    // Cached sets go with the pools, the buckets are kept
+    resetChain(frames[frame].chain);
+    for (auto &entry : frames[frame].cache)
+    {
+        entry.second.clear();
+    }
+    return;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+    if (currentFrame >= frames.size())
+    {
+        DA_EXCEPT("Descriptor set requested before beginFrame");
+    }
+    return allocateFrom(frames[currentFrame].chain, layout);
+}
+
+VkDescriptorSet DescriptorAllocator::getSet(VkDescriptorSetLayout layout, const std::vector<DescriptorWrite> &writes)
+{
+    if (currentFrame >= frames.size())
+    {
+        DA_EXCEPT("Descriptor set requested before beginFrame");
+    }
+    Frame &frame = frames[currentFrame];
+
+    uint64_t hash = hashWrites(layout, writes);
+    std::vector<CachedSet> &bucket = frame.cache[hash];
+    for (const auto &cached : bucket)
+    {
+        if (cached.layout == layout && cached.writes == writes)
+        {
+            return cached.set;
+        }
+    }
+
+    VkDescriptorSet set = allocateFrom(frame.chain, layout);
+
+    std::vector<VkWriteDescriptorSet> descriptorWrites(writes.size());
+    for (size_t i = 0; i < writes.size(); i++)
+    {
+        bool isImage = writes[i].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+                       writes[i].type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+                       writes[i].type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+                       writes[i].type == VK_DESCRIPTOR_TYPE_SAMPLER;
+
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].pNext = nullptr;
+        descriptorWrites[i].dstSet = set;
+        descriptorWrites[i].dstBinding = writes[i].binding;
+        descriptorWrites[i].dstArrayElement = 0;
+        descriptorWrites[i].descriptorType = writes[i].type;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].pBufferInfo = isImage ? nullptr : &writes[i].buffer;
+        descriptorWrites[i].pImageInfo = isImage ? &writes[i].image : nullptr;
+        descriptorWrites[i].pTexelBufferView = nullptr;
+    }
+    vkUpdateDescriptorSets(device,
+                           static_cast<uint32_t>(descriptorWrites.size()),
+                           descriptorWrites.data(),
+                           0,
+                           nullptr);
+
+    bucket.push_back({layout, writes, set});
+    return set;
+}
+
+VkDescriptorSet DescriptorAllocator::allocatePersistent(VkDescriptorSetLayout layout)
+{
+    return allocateFrom(persistent, layout);
+}
+
+size_t DescriptorAllocator::getPoolCount(void) const
+{
+    size_t count = persistent.pools.size();
+    for (const auto &frame : frames)
+    {
+        count += frame.chain.pools.size();
+    }
+    return count;
+}
+
+// FNV-1a over the handles and ranges, collisions are resolved by comparing writes
+uint64_t DescriptorAllocator::hashWrites(VkDescriptorSetLayout layout, const std::vector<DescriptorWrite> &writes)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; i++)
+        {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    mix(reinterpret_cast<uint64_t>(layout));
+    for (const auto &write : writes)
+    {
+        mix(write.binding);
+        mix(static_cast<uint64_t>(write.type));
+        mix(reinterpret_cast<uint64_t>(write.buffer.buffer));
+        mix(write.buffer.offset);
+        mix(write.buffer.range);
+        mix(reinterpret_cast<uint64_t>(write.image.imageView));
+        mix(reinterpret_cast<uint64_t>(write.image.sampler));
+        mix(static_cast<uint64_t>(write.image.imageLayout));
+    }
+    return hash;
+}
+
+void DescriptorAllocator::cleanup(void)
+{
+    for (auto &frame : frames)
+    {
+        destroyChain(frame.chain);
+    }
+    frames.clear();
+    destroyChain(persistent);
+    return;
+}
@@ -0,0 +1,121 @@
+#include "DescriptorLayoutCache.h"
+
+#include <algorithm>
+
+DescriptorLayoutCache::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Descriptor Layout Cache Exception";
+    errorDescription = description;
+    return;
+}
+
+DescriptorLayoutCache::Exception::~Exception(void)
+{
+    return;
+}
+
+DescriptorLayoutCache::DescriptorLayoutCache(VkDevice device)
+    : device(device)
+{
+    return;
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache(void)
+{
+    cleanup();
+    return;
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::getLayout(std::vector<VkDescriptorSetLayoutBinding> bindings)
+{
+    // Binding order does not change the layout, sorted copies compare equal
+    std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+              { return a.binding < b.binding; });
+    for (const auto &binding : bindings)
+    {
+        if (binding.pImmutableSamplers != nullptr)
+        {
+            LC_EXCEPT("Cached layouts cannot hold immutable samplers");
+        }
+    }
+
+    std::vector<CachedLayout> &bucket = layouts[hashBindings(bindings)];
+    for (const auto &cached : bucket)
+    {
+        if (sameBindings(cached.bindings, bindings))
+        {
+            return cached.layout;
+        }
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = nullptr;
+    layoutInfo.flags = 0;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout = nullptr;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        LC_EXCEPT("Failed to create descriptor set layout");
+    }
+    bucket.push_back({std::move(bindings), layout});
+    count++;
+    return layout;
+}
+
+size_t DescriptorLayoutCache::size(void) const
+{
+    return count;
+}
+
+// FNV-1a over every field that changes the layout
+uint64_t DescriptorLayoutCache::hashBindings(const std::vector<VkDescriptorSetLayoutBinding> &bindings)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; i++)
+        {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    for (const auto &binding : bindings)
+    {
+        mix(binding.binding);
+        mix(static_cast<uint64_t>(binding.descriptorType));
+        mix(binding.descriptorCount);
+        mix(binding.stageFlags);
+    }
+    return hash;
+}
+
+bool DescriptorLayoutCache::sameBindings(const std::vector<VkDescriptorSetLayoutBinding> &a,
+                                         const std::vector<VkDescriptorSetLayoutBinding> &b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const VkDescriptorSetLayoutBinding &x, const VkDescriptorSetLayoutBinding &y)
+                      {
+                          return x.binding == y.binding &&
+                                 x.descriptorType == y.descriptorType &&
+                                 x.descriptorCount == y.descriptorCount &&
+                                 x.stageFlags == y.stageFlags;
+                      });
+}
+
+void DescriptorLayoutCache::cleanup(void)
+{
+    for (auto &bucket : layouts)
+    {
+        for (auto &cached : bucket.second)
+        {
+            vkDestroyDescriptorSetLayout(device, cached.layout, nullptr);
+        }
+    }
+    layouts.clear();
+    count = 0;
+    return;
+}
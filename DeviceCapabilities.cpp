@@ -0,0 +1,246 @@
+#include "DeviceCapabilities.h"
+
+#include "BindlessDescriptors.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+bool DeviceCapabilities::hasExtension(const char *extension) const
+{
+    return std::binary_search(extensions.begin(), extensions.end(), std::string(extension));
+}
+
+bool DeviceCapabilities::isSoftware(void) const
+{
+    return type == VK_PHYSICAL_DEVICE_TYPE_CPU;
+}
+
+DeviceCapabilities probeDevice(const DEVICEINFO &device)
+{
+    DeviceCapabilities capabilities;
+    const VkPhysicalDeviceProperties &properties = device.devProperties.properties;
+    capabilities.name = properties.deviceName;
+    capabilities.type = properties.deviceType;
+    capabilities.apiVersion = properties.apiVersion;
+    capabilities.driverVersion = properties.driverVersion;
+    capabilities.vendorID = properties.vendorID;
+    capabilities.deviceID = properties.deviceID;
+    std::copy(std::begin(device.idProperties.deviceUUID), std::end(device.idProperties.deviceUUID), capabilities.uuid.begin());
+    capabilities.limits = properties.limits;
+
+    // Heaps are flagged through the types that live on them
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    vkGetPhysicalDeviceMemoryProperties(device.devHandle, &memoryProperties);
+    capabilities.heaps.resize(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+    {
+        capabilities.heaps[i].size = memoryProperties.memoryHeaps[i].size;
+        capabilities.heaps[i].deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    }
+    const VkMemoryPropertyFlags direct = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        if ((memoryProperties.memoryTypes[i].propertyFlags & direct) == direct)
+        {
+            capabilities.heaps[memoryProperties.memoryTypes[i].heapIndex].hostVisibleDeviceLocal = true;
+        }
+    }
+    for (const auto &heap : capabilities.heaps)
+    {
+        if (heap.deviceLocal)
+        {
+            capabilities.deviceLocalSize = std::max(capabilities.deviceLocalSize, heap.size);
+        }
+        if (heap.hostVisibleDeviceLocal)
+        {
+            capabilities.hostVisibleDeviceLocalSize = std::max(capabilities.hostVisibleDeviceLocalSize, heap.size);
+        }
+    }
+    capabilities.resizableBar = capabilities.hostVisibleDeviceLocalSize > RESIZABLE_BAR_MIN_SIZE &&
+                                capabilities.hostVisibleDeviceLocalSize >= capabilities.deviceLocalSize;
+
+    // The first family with graphics, the renderer submits everything to one queue
+    capabilities.queueFamilies = device.queueFamiles;
+    for (uint32_t i = 0; i < capabilities.queueFamilies.size(); i++)
+    {
+        if (capabilities.queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            capabilities.graphicsFamily = i;
+            capabilities.graphicsTimestamps = capabilities.queueFamilies[i].timestampValidBits > 0 &&
+                                              properties.limits.timestampPeriod > 0.0f;
+            break;
+        }
+    }
+
+    uint32_t extensionCount = 0;
+    std::vector<VkExtensionProperties> extensions;
+    if (vkEnumerateDeviceExtensionProperties(device.devHandle, nullptr, &extensionCount, nullptr) == VK_SUCCESS)
+    {
+        extensions.resize(extensionCount);
+        if (vkEnumerateDeviceExtensionProperties(device.devHandle, nullptr, &extensionCount, extensions.data()) != VK_SUCCESS)
+        {
+            extensions.clear();
+        }
+    }
+    for (const auto &extension : extensions)
+    {
+        capabilities.extensions.push_back(extension.extensionName);
+    }
+    std::sort(capabilities.extensions.begin(), capabilities.extensions.end());
+
+    capabilities.extendedDynamicState = device.extendedFeatures.extendedDynamicState;
+    capabilities.bindless = BindlessDescriptors::isSupported(device.indexingFeatures);
+    capabilities.textureCompressionBC = device.devFeatures.features.textureCompressionBC;
+
+    // Only what the renderer uses, geometry shaders and the like are not
+    if (capabilities.apiVersion < VK_API_VERSION_1_2)
+    {
+        capabilities.missing.push_back("Vulkan 1.2");
+    }
+    if (capabilities.graphicsFamily == UINT32_MAX)
+    {
+        capabilities.missing.push_back("a graphics queue");
+    }
+    for (const auto &extension : requestedDeviceExtensions)
+    {
+        if (!capabilities.hasExtension(extension))
+        {
+            capabilities.missing.push_back(extension);
+        }
+    }
+    if (!capabilities.extendedDynamicState)
+    {
+        capabilities.missing.push_back("extended dynamic state");
+    }
+    if (!capabilities.bindless)
+    {
+        capabilities.missing.push_back("bindless descriptor indexing");
+    }
+
+    capabilities.score = scoreDevice(capabilities);
+    return capabilities;
+}
+
+int scoreDevice(const DeviceCapabilities &capabilities)
+{
+    if (!capabilities.missing.empty())
+    {
+        return 0;
+    }
+
+    // Software devices start at 1, still picked when nothing else can run the renderer
+    int score = 1;
+    switch (capabilities.type)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        score += 4000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        score += 2000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        score += 1000;
+        break;
+    default:
+        break;
+    }
+
+    // Room for geometry and textures, 100 a GiB up to 16 GiB
+    score += static_cast<int>(std::min<VkDeviceSize>(capabilities.deviceLocalSize >> 30, 16)) * 100;
+
+    // Uploads are written straight into video memory
+    if (capabilities.resizableBar && !capabilities.isSoftware())
+    {
+        score += 500;
+    }
+    // Compressed textures, else every texture is uploaded as RGBA8
+    if (capabilities.textureCompressionBC)
+    {
+        score += 250;
+    }
+    // The draw data tuner times paths on the GPU, else by recording time only
+    if (capabilities.graphicsTimestamps)
+    {
+        score += 100;
+    }
+    if (capabilities.limits.framebufferColorSampleCounts & capabilities.limits.framebufferDepthSampleCounts & MSAA_MAX_SAMPLES)
+    {
+        score += 100;
+    }
+    // Full bindless arrays, they are clamped to the limits otherwise
+    if (capabilities.limits.maxPerStageDescriptorSampledImages >= BINDLESS_MAX_TEXTURES)
+    {
+        score += 50;
+    }
+    return score;
+}
+
+const char *getDeviceTypeName(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return "software";
+    default:
+        return "other";
+    }
+}
+
+std::string formatDeviceUuid(const std::array<uint8_t, VK_UUID_SIZE> &uuid)
+{
+    std::string text;
+    char digits[3];
+    for (size_t i = 0; i < uuid.size(); i++)
+    {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+        {
+            text += '-';
+        }
+        snprintf(digits, sizeof(digits), "%02x", uuid[i]);
+        text += digits;
+    }
+    return text;
+}
+
+bool parseDeviceUuid(const std::string &text, std::array<uint8_t, VK_UUID_SIZE> &uuid)
+{
+    std::string digits;
+    for (char c : text)
+    {
+        if (c == '-')
+        {
+            continue;
+        }
+        if (!std::isxdigit(static_cast<unsigned char>(c)))
+        {
+            return false;
+        }
+        digits += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (digits.size() != 2 * VK_UUID_SIZE)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < uuid.size(); i++)
+    {
+        uuid[i] = static_cast<uint8_t>(std::stoul(digits.substr(2 * i, 2), nullptr, 16));
+    }
+    return true;
+}
+
+std::string getDeviceOverride(void)
+{
+    const char *environment = std::getenv(DEVICE_UUID_ENVIRONMENT);
+    if (environment != nullptr && environment[0] != '\0')
+    {
+        return environment;
+    }
+    return DEVICE_UUID_OVERRIDE;
+}
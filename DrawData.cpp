@@ -0,0 +1,215 @@
+#include "DrawData.h"
+
+#include <algorithm>
+#include <iomanip>
+
+const char *getDrawDataPathName(DrawDataPath path)
+{
+    switch (path)
+    {
+    case DrawDataPath::PushConstants:
+        return "Push";
+    case DrawDataPath::DynamicUniform:
+        return "DynamicUBO";
+    case DrawDataPath::InstanceTable:
+        return "SSBOTable";
+    default:
+        return "Unknown";
+    }
+}
+
+DrawDataTuner::DrawDataTuner(const VkPhysicalDeviceLimits &limits, uint32_t tuningFrames, bool gpuTimed)
+    : maxPushConstantsSize(limits.maxPushConstantsSize), tuningFrames(tuningFrames), gpuTimed(gpuTimed)
+{
+    VkDeviceSize alignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+    uniformStride = (sizeof(DrawConstants) + alignment - 1) / alignment * alignment;
+
+    // Every path binds or pushes whole DrawConstants, or a table of them
+    available[static_cast<uint32_t>(DrawDataPath::PushConstants)] = sizeof(DrawConstants) <= limits.maxPushConstantsSize;
+    available[static_cast<uint32_t>(DrawDataPath::DynamicUniform)] = sizeof(DrawConstants) <= limits.maxUniformBufferRange;
+    available[static_cast<uint32_t>(DrawDataPath::InstanceTable)] =
+        DRAW_DATA_MAX_DRAWS * sizeof(DrawConstants) <= limits.maxStorageBufferRange;
+
+    path = chooseByLimits();
+    tuning = tuningFrames > 0;
+    return;
+}
+
+DrawDataTuner::~DrawDataTuner(void)
+{
+    return;
+}
+
+void DrawDataTuner::disable(DrawDataPath path)
+{
+    available[static_cast<uint32_t>(path)] = false;
+    this->path = chooseByLimits();
+    return;
+}
+
+bool DrawDataTuner::isAvailable(DrawDataPath path) const
+{
+    return available[static_cast<uint32_t>(path)];
+}
+
+DrawDataPath DrawDataTuner::chooseByLimits(void) const
+{
+    // Nothing to write or bind per draw beats any buffer
+    if (isAvailable(DrawDataPath::PushConstants))
+    {
+        return DrawDataPath::PushConstants;
+    }
+    // One bind per command buffer instead of one per draw
+    if (isAvailable(DrawDataPath::InstanceTable))
+    {
+        return DrawDataPath::InstanceTable;
+    }
+    return DrawDataPath::DynamicUniform;
+}
+
+DrawDataFrame DrawDataTuner::beginFrame(void)
+{
+    DrawDataFrame current;
+    current.path = path;
+    if (!tuning)
+    {
+        return current;
+    }
+
+    // The schedule is fixed by the first frame, paths disabled after that are never run
+    if (frame == 0)
+    {
+        for (uint32_t i = 0; i < DRAW_DATA_PATH_COUNT; i++)
+        {
+            if (available[i])
+            {
+                schedule.push_back(static_cast<DrawDataPath>(i));
+            }
+        }
+        if (schedule.size() < 2)
+        {
+            tuning = false;
+            return current;
+        }
+        std::cout << "[+] Tuning draw data paths over " << tuningFrames << " frames each" << std::endl;
+    }
+
+    // Blocks of tuningFrames per path, then the default path while the last GPU times come back
+    uint32_t block = frame / tuningFrames;
+    if (block < schedule.size())
+    {
+        current.path = schedule[block];
+        current.measured = frame % tuningFrames >= std::min(DRAW_DATA_WARMUP_FRAMES, tuningFrames - 1);
+    }
+    else
+    {
+        // Samples that never come back, from frames dropped with a swapchain, stop waiting eventually
+        const uint32_t maxSettleFrames = 16;
+        if (pendingGpuSamples == 0 || frame >= schedule.size() * tuningFrames + maxSettleFrames)
+        {
+            finishTuning();
+            current.path = path;
+            return current;
+        }
+    }
+    frame++;
+    return current;
+}
+
+void DrawDataTuner::addCpuSample(const DrawDataFrame &frame, double milliseconds)
+{
+    if (!tuning || !frame.measured)
+    {
+        return;
+    }
+    PathTimes &pathTimes = times[static_cast<uint32_t>(frame.path)];
+    pathTimes.cpuMilliseconds += milliseconds;
+    pathTimes.cpuSamples++;
+    // The frame's GPU time follows once it has been submitted and completed
+    if (gpuTimed)
+    {
+        pendingGpuSamples++;
+    }
+    return;
+}
+
+void DrawDataTuner::addGpuSample(const DrawDataFrame &frame, double milliseconds)
+{
+    if (!tuning || !frame.measured)
+    {
+        return;
+    }
+    PathTimes &pathTimes = times[static_cast<uint32_t>(frame.path)];
+    pathTimes.gpuMilliseconds += milliseconds;
+    pathTimes.gpuSamples++;
+    if (pendingGpuSamples > 0)
+    {
+        pendingGpuSamples--;
+    }
+    return;
+}
+
+/*
+    Recording and the GPU overlap, a frame costs whichever of the two
+    is slower. Ties go to the path the limits would have chosen
+*/
+void DrawDataTuner::finishTuning(void)
+{
+    tuning = false;
+
+    std::cout << "[+] Draw data paths on this device (ms per frame)" << std::endl
+              << "\t\tPath        Record    GPU" << std::endl;
+
+    DrawDataPath best = path;
+    double bestCost = 0.0;
+    bool found = false;
+    for (DrawDataPath candidate : schedule)
+    {
+        const PathTimes &pathTimes = times[static_cast<uint32_t>(candidate)];
+        if (pathTimes.cpuSamples == 0)
+        {
+            continue;
+        }
+        double cpu = pathTimes.cpuMilliseconds / pathTimes.cpuSamples;
+        double gpu = pathTimes.gpuSamples > 0 ? pathTimes.gpuMilliseconds / pathTimes.gpuSamples : 0.0;
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "\t\t" << std::left << std::setw(12) << getDrawDataPathName(candidate) << std::setw(10) << cpu;
+        if (pathTimes.gpuSamples > 0)
+        {
+            std::cout << gpu;
+        }
+        else
+        {
+            std::cout << "-";
+        }
+        std::cout << std::right << std::endl;
+
+        double cost = std::max(cpu, gpu);
+        if (!found || cost < bestCost || (cost == bestCost && candidate == path))
+        {
+            best = candidate;
+            bestCost = cost;
+            found = true;
+        }
+    }
+
+    path = best;
+    std::cout << "[+] Using " << getDrawDataPathName(path) << " for draw data" << std::endl;
+    return;
+}
+
+bool DrawDataTuner::isTuning(void) const
+{
+    return tuning;
+}
+
+DrawDataPath DrawDataTuner::getPath(void) const
+{
+    return path;
+}
+
+VkDeviceSize DrawDataTuner::getUniformStride(void) const
+{
+    return uniformStride;
+}
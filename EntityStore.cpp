@@ -0,0 +1,294 @@
+#include "EntityStore.h"
+
+EntityStore::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Entity Store Exception";
+    errorDescription = description;
+    return;
+}
+
+EntityStore::Exception::~Exception(void)
+{
+    return;
+}
+
+EntityStore::EntityStore(void)
+{
+    return;
+}
+
+EntityStore::~EntityStore(void)
+{
+    return;
+}
+
+uint32_t EntityStore::findArchetype(ComponentMask mask, MeshId mesh)
+{
+    for (uint32_t i = 0; i < archetypes.size(); i++)
+    {
+        if (archetypes[i].mask == mask && archetypes[i].mesh == mesh)
+        {
+            return i;
+        }
+    }
+    Archetype archetype{};
+    archetype.mask = mask;
+    archetype.mesh = mesh;
+    archetypes.push_back(std::move(archetype));
+    return static_cast<uint32_t>(archetypes.size() - 1);
+}
+
+// Appends default components, returns the new row
+uint32_t EntityStore::addRow(Archetype &archetype, Entity entity)
+{
+    uint32_t row = static_cast<uint32_t>(archetype.size());
+    archetype.entities.push_back(entity);
+    if (archetype.mask & COMPONENT_TRANSFORM)
+    {
+        archetype.positions.push_back(glm::vec3(0.0f));
+        archetype.rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        archetype.scales.push_back(glm::vec3(1.0f));
+        archetype.worldMatrices.push_back(glm::mat4(1.0f));
+        archetype.previousWorldMatrices.push_back(glm::mat4(1.0f));
+        archetype.transformFlags.push_back(TRANSFORM_LOCAL_DIRTY | TRANSFORM_RESET);
+        archetype.transformsDirty = true;
+    }
+    if (archetype.mask & COMPONENT_MESH)
+    {
+        archetype.worldBounds.push_back(glm::vec4(0.0f));
+        archetype.visible.push_back(0);
+    }
+    return row;
+}
+
+Entity EntityStore::create(ComponentMask mask)
+{
+    if ((mask & COMPONENT_MESH) && !(mask & COMPONENT_TRANSFORM))
+    {
+        E_EXCEPT("Mesh component requires a transform component");
+    }
+
+    Entity entity{};
+    if (!freeIndexes.empty())
+    {
+        entity.index = freeIndexes.back();
+        freeIndexes.pop_back();
+    }
+    else
+    {
+        entity.index = static_cast<uint32_t>(records.size());
+        records.push_back(EntityRecord{});
+    }
+    EntityRecord &record = records[entity.index];
+    entity.generation = record.generation;
+
+    record.archetype = findArchetype(mask, MESH_INVALID);
+    record.row = addRow(archetypes[record.archetype], entity);
+    return entity;
+}
+
+// Last row is moved into the hole so every column stays packed
+void EntityStore::removeRow(Archetype &archetype, uint32_t row)
+{
+    auto swapRemove = [row](auto &column) {
+        if (column.empty())
+        {
+            return;
+        }
+        column[row] = column.back();
+        column.pop_back();
+    };
+
+    uint32_t last = static_cast<uint32_t>(archetype.size() - 1);
+    if (row != last)
+    {
+        records[archetype.entities[last].index].row = row;
+    }
+
+    swapRemove(archetype.entities);
+    swapRemove(archetype.positions);
+    swapRemove(archetype.rotations);
+    swapRemove(archetype.scales);
+    swapRemove(archetype.worldMatrices);
+    swapRemove(archetype.previousWorldMatrices);
+    swapRemove(archetype.transformFlags);
+    swapRemove(archetype.worldBounds);
+    swapRemove(archetype.visible);
+    return;
+}
+
+void EntityStore::destroy(Entity entity)
+{
+    if (!isAlive(entity))
+    {
+        return;
+    }
+    EntityRecord &record = records[entity.index];
+    removeRow(archetypes[record.archetype], record.row);
+
+    record.generation++;
+    record.archetype = UINT32_MAX;
+    freeIndexes.push_back(entity.index);
+    return;
+}
+
+bool EntityStore::isAlive(Entity entity) const
+{
+    return entity.index < records.size() &&
+           records[entity.index].generation == entity.generation &&
+           records[entity.index].archetype != UINT32_MAX;
+}
+
+size_t EntityStore::getEntityCount(void) const
+{
+    return records.size() - freeIndexes.size();
+}
+
+const EntityStore::EntityRecord &EntityStore::getRecord(Entity entity) const
+{
+    if (!isAlive(entity))
+    {
+        E_EXCEPT("Entity is not alive");
+    }
+    return records[entity.index];
+}
+
+void EntityStore::setTransform(Entity entity,
+                               const glm::vec3 &position,
+                               const glm::quat &rotation,
+                               const glm::vec3 &scale)
+{
+    const EntityRecord &record = getRecord(entity);
+    Archetype &archetype = archetypes[record.archetype];
+    if (!(archetype.mask & COMPONENT_TRANSFORM))
+    {
+        E_EXCEPT("Entity has no transform component");
+    }
+    archetype.positions[record.row] = position;
+    archetype.rotations[record.row] = rotation;
+    archetype.scales[record.row] = scale;
+    archetype.transformFlags[record.row] |= TRANSFORM_LOCAL_DIRTY;
+    archetype.transformsDirty = true;
+    return;
+}
+
+void EntityStore::setWorldMatrix(Entity entity, const glm::mat4 &world)
+{
+    const EntityRecord &record = getRecord(entity);
+    Archetype &archetype = archetypes[record.archetype];
+    if (!(archetype.mask & COMPONENT_TRANSFORM))
+    {
+        E_EXCEPT("Entity has no transform component");
+    }
+    uint8_t &flags = archetype.transformFlags[record.row];
+    archetype.worldMatrices[record.row] = world;
+    if (flags & TRANSFORM_RESET)
+    {
+        archetype.previousWorldMatrices[record.row] = world;
+    }
+    flags = (flags & ~(TRANSFORM_LOCAL_DIRTY | TRANSFORM_RESET)) | TRANSFORM_BOUNDS_DIRTY | TRANSFORM_MOVED;
+    archetype.transformsDirty = true;
+    archetype.transformsMoved = true;
+    return;
+}
+
+void EntityStore::setMesh(Entity entity, MeshId mesh)
+{
+    const EntityRecord &record = getRecord(entity);
+    if (!(archetypes[record.archetype].mask & COMPONENT_MESH))
+    {
+        E_EXCEPT("Entity has no mesh component");
+    }
+    if (mesh >= meshBounds.size())
+    {
+        E_EXCEPT("Mesh was never added to the store");
+    }
+    if (archetypes[record.archetype].mesh == mesh)
+    {
+        return;
+    }
+
+    // Looked up first, adding an archetype may move the others
+    uint32_t target = findArchetype(archetypes[record.archetype].mask, mesh);
+    Archetype &from = archetypes[record.archetype];
+    Archetype &to = archetypes[target];
+
+    uint32_t row = addRow(to, entity);
+    to.positions[row] = from.positions[record.row];
+    to.rotations[row] = from.rotations[record.row];
+    to.scales[row] = from.scales[record.row];
+    to.worldMatrices[row] = from.worldMatrices[record.row];
+    to.previousWorldMatrices[row] = from.previousWorldMatrices[record.row];
+    to.transformFlags[row] = from.transformFlags[record.row] | TRANSFORM_BOUNDS_DIRTY;
+    to.transformsMoved = to.transformsMoved || (to.transformFlags[row] & TRANSFORM_MOVED);
+    removeRow(from, record.row);
+
+    records[entity.index].archetype = target;
+    records[entity.index].row = row;
+    return;
+}
+
+MeshId EntityStore::getMesh(Entity entity) const
+{
+    return archetypes[getRecord(entity).archetype].mesh;
+}
+
+const glm::mat4 &EntityStore::getWorldMatrix(Entity entity) const
+{
+    const EntityRecord &record = getRecord(entity);
+    const Archetype &archetype = archetypes[record.archetype];
+    if (!(archetype.mask & COMPONENT_TRANSFORM))
+    {
+        E_EXCEPT("Entity has no transform component");
+    }
+    return archetype.worldMatrices[record.row];
+}
+
+MeshId EntityStore::addMesh(const MeshBounds &bounds)
+{
+    meshBounds.push_back(bounds);
+    return static_cast<MeshId>(meshBounds.size() - 1);
+}
+
+void EntityStore::setMeshBounds(MeshId mesh, const MeshBounds &bounds)
+{
+    if (mesh >= meshBounds.size())
+    {
+        E_EXCEPT("Mesh was never added to the store");
+    }
+    if (meshBounds[mesh].center == bounds.center && meshBounds[mesh].radius == bounds.radius)
+    {
+        return;
+    }
+    meshBounds[mesh] = bounds;
+
+    for (auto &archetype : archetypes)
+    {
+        if (archetype.mesh != mesh)
+        {
+            continue;
+        }
+        for (auto &flags : archetype.transformFlags)
+        {
+            flags |= TRANSFORM_BOUNDS_DIRTY;
+        }
+        archetype.transformsDirty = archetype.size() > 0;
+    }
+    return;
+}
+
+const std::vector<MeshBounds> &EntityStore::getMeshBounds(void) const
+{
+    return meshBounds;
+}
+
+std::vector<Archetype> &EntityStore::getArchetypes(void)
+{
+    return archetypes;
+}
+
+const std::vector<Archetype> &EntityStore::getArchetypes(void) const
+{
+    return archetypes;
+}
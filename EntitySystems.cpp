@@ -0,0 +1,291 @@
+#include "EntitySystems.h"
+
+#include <algorithm>
+#include <cmath>
+
+glm::mat4 interpolateTransform(const glm::mat4 &previous, const glm::mat4 &current, float alpha)
+{
+    glm::mat4 matrix;
+    for (int column = 0; column < 4; column++)
+    {
+        matrix[column] = previous[column] + (current[column] - previous[column]) * alpha;
+    }
+    return matrix;
+}
+
+namespace
+{
+    // Rows [begin, end) of one archetype handled by a single job
+    struct RowBatch
+    {
+        Archetype *archetype;
+        size_t begin;
+        size_t end;
+        size_t count; // visible or moved rows, whatever the pass counts
+    };
+
+    template <typename Filter>
+    std::vector<RowBatch> splitRows(EntityStore &store, Filter filter)
+    {
+        std::vector<RowBatch> batches;
+        for (auto &archetype : store.getArchetypes())
+        {
+            if (!filter(archetype))
+            {
+                continue;
+            }
+            for (size_t begin = 0; begin < archetype.size(); begin += ENTITY_BATCH_SIZE)
+            {
+                batches.push_back({&archetype, begin, std::min(begin + ENTITY_BATCH_SIZE, archetype.size()), 0});
+            }
+        }
+        return batches;
+    }
+
+    // Inline when there is no job system or a single batch
+    template <typename Function>
+    void runBatches(std::vector<RowBatch> &batches, JobSystem *jobs, Function function)
+    {
+        if (jobs == nullptr || batches.size() < 2)
+        {
+            for (auto &batch : batches)
+            {
+                function(batch);
+            }
+            return;
+        }
+
+        JobCounter counter;
+        auto run = [&batches, &function](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                function(batches[i]);
+            }
+        };
+        jobs->parallelFor(batches.size(), 1, run, counter);
+        jobs->wait(counter);
+        return;
+    }
+}
+
+void beginTransformTick(EntityStore &store, JobSystem *jobs)
+{
+    std::vector<RowBatch> batches = splitRows(store, [](const Archetype &archetype) {
+        return (archetype.mask & COMPONENT_TRANSFORM) && archetype.transformsMoved;
+    });
+
+    runBatches(batches, jobs, [](RowBatch &batch) {
+        Archetype &archetype = *batch.archetype;
+        const glm::mat4 *worldMatrices = archetype.worldMatrices.data();
+        glm::mat4 *previousWorldMatrices = archetype.previousWorldMatrices.data();
+        uint8_t *flags = archetype.transformFlags.data();
+        for (size_t i = batch.begin; i < batch.end; i++)
+        {
+            if (flags[i] & TRANSFORM_MOVED)
+            {
+                previousWorldMatrices[i] = worldMatrices[i];
+                flags[i] &= ~TRANSFORM_MOVED;
+            }
+        }
+    });
+
+    for (auto &batch : batches)
+    {
+        batch.archetype->transformsMoved = false;
+    }
+    return;
+}
+
+void updateWorldMatrices(EntityStore &store, JobSystem *jobs)
+{
+    std::vector<RowBatch> batches = splitRows(store, [](const Archetype &archetype) {
+        return (archetype.mask & COMPONENT_TRANSFORM) && archetype.transformsDirty;
+    });
+
+    runBatches(batches, jobs, [](RowBatch &batch) {
+        Archetype &archetype = *batch.archetype;
+        // Without a mesh there are no bounds left to refresh
+        const uint8_t next = (archetype.mask & COMPONENT_MESH) ? TRANSFORM_BOUNDS_DIRTY : 0;
+        const glm::vec3 *positions = archetype.positions.data();
+        const glm::quat *rotations = archetype.rotations.data();
+        const glm::vec3 *scales = archetype.scales.data();
+        glm::mat4 *worldMatrices = archetype.worldMatrices.data();
+        glm::mat4 *previousWorldMatrices = archetype.previousWorldMatrices.data();
+        uint8_t *flags = archetype.transformFlags.data();
+        size_t i = batch.begin;
+        while (i < batch.end)
+        {
+            if (!(flags[i] & TRANSFORM_LOCAL_DIRTY))
+            {
+                i++;
+                continue;
+            }
+
+            // Runs of dirty rows go through the batch kernels in one call
+            size_t runEnd = i + 1;
+            while (runEnd < batch.end && (flags[runEnd] & TRANSFORM_LOCAL_DIRTY))
+            {
+                runEnd++;
+            }
+            composeTransforms(positions + i, rotations + i, scales + i, worldMatrices + i, runEnd - i);
+            batch.count += runEnd - i;
+
+            for (; i < runEnd; i++)
+            {
+                if (flags[i] & TRANSFORM_RESET)
+                {
+                    previousWorldMatrices[i] = worldMatrices[i];
+                }
+                flags[i] = (flags[i] & ~(TRANSFORM_LOCAL_DIRTY | TRANSFORM_RESET)) | next | TRANSFORM_MOVED;
+            }
+        }
+    });
+
+    for (auto &batch : batches)
+    {
+        batch.archetype->transformsDirty = (batch.archetype->mask & COMPONENT_MESH) != 0;
+        batch.archetype->transformsMoved = batch.archetype->transformsMoved || batch.count > 0;
+    }
+    return;
+}
+
+void updateWorldBounds(EntityStore &store, JobSystem *jobs)
+{
+    const std::vector<MeshBounds> &meshBounds = store.getMeshBounds();
+    std::vector<RowBatch> batches = splitRows(store, [](const Archetype &archetype) {
+        return (archetype.mask & COMPONENT_MESH) && archetype.transformsDirty;
+    });
+
+    runBatches(batches, jobs, [&meshBounds](RowBatch &batch) {
+        Archetype &archetype = *batch.archetype;
+        glm::vec4 *worldBounds = archetype.worldBounds.data();
+        uint8_t *flags = archetype.transformFlags.data();
+        if (archetype.mesh == MESH_INVALID)
+        {
+            std::fill(worldBounds + batch.begin, worldBounds + batch.end, glm::vec4(0.0f));
+            for (size_t i = batch.begin; i < batch.end; i++)
+            {
+                flags[i] &= ~TRANSFORM_BOUNDS_DIRTY;
+            }
+            return;
+        }
+
+        const MeshBounds bounds = meshBounds[archetype.mesh];
+        const glm::mat4 *worldMatrices = archetype.worldMatrices.data();
+        for (size_t i = batch.begin; i < batch.end; i++)
+        {
+            if (!(flags[i] & TRANSFORM_BOUNDS_DIRTY))
+            {
+                continue;
+            }
+            flags[i] &= ~TRANSFORM_BOUNDS_DIRTY;
+            const glm::mat4 &world = worldMatrices[i];
+
+            // Largest axis scale keeps the sphere conservative
+            float scale = std::max({glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                                    glm::dot(glm::vec3(world[1]), glm::vec3(world[1])),
+                                    glm::dot(glm::vec3(world[2]), glm::vec3(world[2]))});
+            glm::vec3 center = glm::vec3(world * glm::vec4(bounds.center, 1.0f));
+            worldBounds[i] = glm::vec4(center, bounds.radius * std::sqrt(scale));
+        }
+    });
+
+    for (auto &batch : batches)
+    {
+        batch.archetype->transformsDirty = false;
+    }
+    return;
+}
+
+size_t cullEntities(EntityStore &store, const Frustum &frustum, JobSystem *jobs)
+{
+    std::vector<RowBatch> batches = splitRows(store, [](const Archetype &archetype) {
+        return (archetype.mask & COMPONENT_MESH) != 0;
+    });
+
+    runBatches(batches, jobs, [&frustum](RowBatch &batch) {
+        Archetype &archetype = *batch.archetype;
+        uint8_t *visible = archetype.visible.data();
+        if (archetype.mesh == MESH_INVALID)
+        {
+            std::fill(visible + batch.begin, visible + batch.end, 0);
+            return;
+        }
+
+        const glm::vec4 *worldBounds = archetype.worldBounds.data();
+        for (size_t i = batch.begin; i < batch.end; i++)
+        {
+            visible[i] = frustum.intersectsSphere(glm::vec3(worldBounds[i]), worldBounds[i].w) ? 1 : 0;
+            batch.count += visible[i];
+        }
+    });
+
+    size_t visibleCount = 0;
+    for (auto &archetype : store.getArchetypes())
+    {
+        archetype.visibleCount = 0;
+    }
+    for (const auto &batch : batches)
+    {
+        batch.archetype->visibleCount += batch.count;
+        visibleCount += batch.count;
+    }
+    return visibleCount;
+}
+
+/*
+    Ranges are sized from the visible counts left by cullEntities,
+    each archetype then copies its visible matrices into its range
+*/
+void packInstances(const EntityStore &store,
+                   std::vector<InstanceData> &instances,
+                   std::vector<InstanceBatch> &batches)
+{
+    const size_t meshCount = store.getMeshBounds().size();
+    std::vector<uint32_t> counts(meshCount, 0);
+    for (const auto &archetype : store.getArchetypes())
+    {
+        if ((archetype.mask & COMPONENT_MESH) && archetype.mesh != MESH_INVALID)
+        {
+            counts[archetype.mesh] += static_cast<uint32_t>(archetype.visibleCount);
+        }
+    }
+
+    batches.clear();
+    std::vector<uint32_t> cursors(meshCount, 0);
+    uint32_t total = 0;
+    for (MeshId mesh = 0; mesh < meshCount; mesh++)
+    {
+        cursors[mesh] = total;
+        if (counts[mesh] > 0)
+        {
+            batches.push_back({mesh, total, counts[mesh]});
+        }
+        total += counts[mesh];
+    }
+
+    instances.resize(total);
+    for (const auto &archetype : store.getArchetypes())
+    {
+        if (!(archetype.mask & COMPONENT_MESH) || archetype.visibleCount == 0)
+        {
+            continue;
+        }
+        const size_t count = archetype.size();
+        const uint8_t *visible = archetype.visible.data();
+        const glm::mat4 *worldMatrices = archetype.worldMatrices.data();
+        const glm::mat4 *previousWorldMatrices = archetype.previousWorldMatrices.data();
+        InstanceData *out = instances.data() + cursors[archetype.mesh];
+        for (size_t i = 0; i < count; i++)
+        {
+            if (visible[i])
+            {
+                out->model = worldMatrices[i];
+                out->previousModel = previousWorldMatrices[i];
+                out++;
+            }
+        }
+        cursors[archetype.mesh] += static_cast<uint32_t>(archetype.visibleCount);
+    }
+    return;
+}
@@ -0,0 +1,123 @@
+#include "FileView.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileView::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "File View Exception";
+    errorDescription = description;
+    return;
+}
+
+FileView::Exception::~Exception(void)
+{
+    return;
+}
+
+FileView::FileView(const std::string &path, bool populate)
+    : path(path)
+{
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        FV_EXCEPT("Failed to open " + path + " : " + std::strerror(errno));
+    }
+
+    struct stat status{};
+    if (fstat(file, &status) != 0)
+    {
+        close(file);
+        FV_EXCEPT("Failed to query the size of " + path);
+    }
+    size = static_cast<size_t>(status.st_size);
+
+    // mmap refuses empty ranges, an empty file simply has no mapping
+    if (size > 0)
+    {
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), file, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(file);
+            FV_EXCEPT("Failed to map " + path + " : " + std::strerror(errno));
+        }
+        mapping = mapped;
+        mappingSize = size;
+        data = static_cast<const unsigned char *>(mapped);
+    }
+
+    // The mapping holds its own reference to the file
+    close(file);
+    return;
+}
+
+FileView::FileView(std::shared_ptr<const FileView> archive, size_t offset, size_t size, const std::string &path, bool populate)
+    : path(path), size(size), archive(archive)
+{
+    if (offset > archive->getSize() || size > archive->getSize() - offset)
+    {
+        FV_EXCEPT(path + " lies outside " + archive->getPath());
+    }
+    if (offset % sizeof(uint32_t) != 0)
+    {
+        FV_EXCEPT(path + " is not word aligned in " + archive->getPath());
+    }
+    data = size > 0 ? archive->getData() + offset : nullptr;
+
+    // The archive was mapped without populating, fault in only this range
+    if (populate)
+    {
+        volatile unsigned char sink = 0;
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (size_t i = 0; i < size; i += pageSize)
+        {
+            sink = sink + data[i];
+        }
+    }
+    return;
+}
+
+FileView::FileView(std::vector<uint32_t> words, size_t size, const std::string &path)
+    : path(path), size(size), words(std::move(words))
+{
+    if (size > this->words.size() * sizeof(uint32_t))
+    {
+        FV_EXCEPT(path + " is larger than the memory holding it");
+    }
+    data = size > 0 ? reinterpret_cast<const unsigned char *>(this->words.data()) : nullptr;
+    return;
+}
+
+FileView::~FileView(void)
+{
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+    return;
+}
+
+const unsigned char *FileView::getData(void) const
+{
+    return data;
+}
+
+size_t FileView::getSize(void) const
+{
+    return size;
+}
+
+const uint32_t *FileView::getWords(void) const
+{
+    return reinterpret_cast<const uint32_t *>(data);
+}
+
+const std::string &FileView::getPath(void) const
+{
+    return path;
+}
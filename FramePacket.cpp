@@ -0,0 +1,92 @@
+#include "FramePacket.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <utility>
+
+glm::vec3 FramePacket::getCameraPosition(float alpha) const
+{
+    return glm::mix(previousCameraPosition, cameraPosition, alpha);
+}
+
+glm::mat4 FramePacket::getView(float alpha) const
+{
+    if (!cameraMoved)
+    {
+        return view;
+    }
+    glm::vec3 position = getCameraPosition(alpha);
+    glm::vec3 forward = glm::normalize(glm::mix(previousCameraForward, cameraForward, alpha));
+    return glm::lookAt(position, position + forward, glm::vec3(0.0f, -1.0f, 0.0f));
+}
+
+glm::mat4 FramePacket::getViewProjection(float alpha) const
+{
+    if (!cameraMoved)
+    {
+        return viewProjection;
+    }
+    return projection * getView(alpha);
+}
+
+Frustum FramePacket::getFrustum(float alpha) const
+{
+    if (!cameraMoved)
+    {
+        return frustum;
+    }
+    return Frustum::fromMatrix(getViewProjection(alpha));
+}
+
+FrameExchange::FrameExchange(void)
+{
+    return;
+}
+
+FrameExchange::~FrameExchange(void)
+{
+    return;
+}
+
+FramePacket &FrameExchange::getWritePacket(void)
+{
+    return packets[writeIndex];
+}
+
+void FrameExchange::publish(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(exchangeMutex);
+        std::swap(writeIndex, readyIndex);
+        fresh = true;
+    }
+    published.notify_one();
+    return;
+}
+
+const FramePacket *FrameExchange::acquire(void)
+{
+    std::unique_lock<std::mutex> lock(exchangeMutex);
+    published.wait(lock, [this](void) { return fresh || received || stopping; });
+    if (stopping)
+    {
+        return nullptr;
+    }
+    if (fresh)
+    {
+        std::swap(readIndex, readyIndex);
+        fresh = false;
+        received = true;
+    }
+    return &packets[readIndex];
+}
+
+void FrameExchange::stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(exchangeMutex);
+        stopping = true;
+    }
+    published.notify_all();
+    return;
+}
@@ -0,0 +1,455 @@
+#include "GeometryPool.h"
+#include "MemoryHandler.h"
+
+// Offsets are kept aligned so any index type and vertex layout can be bound
+const VkDeviceSize GEOMETRY_ALIGNMENT = 16;
+
+const VkBufferUsageFlags VERTEX_HEAP_USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+const VkBufferUsageFlags INDEX_HEAP_USAGE = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+GeometryPool::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Geometry Pool Exception";
+    errorDescription = description;
+    return;
+}
+
+GeometryPool::Exception::~Exception(void)
+{
+    return;
+}
+
+GeometryPool::GeometryPool(MemoryHandler &memoryHandler, VkDeviceSize vertexSize, VkDeviceSize indexSize)
+    : memory(memoryHandler), vertexHeapSize(vertexSize), indexHeapSize(indexSize)
+{
+    // Start with one heap of each kind
+    std::cout << "[+] Creating geometry pool heaps" << std::endl;
+    vertexHeaps.resize(1);
+    indexHeaps.resize(1);
+    createHeap(vertexHeaps[0], vertexHeapSize, VERTEX_HEAP_USAGE);
+    createHeap(indexHeaps[0], indexHeapSize, INDEX_HEAP_USAGE);
+    return;
+}
+
+GeometryPool::~GeometryPool(void)
+{
+    cleanup();
+    return;
+}
+
+VkDeviceSize GeometryPool::alignSize(VkDeviceSize size)
+{
+    return (size + GEOMETRY_ALIGNMENT - 1) & ~(GEOMETRY_ALIGNMENT - 1);
+}
+
+void GeometryPool::createHeap(Heap &heap, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    heap.size = alignSize(size);
+    memory.createBuffer(heap.size,
+                        usage,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        heap.buffer,
+                        heap.memory);
+    heap.freeRanges.clear();
+    heap.freeRanges[0] = heap.size;
+    return;
+}
+
+GeometryHandle GeometryPool::allocate(VkDeviceSize vertexBytes, VkDeviceSize indexBytes)
+{
+    GeometryAllocation allocation{};
+    allocation.vertexSize = vertexBytes;
+    allocation.indexSize = indexBytes;
+    allocation.live = true;
+
+    if (vertexBytes > 0)
+    {
+        allocateRange(vertexHeaps, vertexHeapSize, VERTEX_HEAP_USAGE, vertexBytes,
+                      allocation.vertexHeap, allocation.vertexOffset);
+    }
+    if (indexBytes > 0)
+    {
+        allocateRange(indexHeaps, indexHeapSize, INDEX_HEAP_USAGE, indexBytes,
+                      allocation.indexHeap, allocation.indexOffset);
+    }
+
+    // Reuse a released handle if any
+    GeometryHandle handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        allocations[handle] = allocation;
+    }
+    else
+    {
+        handle = static_cast<GeometryHandle>(allocations.size());
+        allocations.push_back(allocation);
+    }
+    return handle;
+}
+
+void GeometryPool::free(GeometryHandle handle)
+{
+    if (handle >= allocations.size() || !allocations[handle].live)
+    {
+        GP_EXCEPT("Attempted to free an invalid geometry handle");
+    }
+
+    GeometryAllocation &allocation = allocations[handle];
+    if (allocation.vertexSize > 0)
+    {
+        freeRange(vertexHeaps[allocation.vertexHeap], allocation.vertexOffset, allocation.vertexSize);
+    }
+    if (allocation.indexSize > 0)
+    {
+        freeRange(indexHeaps[allocation.indexHeap], allocation.indexOffset, allocation.indexSize);
+    }
+
+    allocation = GeometryAllocation{};
+    freeHandles.push_back(handle);
+    return;
+}
+
+const GeometryAllocation &GeometryPool::get(GeometryHandle handle) const
+{
+    if (handle >= allocations.size() || !allocations[handle].live)
+    {
+        GP_EXCEPT("Attempted to use an invalid geometry handle");
+    }
+    return allocations[handle];
+}
+
+VkBuffer GeometryPool::getVertexBuffer(uint32_t heap) const
+{
+    return vertexHeaps.at(heap).buffer;
+}
+
+VkBuffer GeometryPool::getIndexBuffer(uint32_t heap) const
+{
+    return indexHeaps.at(heap).buffer;
+}
+
+void GeometryPool::allocateRange(std::vector<Heap> &heaps,
+                                 VkDeviceSize heapSize,
+                                 VkBufferUsageFlags usage,
+                                 VkDeviceSize bytes,
+                                 uint32_t &heapIndex,
+                                 VkDeviceSize &offset)
+{
+    VkDeviceSize size = alignSize(bytes);
+
+    // First fit across existing heaps
+    for (auto &heap : heaps)
+    {
+        if (heap.buffer == nullptr)
+        {
+            continue;
+        }
+        for (auto it = heap.freeRanges.begin(); it != heap.freeRanges.end(); ++it)
+        {
+            if (it->second < size)
+            {
+                continue;
+            }
+            heapIndex = static_cast<uint32_t>(&heap - &heaps[0]);
+            offset = it->first;
+
+            VkDeviceSize remaining = it->second - size;
+            heap.freeRanges.erase(it);
+            if (remaining > 0)
+            {
+                heap.freeRanges[offset + size] = remaining;
+            }
+            return;
+        }
+    }
+
+    // Nothing fits, add a heap -- reuse a slot left by a dropped heap
+    std::cout << "[+] Growing geometry pool by " << std::max(heapSize, size) << " bytes" << std::endl;
+    auto slot = std::find_if(heaps.begin(), heaps.end(),
+                             [](const Heap &heap) { return heap.buffer == nullptr; });
+    if (slot == heaps.end())
+    {
+        heaps.emplace_back();
+        slot = heaps.end() - 1;
+    }
+    createHeap(*slot, std::max(heapSize, size), usage);
+
+    heapIndex = static_cast<uint32_t>(slot - heaps.begin());
+    offset = 0;
+    slot->freeRanges.clear();
+    if (slot->size > size)
+    {
+        slot->freeRanges[size] = slot->size - size;
+    }
+    return;
+}
+
+void GeometryPool::freeRange(Heap &heap, VkDeviceSize offset, VkDeviceSize bytes)
+{
+    VkDeviceSize size = alignSize(bytes);
+
+    auto inserted = heap.freeRanges.emplace(offset, size).first;
+
+    // Merge with following range
+    auto next = std::next(inserted);
+    if (next != heap.freeRanges.end() && inserted->first + inserted->second == next->first)
+    {
+        inserted->second += next->second;
+        heap.freeRanges.erase(next);
+    }
+
+    // Merge with preceding range
+    if (inserted != heap.freeRanges.begin())
+    {
+        auto prev = std::prev(inserted);
+        if (prev->first + prev->second == inserted->first)
+        {
+            prev->second += inserted->second;
+            heap.freeRanges.erase(inserted);
+        }
+    }
+    return;
+}
+
+void GeometryPool::upload(VkCommandBuffer commandBuffer,
+                          GeometryHandle handle,
+                          const void *vertexData,
+                          const void *indexData)
+{
+    const GeometryAllocation &allocation = get(handle);
+    VkDeviceSize stagingSize = allocation.vertexSize + allocation.indexSize;
+    if (stagingSize == 0)
+    {
+        return;
+    }
+
+    RetiredBuffer staging{};
+    memory.createBuffer(stagingSize,
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                        staging.buffer,
+                        staging.memory);
+    // Released along with defragmented buffers
+    retired.push_back(staging);
+
+    void *mapped = nullptr;
+    if (vkMapMemory(memory.memVar.m_Device, staging.memory, 0, stagingSize, 0, &mapped) != VK_SUCCESS)
+    {
+        GP_EXCEPT("Failed to map geometry staging memory");
+    }
+    if (allocation.vertexSize > 0)
+    {
+        memcpy(mapped, vertexData, allocation.vertexSize);
+    }
+    if (allocation.indexSize > 0)
+    {
+        memcpy(static_cast<char *>(mapped) + allocation.vertexSize, indexData, allocation.indexSize);
+    }
+    vkUnmapMemory(memory.memVar.m_Device, staging.memory);
+
+    if (allocation.vertexSize > 0)
+    {
+        VkBufferCopy region{};
+        region.srcOffset = 0;
+        region.dstOffset = allocation.vertexOffset;
+        region.size = allocation.vertexSize;
+        vkCmdCopyBuffer(commandBuffer, staging.buffer, vertexHeaps[allocation.vertexHeap].buffer, 1, &region);
+    }
+    if (allocation.indexSize > 0)
+    {
+        VkBufferCopy region{};
+        region.srcOffset = allocation.vertexSize;
+        region.dstOffset = allocation.indexOffset;
+        region.size = allocation.indexSize;
+        vkCmdCopyBuffer(commandBuffer, staging.buffer, indexHeaps[allocation.indexHeap].buffer, 1, &region);
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         0,
+                         1, &barrier,
+                         0, nullptr,
+                         0, nullptr);
+    return;
+}
+
+void GeometryPool::defragment(VkCommandBuffer commandBuffer)
+{
+    compactHeaps(commandBuffer, vertexHeaps, true);
+    compactHeaps(commandBuffer, indexHeaps, false);
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         0,
+                         1, &barrier,
+                         0, nullptr,
+                         0, nullptr);
+    return;
+}
+
+void GeometryPool::compactHeaps(VkCommandBuffer commandBuffer, std::vector<Heap> &heaps, bool isVertexHeap)
+{
+    for (auto &heap : heaps)
+    {
+        if (heap.buffer == nullptr)
+        {
+            continue;
+        }
+        uint32_t heapIndex = static_cast<uint32_t>(&heap - &heaps[0]);
+
+        // Gather live ranges of this heap in offset order
+        std::vector<GeometryAllocation *> residents;
+        for (auto &allocation : allocations)
+        {
+            if (!allocation.live)
+            {
+                continue;
+            }
+            if (isVertexHeap && allocation.vertexSize > 0 && allocation.vertexHeap == heapIndex)
+            {
+                residents.push_back(&allocation);
+            }
+            else if (!isVertexHeap && allocation.indexSize > 0 && allocation.indexHeap == heapIndex)
+            {
+                residents.push_back(&allocation);
+            }
+        }
+
+        // Empty heaps beyond the first are dropped entirely
+        if (residents.empty())
+        {
+            if (heapIndex > 0)
+            {
+                retired.push_back({heap.buffer, heap.memory});
+                heap = Heap{};
+            }
+            continue;
+        }
+
+        // Already packed when the only hole is the tail
+        if (heap.freeRanges.empty() ||
+            (heap.freeRanges.size() == 1 &&
+             heap.freeRanges.begin()->first + heap.freeRanges.begin()->second == heap.size))
+        {
+            continue;
+        }
+
+        auto offsetOf = [isVertexHeap](GeometryAllocation *a) -> VkDeviceSize & {
+            return isVertexHeap ? a->vertexOffset : a->indexOffset;
+        };
+        auto sizeOf = [isVertexHeap](GeometryAllocation *a) {
+            return isVertexHeap ? a->vertexSize : a->indexSize;
+        };
+        std::sort(residents.begin(), residents.end(),
+                  [&](GeometryAllocation *a, GeometryAllocation *b) { return offsetOf(a) < offsetOf(b); });
+
+        // Copy into a fresh buffer, vkCmdCopyBuffer regions may not overlap
+        Heap packed{};
+        createHeap(packed, heap.size, isVertexHeap ? VERTEX_HEAP_USAGE : INDEX_HEAP_USAGE);
+
+        std::vector<VkBufferCopy> regions;
+        regions.reserve(residents.size());
+        VkDeviceSize cursor = 0;
+        for (auto *resident : residents)
+        {
+            VkBufferCopy region{};
+            region.srcOffset = offsetOf(resident);
+            region.dstOffset = cursor;
+            region.size = sizeOf(resident);
+            regions.push_back(region);
+
+            offsetOf(resident) = cursor;
+            cursor += alignSize(sizeOf(resident));
+        }
+        vkCmdCopyBuffer(commandBuffer,
+                        heap.buffer,
+                        packed.buffer,
+                        static_cast<uint32_t>(regions.size()),
+                        regions.data());
+
+        packed.freeRanges.clear();
+        if (cursor < packed.size)
+        {
+            packed.freeRanges[cursor] = packed.size - cursor;
+        }
+
+        retired.push_back({heap.buffer, heap.memory});
+        heap = packed;
+    }
+    return;
+}
+
+void GeometryPool::releaseRetired(void)
+{
+    for (auto &buffer : retired)
+    {
+        vkDestroyBuffer(memory.memVar.m_Device, buffer.buffer, nullptr);
+        vkFreeMemory(memory.memVar.m_Device, buffer.memory, nullptr);
+    }
+    retired.clear();
+    return;
+}
+
+float GeometryPool::getFragmentation(void) const
+{
+    VkDeviceSize totalFree = 0;
+    VkDeviceSize largestFree = 0;
+    for (const auto *heaps : {&vertexHeaps, &indexHeaps})
+    {
+        for (const auto &heap : *heaps)
+        {
+            for (const auto &range : heap.freeRanges)
+            {
+                totalFree += range.second;
+                largestFree = std::max(largestFree, range.second);
+            }
+        }
+    }
+    if (totalFree == 0)
+    {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(largestFree) / static_cast<float>(totalFree);
+}
+
+void GeometryPool::cleanup(void)
+{
+    releaseRetired();
+    for (auto *heaps : {&vertexHeaps, &indexHeaps})
+    {
+        for (auto &heap : *heaps)
+        {
+            if (heap.buffer != nullptr)
+            {
+                vkDestroyBuffer(memory.memVar.m_Device, heap.buffer, nullptr);
+            }
+            if (heap.memory != nullptr)
+            {
+                vkFreeMemory(memory.memVar.m_Device, heap.memory, nullptr);
+            }
+        }
+        heaps->clear();
+    }
+    allocations.clear();
+    freeHandles.clear();
+    return;
+}
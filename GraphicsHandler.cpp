@@ -1,7 +1,6 @@
 // Copyright 2021 - not a real copyright, cpplint was annoying me
 #include "GraphicsHandler.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "Benchmark.h"
 
 GraphicsHandler::Exception::Exception(int l, std::string f, std::string description)
     : ExceptionHandler(l, f, description)
@@ -17,13 +16,15 @@ GraphicsHandler::Exception::~Exception(void)
 }
 
 GraphicsHandler::GraphicsHandler(Display *dsp, Window *wnd, int w, int h)
-    : display(dsp), window(wnd), windowWidth(w), windowHeight(h), Human("Human")
+    : display(dsp), window(wnd), windowWidth(w), windowHeight(h), Human("Human", "textures/statue.jpg")
 {
   return;
 }
 
 void GraphicsHandler::initGraphics(void)
 {
+  m_StartupBegin = std::chrono::high_resolution_clock::now();
+
 #ifndef NDEBUG
   std::cout << "[!] Debugging enabled" << std::endl;
   std::cout << "\t[-] Checking for validation layers" << std::endl;
@@ -37,6 +38,9 @@ void GraphicsHandler::initGraphics(void)
   std::cout << "[+] Checking instance level extension support" << std::endl;
   checkInstanceExtensionSupport();
 
+  // Before anything is loaded, so shaders and textures come from the pack
+  mountAssets();
+
   initVulkan();
 
   return;
@@ -143,141 +147,186 @@ void GraphicsHandler::checkInstanceExtensionSupport(void)
 
 void GraphicsHandler::initVulkan(void)
 {
+  // Startup stages run as jobs, the creating thread helps while it waits on them
+  jobs = std::make_unique<JobSystem>();
+
+  /*
+    Each stage lists the ones it reads the results of.
+    Stages touching MemoryHandler, the command pool or the
+    graphics queue are chained, none of those are thread safe
+  */
+  StartupGraph startup;
+
   /*
     Creates Vulkan instance and if debugging is enabled
     will load debug utility functions
   */
-  std::cout << "[+] Creating instance" << std::endl;
-  createInstance();
+  StartupStage instance = startup.add("Creating instance", {}, [this](void)
+                                      { createInstance(); });
+
+  // Read and reflected before there is a device to make anything from them
+  StartupStage shaderFiles = startup.add("Reading shaders", {}, [this](void)
+                                         { readShaders(); });
+
+  StartupStage gridVertices = startup.add("Creating grid vertices", {}, [this](void)
+                                          {
+#ifndef NDEBUG
+                                            createGridVertices(); // Does not move into memory
+#endif
+                                          });
+
+  // Sources sit beside the executable in development trees only
+  startup.add("Starting shader watcher", {}, [this](void)
+              {
+                std::filesystem::path shaderSources = ShaderWatcher::getExecutableDirectory();
+                if (SHADER_HOT_RELOAD && std::filesystem::exists(shaderSources / "shader.vert"))
+                {
+                  std::cout << "\t[+] Watching shader sources in " << shaderSources.string() << std::endl;
+                  shaderWatcher = std::make_unique<ShaderWatcher>(shaderSources, shaderSources / SHADER_DIRECTORY);
+                } });
 
   // Fetches devices and their info
-  std::cout << "[+] Querying system devices" << std::endl;
-  queryDevices();
+  StartupStage devices = startup.add("Querying system devices", {instance}, [this](void)
+                                     { queryDevices(); });
+
+  // Only needs the instance, made while devices are queried
+  StartupStage surface = startup.add("Creating surface", {instance}, [this](void)
+                                     { createSurface(); });
 
   /*
     Selects an adapter we will create a logical device for
     in the process it also retrieves the index of graphics queue family
     and stores as member variable of deviceInfoList[selectedIndex]
   */
-  std::cout << "[+] Selecting adapter" << std::endl;
-  selectAdapter();
-
-  // Store physical device handle in m_PhysicalDevice
-  m_PhysicalDevice = deviceInfoList.at(selectedIndex).devHandle;
-
-  // Create window surface
-  std::cout << "[+] Creating surface" << std::endl;
-  createSurface();
-
-  // Fetches list of queues that support presentation
-  std::cout << "[+] Searching for presentation support" << std::endl;
-  findPresentSupport();
-
-  // Creates QueueCreateInfo structs if necessary a Present queue
-  std::cout << "[+] Configuring command queue allocation" << std::endl;
-  configureCommandQueues();
-
-  /* Fetch swap chain info for creation */
-  std::cout << "[+] Querying swapchain support details" << std::endl;
-  querySwapChainSupport();
+  StartupStage adapter = startup.add("Selecting adapter", {devices}, [this](void)
+                                     {
+                                       selectAdapter();
+                                       // Store physical device handle in m_PhysicalDevice
+                                       m_PhysicalDevice = deviceInfoList.at(selectedIndex).devHandle; });
 
   // Check device level extension support
-  std::cout << "[+] Checking device level extension support" << std::endl;
-  checkDeviceExtensionSupport();
-
-  // Create logical device
-  std::cout << "[+] Creating logical device" << std::endl;
-  createLogicalDevice();
-
-  // Create command queues (present + graphics)
-  std::cout << "[+] Creating command queues" << std::endl;
-  createCommandQueues();
-
-  // Load our device level PFN functions
-  std::cout << "[+] Loading dynamic state functions" << std::endl;
-  loadDevicePFN();
-
-  std::cout << "[+] Creating swapchain" << std::endl;
-  createSwapChain();
+  StartupStage deviceExtensions = startup.add("Checking device level extension support", {adapter}, [this](void)
+                                              { checkDeviceExtensionSupport(); });
 
-  std::cout << "[+] Creating swap views" << std::endl;
-  createSwapViews();
-
-  // Create descriptor set layout
-  std::cout << "[+] Creating descriptor layout" << std::endl;
-  createDescriptorSetLayout();
-
-  // Create pipeline layout
-  std::cout << "[+] Creating pipeline layout" << std::endl;
-  createPipelineLayout();
-
-  // Create render pass
-  std::cout << "[+] Creating render pass" << std::endl;
-  createRenderPass();
+  /*
+    Fetches list of queues that support presentation and
+    creates QueueCreateInfo structs if necessary a Present queue
+  */
+  StartupStage queues = startup.add("Configuring command queue allocation", {adapter, surface}, [this](void)
+                                    {
+                                      findPresentSupport();
+                                      configureCommandQueues(); });
 
-  // Create the pipeline
-  std::cout << "[+] Creating graphics pipeline" << std::endl;
-  createGraphicsPipeline();
+  /* Fetch swap chain info for creation */
+  StartupStage swapSupport = startup.add("Querying swapchain support details", {adapter, surface}, [this](void)
+                                         { querySwapChainSupport(); });
 
-  // Create frame buffers
-  std::cout << "[+] Creating frame buffers" << std::endl;
-  createFrameBuffers();
+  // Create logical device, its queues and our device level PFN functions
+  StartupStage device = startup.add("Creating logical device", {deviceExtensions, queues}, [this](void)
+                                    {
+                                      createLogicalDevice();
+                                      createCommandQueues();
+                                      loadDevicePFN(); });
 
-  // Create command pool
-  std::cout << "[+] Allocating for command pool" << std::endl;
-  createCommandPool();
+  StartupStage pipelineCache = startup.add("Loading pipeline cache", {device}, [this](void)
+                                           { loadPipelineCache(); });
 
-  /*
-    These are buffers that a specified queue family's commands are recorded in
-    This allocates memory from a parent command pool
-  */
-  std::cout << "[+] Allocating for command buffer" << std::endl;
-  createCommandBuffers();
+  StartupStage shaderModules = startup.add("Creating shader modules", {device, shaderFiles}, [this](void)
+                                           { createShaderModules(); });
 
   /*
     Memory allocator handles vertex, index and uniform buffers
+    and the images sized with the swapchain
   */
-  MemoryInitParameters params = {
-      params.vertexSize = 256,
-      params.indexSize = 256,
-      params.m_PhysicalDevice = m_PhysicalDevice,
-      params.m_Device = m_Device,
-      params.selectedDevice = selectedDevice,
-      params.m_SurfaceDetails = m_SurfaceDetails};
-
-  memory = std::make_unique<MemoryHandler>(params);
-
-#ifndef NDEBUG
-  std::cout << "[+] Creating grid vertices" << std::endl;
-  createGridVertices(); // Does not move into memory
-#endif
+  StartupStage memoryPools = startup.add("Creating memory pools", {device, swapSupport}, [this](void)
+                                         {
+                                           MemoryInitParameters params = {
+                                               .vertexSize = VERTEX_BUFFER_SIZE,
+                                               .indexSize = INDEX_BUFFER_SIZE,
+                                               .m_PhysicalDevice = m_PhysicalDevice,
+                                               .m_Device = m_Device,
+                                               .selectedDevice = selectedDevice,
+                                               .m_SurfaceDetails = m_SurfaceDetails};
+
+                                           memory = std::make_unique<MemoryHandler>(params); });
+
+  StartupStage swapchain = startup.add("Creating swapchain", {memoryPools}, [this](void)
+                                       {
+                                         createSwapChain();
+                                         createSwapViews();
+
+                                         m_SurfaceDetails.selectedSampleCount = chooseSampleCount();
+                                         m_DepthFormat = findDepthFormat();
+                                         createColorResources();
+                                         createDepthResources();
+
+                                         // The pipeline's depth compare follows the camera's projection
+                                         camera = std::make_unique<Camera>(m_SurfaceDetails.capabilities.currentExtent.width, m_SurfaceDetails.capabilities.currentExtent.height);
+                                         m_AspectRatio = m_SurfaceDetails.capabilities.currentExtent.width /
+                                                         static_cast<float>(m_SurfaceDetails.capabilities.currentExtent.height); });
+
+  // Layouts and the global set of texture and buffer arrays, shared by all draws
+  StartupStage descriptorLayout = startup.add("Creating descriptor layout", {device, shaderFiles}, [this](void)
+                                              {
+                                                createDescriptorSetLayout();
+                                                bindless = std::make_unique<BindlessDescriptors>(m_Device,
+                                                                                                 selectedDevice->indexingProperties,
+                                                                                                 BINDLESS_MAX_TEXTURES,
+                                                                                                 BINDLESS_MAX_BUFFERS); });
+
+  // How per-draw data reaches the shaders, pipelines are built for every path it may pick
+  StartupStage drawDataPath = startup.add("Selecting draw data path", {descriptorLayout, swapchain}, [this](void)
+                                          { createDrawDataTuner(); });
+
+  StartupStage pipelineLayout = startup.add("Creating pipeline layout", {drawDataPath, shaderModules}, [this](void)
+                                            { createPipelineLayout(); });
+
+  StartupStage renderPass = startup.add("Creating render pass", {swapchain}, [this](void)
+                                        { createRenderPass(); });
+
+  startup.add("Creating graphics pipeline", {pipelineLayout, renderPass, pipelineCache}, [this](void)
+              { createGraphicsPipeline(); });
+
+  StartupStage frameBuffers = startup.add("Creating frame buffers", {renderPass}, [this](void)
+                                          { createFrameBuffers(); });
 
   /*
-    Loads all defined models' data into vertex, index and MVP buffers
+    These are buffers that a specified queue family's commands are recorded in
+    This allocates memory from a parent command pool
   */
-  // std::cout << "[+] Loading models..." << std::endl;
-  // loadEntities();
-
-  // Temp
-  // Add a single human element to type container
-  //Human.humans.push_back(HumanClass());
+  StartupStage commandBuffers = startup.add("Allocating command buffers", {device, frameBuffers}, [this](void)
+                                            {
+                                              createCommandPool();
+                                              createCommandBuffers(); });
+
+  StartupStage assetStreamer = startup.add("Starting asset streamer", {memoryPools}, [this](void)
+                                           {
+                                             textures = std::make_unique<TextureHandler>(*memory, *jobs);
+                                             streamer = std::make_unique<AssetStreamer>(m_Device,
+                                                                                        m_GraphicsQueue,
+                                                                                        selectedDevice->graphicsFamilyIndex,
+                                                                                        *memory,
+                                                                                        *textures,
+                                                                                        *jobs);
+                                             transforms = std::make_unique<TransformHierarchy>(jobs.get()); });
 
   /*
-   Describes the constraints on allocation of descriptor sets
-   type, number/size etc
+    Queues all defined models and textures, they are drawn
+    once resident so the first frame does not wait on them.
+    The grid is uploaded through the command pool and memory pools
   */
-  std::cout << "[+] Creating descriptor pool" << std::endl;
-  createDescriptorPool();
+  StartupStage assets = startup.add("Requesting models and textures", {assetStreamer, gridVertices, commandBuffers, swapchain}, [this](void)
+                                    {
+                                      loadEntities();
+                                      createEntities();
+                                      loadTextures(); });
 
   /*
-    Allocates descriptor sets from the preallocated pool
+    Sets are allocated per frame from pools reset wholesale,
+    only the allocator and the buffers they point at are made here
   */
-  std::cout << "[+] Allocating descriptor sets" << std::endl;
-  createDescriptorSets();
-
-  // Binds our created descriptors with resources
-  std::cout << "[+] Binding descriptor sets" << std::endl;
-  bindDescriptorSets();
+  startup.add("Creating descriptor allocator", {drawDataPath, assets}, [this](void)
+              { createDescriptorSets(); });
 
   /*
     Used to synchronize operation
@@ -285,12 +334,22 @@ void GraphicsHandler::initVulkan(void)
     So that commands are not executed when resources are not yet available
     For ex: pipeline images
   */
-  std::cout << "[+] Creating synchronization resources" << std::endl;
-  createSyncObjects();
+  startup.add("Creating synchronization resources", {swapchain}, [this](void)
+              { createSyncObjects(); });
 
-  // Create the camera
-  camera = std::make_unique<Camera>(m_SurfaceDetails.capabilities.currentExtent.width, m_SurfaceDetails.capabilities.currentExtent.height);
+  startup.run(*jobs);
+  startup.printTimings();
+
+  // Alone on the queue and the memory pools, after everything else
+  if (UPLOAD_BENCHMARK)
+  {
+    benchmarkUploads();
+  }
 
+  // Modules and layouts hold everything needed from them now
+  m_ShaderStages.clear();
+  m_VertexCode.reset();
+  m_FragmentCode.reset();
   return;
 }
 
@@ -401,63 +460,63 @@ void GraphicsHandler::queryDevices(void)
     memset(&deviceContainer.devProperties, 0, sizeof(VkPhysicalDeviceProperties2));
     memset(&deviceContainer.devFeatures, 0, sizeof(VkPhysicalDeviceFeatures2));
     memset(&deviceContainer.extendedFeatures, 0, sizeof(VkPhysicalDeviceExtendedDynamicStateFeaturesEXT));
+    memset(&deviceContainer.indexingFeatures, 0, sizeof(VkPhysicalDeviceDescriptorIndexingFeatures));
+    memset(&deviceContainer.indexingProperties, 0, sizeof(VkPhysicalDeviceDescriptorIndexingProperties));
+    memset(&deviceContainer.idProperties, 0, sizeof(VkPhysicalDeviceIDProperties));
     // Configure structures so that Vulkan will recognize and populate them
     deviceContainer.devProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
     deviceContainer.devFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
     deviceContainer.extendedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    deviceContainer.indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    deviceContainer.indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    deviceContainer.idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
     // Append extendedFeatures container to devFeatures structure
+    // The chain is also handed to vkCreateDevice, enabling whatever the device reported
     deviceContainer.devFeatures.pNext = &deviceContainer.extendedFeatures;
+    deviceContainer.extendedFeatures.pNext = &deviceContainer.indexingFeatures;
+    deviceContainer.devProperties.pNext = &deviceContainer.indexingProperties;
+    deviceContainer.indexingProperties.pNext = &deviceContainer.idProperties;
 
     // Fetch properties/features for each device
     vkGetPhysicalDeviceProperties2(deviceContainer.devHandle, &deviceContainer.devProperties);
     vkGetPhysicalDeviceFeatures2(deviceContainer.devHandle, &deviceContainer.devFeatures);
     // Fetch queue families
     vkGetPhysicalDeviceQueueFamilyProperties(deviceContainer.devHandle, &deviceContainer.queueFamilyCount, nullptr);
-    if (deviceContainer.queueFamilyCount == 0)
-    {
-      deviceContainer.rating = -1;
-      continue;
-    }
     deviceContainer.queueFamiles.resize(deviceContainer.queueFamilyCount, {});
     vkGetPhysicalDeviceQueueFamilyProperties(deviceContainer.devHandle, &deviceContainer.queueFamilyCount,
                                              deviceContainer.queueFamiles.data());
+
+    // Limits, memory, queues and extensions in one record, scored for selectAdapter
+    deviceContainer.capabilities = std::make_shared<const DeviceCapabilities>(probeDevice(deviceContainer));
+    deviceContainer.rating = deviceContainer.capabilities->score;
   }
   return;
 }
 
 void GraphicsHandler::selectAdapter(void)
 {
-  for (auto &deviceContainer : deviceInfoList)
-  {
-    // If rating is -1, skip
-    if (deviceContainer.rating == -1)
+  for (const auto &device : deviceInfoList)
+  {
+    const DeviceCapabilities &capabilities = *device.capabilities;
+    std::cout << (capabilities.missing.empty() ? "\t[+] " : "\t[-] ") << capabilities.name
+              << " (" << getDeviceTypeName(capabilities.type) << ") " << formatDeviceUuid(capabilities.uuid) << std::endl;
+    std::cout << "\t\t" << (capabilities.deviceLocalSize >> 20) << " MiB device local, "
+              << (capabilities.hostVisibleDeviceLocalSize >> 20) << " MiB host visible"
+              << (capabilities.resizableBar ? " (resizable BAR)" : "") << ", "
+              << capabilities.queueFamilies.size() << " queue families, "
+              << capabilities.extensions.size() << " extensions" << std::endl;
+    if (capabilities.missing.empty())
     {
+      std::cout << "\t\tScore " << capabilities.score << std::endl;
       continue;
     }
-
-    if (deviceContainer.devProperties.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-    {
-      deviceContainer.rating += 1000;
-    }
-    deviceContainer.rating += deviceContainer.devProperties.properties.limits.maxImageDimension2D;
-
-    // Iterate device's queue families and ensure graphics is supported
-    bool hasGraphics = false;
-    for (auto &queue : deviceContainer.queueFamiles)
-    {
-      if (queue.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-      {
-        hasGraphics = true;
-        deviceContainer.graphicsFamilyIndex = (&queue - &deviceContainer.queueFamiles[0]);
-      }
-    } // end queue loop
-
-    if (!hasGraphics || !deviceContainer.devFeatures.features.geometryShader)
+    std::cout << "\t\tMissing";
+    for (const auto &missing : capabilities.missing)
     {
-      deviceContainer.rating = 0;
-      continue;
+      std::cout << ((&missing == &capabilities.missing[0]) ? " " : ", ") << missing;
     }
-  } // end container loop
+    std::cout << std::endl;
+  }
 
   /* -- SELECTION -- */
   selectedIndex = 0;
@@ -469,12 +528,40 @@ void GraphicsHandler::selectAdapter(void)
     }
   }
 
+  // An override takes any adapter the renderer can run on, however it scored
+  std::string requested = getDeviceOverride();
+  if (!requested.empty())
+  {
+    std::array<uint8_t, VK_UUID_SIZE> uuid{};
+    if (!parseDeviceUuid(requested, uuid))
+    {
+      G_EXCEPT("Device override " + requested + " is not a UUID");
+    }
+    auto match = std::find_if(deviceInfoList.begin(), deviceInfoList.end(), [&uuid](const DEVICEINFO &device)
+                              { return device.capabilities->uuid == uuid; });
+    if (match == deviceInfoList.end())
+    {
+      std::cout << "[-] No adapter has UUID " << requested << ", selecting by score" << std::endl;
+    }
+    else if (!match->capabilities->missing.empty())
+    {
+      G_EXCEPT("Device override " + requested + " selects " + match->capabilities->name + " which the renderer cannot use");
+    }
+    else
+    {
+      selectedIndex = static_cast<int>(match - deviceInfoList.begin());
+      std::cout << "[+] Adapter overridden by UUID" << std::endl;
+    }
+  }
+
   if (deviceInfoList.at(selectedIndex).rating <= 0)
   {
     G_EXCEPT("Failed to find a suitable adapter");
   }
 
   selectedDevice = &deviceInfoList.at(selectedIndex);
+  selectedDevice->graphicsFamilyIndex = selectedDevice->capabilities->graphicsFamily;
+  std::cout << "[+] Selected " << selectedDevice->capabilities->name << std::endl;
 
   return;
 }
@@ -856,76 +943,203 @@ void GraphicsHandler::createSwapViews(void)
   return;
 }
 
+/*
+  First format the device can use as an optimally tiled depth
+  attachment. Float depth first, reverse-Z relies on its precision
+*/
+VkFormat GraphicsHandler::findDepthFormat(void)
+{
+  const std::vector<VkFormat> candidates = {VK_FORMAT_D32_SFLOAT,
+                                            VK_FORMAT_D32_SFLOAT_S8_UINT,
+                                            VK_FORMAT_D24_UNORM_S8_UINT,
+                                            VK_FORMAT_D16_UNORM};
+  for (const auto &format : candidates)
+  {
+    VkFormatProperties properties{};
+    vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, format, &properties);
+    if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+    {
+      return format;
+    }
+  }
+
+  G_EXCEPT("Device does not support any depth attachment format");
+}
+
+/*
+  Never read after the pass, transient with lazily allocated memory
+  lets tiled GPUs keep it on chip without backing it in VRAM
+*/
+void GraphicsHandler::createDepthResources(void)
+{
+  memory->createImage(m_SurfaceDetails.capabilities.currentExtent.width,
+                      m_SurfaceDetails.capabilities.currentExtent.height,
+                      1,
+                      m_DepthFormat,
+                      VK_IMAGE_TILING_OPTIMAL,
+                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                      m_DepthImage,
+                      m_DepthMemory,
+                      m_SurfaceDetails.selectedSampleCount,
+                      VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+  m_DepthView = createImageView(m_DepthImage, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+  return;
+}
+
+VkSampleCountFlagBits GraphicsHandler::chooseSampleCount(void)
+{
+  const VkPhysicalDeviceLimits &limits = selectedDevice->devProperties.properties.limits;
+  VkSampleCountFlags supported = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+
+  for (VkSampleCountFlagBits count : {VK_SAMPLE_COUNT_64_BIT,
+                                      VK_SAMPLE_COUNT_32_BIT,
+                                      VK_SAMPLE_COUNT_16_BIT,
+                                      VK_SAMPLE_COUNT_8_BIT,
+                                      VK_SAMPLE_COUNT_4_BIT,
+                                      VK_SAMPLE_COUNT_2_BIT})
+  {
+    if (count <= MSAA_MAX_SAMPLES && (supported & count))
+    {
+      std::cout << "\t[+] Using " << count << "x MSAA" << std::endl;
+      return count;
+    }
+  }
+  return VK_SAMPLE_COUNT_1_BIT;
+}
+
+/*
+  Samples only live for the pass, the resolve at the end of the
+  subpass is the one full resolution write that reaches memory
+*/
+void GraphicsHandler::createColorResources(void)
+{
+  if (m_SurfaceDetails.selectedSampleCount == VK_SAMPLE_COUNT_1_BIT)
+  {
+    return;
+  }
+
+  memory->createImage(m_SurfaceDetails.capabilities.currentExtent.width,
+                      m_SurfaceDetails.capabilities.currentExtent.height,
+                      1,
+                      m_SurfaceDetails.selectedFormat.format,
+                      VK_IMAGE_TILING_OPTIMAL,
+                      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                      m_ColorImage,
+                      m_ColorMemory,
+                      m_SurfaceDetails.selectedSampleCount,
+                      VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+  m_ColorView = createImageView(m_ColorImage, m_SurfaceDetails.selectedFormat.format);
+  return;
+}
+
+// Per-image bindings the engine writes, shaders may declare any of them and no others below BINDLESS_SET
+struct FrameBinding
+{
+  uint32_t set;
+  uint32_t binding;
+  VkDescriptorType type;
+};
+const std::array<FrameBinding, 3> FRAME_BINDINGS = {{
+    // Draw constants -- per object, rebound at a dynamic offset per draw
+    {0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC},
+    // View/projection -- per scene
+    {0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER},
+    // Projection -- changes when extent changes
+    {1, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER},
+}};
+
 void GraphicsHandler::createDescriptorSetLayout(void)
 {
-  /* Set 0 */
-  // Model matrix binding -- Per object
-  VkDescriptorSetLayoutBinding modelBinding{};
-  modelBinding.binding = 0;
-  modelBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-  modelBinding.descriptorCount = 1;
-  modelBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-  modelBinding.pImmutableSamplers = nullptr;
-
-  // View matrix binding -- per scene
-  VkDescriptorSetLayoutBinding viewBinding{};
-  viewBinding.binding = 1;
-  viewBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  viewBinding.descriptorCount = 1;
-  viewBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-  viewBinding.pImmutableSamplers = nullptr;
-
-  /* Set 1 */
-  // Projection matrix binding -- changes when extent changes
-  VkDescriptorSetLayoutBinding projBinding{};
-  projBinding.binding = 0;
-  projBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  projBinding.descriptorCount = 1;
-  projBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-  projBinding.pImmutableSamplers = nullptr;
-
-  std::vector<VkDescriptorSetLayoutBinding> set0Binding = {modelBinding, viewBinding};
-  std::vector<VkDescriptorSetLayoutBinding> set1Binding = {projBinding};
-
-  VkDescriptorSetLayoutCreateInfo set0Info{};
-  set0Info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-  set0Info.pNext = nullptr;
-  set0Info.flags = 0;
-  set0Info.bindingCount = static_cast<uint32_t>(set0Binding.size());
-  set0Info.pBindings = set0Binding.data();
-
-  VkDescriptorSetLayoutCreateInfo set1Info{};
-  set1Info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-  set1Info.pNext = nullptr;
-  set1Info.flags = 0;
-  set1Info.bindingCount = static_cast<uint32_t>(set1Binding.size());
-  set1Info.pBindings = set1Binding.data();
-
-  std::vector<VkDescriptorSetLayoutCreateInfo> layouts = {set0Info, set1Info};
-
-  m_DescriptorLayouts.resize(static_cast<uint32_t>(layouts.size()));
-
-  for (const auto &layout : layouts)
-  {
-    if (vkCreateDescriptorSetLayout(m_Device,
-                                    &layout,
-                                    nullptr,
-                                    &m_DescriptorLayouts[(&layout - &layouts[0])]) != VK_SUCCESS)
+  // Layouts follow what the shaders declare, not a hand kept copy of it
+  const std::vector<ShaderReflection> &stages = m_ShaderStages;
+  for (const auto &stage : stages)
+  {
+    if (stage.getStage() == VK_SHADER_STAGE_VERTEX_BIT)
+    {
+      stage.checkVertexInput(m_PipelineStageInfo.attributeDescription);
+    }
+  }
+  m_ReflectedPushConstants = ShaderReflection::mergePushConstants(stages);
+
+  std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets = ShaderReflection::mergeBindings(stages);
+  if (sets.size() > BINDLESS_SET + 1)
+  {
+    G_EXCEPT("Shaders use descriptor sets past the bindless set");
+  }
+  // The bindless set's layout is made by BindlessDescriptors
+  sets.resize(BINDLESS_SET);
+
+  for (uint32_t set = 0; set < sets.size(); set++)
+  {
+    for (auto &binding : sets[set])
     {
-      G_EXCEPT("Failed to create descriptor layout");
+      auto expected = std::find_if(FRAME_BINDINGS.begin(), FRAME_BINDINGS.end(), [&](const FrameBinding &frameBinding)
+                                   { return frameBinding.set == set && frameBinding.binding == binding.binding; });
+      std::string name = "set " + std::to_string(set) + " binding " + std::to_string(binding.binding);
+      if (expected == FRAME_BINDINGS.end())
+      {
+        G_EXCEPT("Shaders declare " + name + " which the engine does not write");
+      }
+      // SPIR-V does not tell dynamic uniform buffers apart, the engine decides
+      if (binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+          expected->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+      {
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+      }
+      if (binding.descriptorType != expected->type || binding.descriptorCount != 1)
+      {
+        G_EXCEPT("Shaders declare " + name + " as another type than the engine writes");
+      }
     }
   }
+
+  // Sets with the same bindings share one layout
+  layouts = std::make_unique<DescriptorLayoutCache>(m_Device);
+  m_DescriptorLayouts.clear();
+  for (const auto &bindings : sets)
+  {
+    m_DescriptorLayouts.push_back(layouts->getLayout(bindings));
+  }
+  m_FrameSetBindings = sets;
+
+  std::cout << "\t[+] " << layouts->size() << " set layouts for " << sets.size()
+            << " per-image sets, " << m_ReflectedPushConstants.size << " bytes of push constants" << std::endl;
   return;
 }
 
-void GraphicsHandler::createPipelineLayout(void)
+bool GraphicsHandler::declaresBinding(uint32_t set, uint32_t binding) const
+{
+  if (set >= m_FrameSetBindings.size())
+  {
+    return false;
+  }
+  return std::any_of(m_FrameSetBindings[set].begin(), m_FrameSetBindings[set].end(), [binding](const VkDescriptorSetLayoutBinding &b)
+                     { return b.binding == binding; });
+}
+
+void GraphicsHandler::readShaders(void)
 {
-  auto vertexBlob = readFile("shaders/vert.spv");
-  auto fragmentBlob = readFile("shaders/frag.spv");
+  m_VertexCode = openShader("vert.spv");
+  m_FragmentCode = openShader("frag.spv");
+
+  m_ShaderStages.clear();
+  m_ShaderStages.emplace_back(m_VertexCode->getWords(), m_VertexCode->getSize());
+  m_ShaderStages.emplace_back(m_FragmentCode->getWords(), m_FragmentCode->getSize());
+  return;
+}
 
-  m_PipelineStageInfo.vertexModule = createShaderModule(vertexBlob);
-  m_PipelineStageInfo.fragmentModule = createShaderModule(fragmentBlob);
+void GraphicsHandler::createShaderModules(void)
+{
+  // Kept for the life of the handler, pipelines are rebuilt from them with the swapchain
+  m_PipelineStageInfo.vertexModule = createShaderModule(*m_VertexCode);
+  m_PipelineStageInfo.fragmentModule = createShaderModule(*m_FragmentCode);
+  return;
+}
 
+void GraphicsHandler::createPipelineLayout(void)
+{
   m_PipelineStageInfo.vertexStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
   m_PipelineStageInfo.vertexStageInfo.pNext = nullptr;
   m_PipelineStageInfo.vertexStageInfo.flags = 0;
@@ -1012,9 +1226,24 @@ void GraphicsHandler::createPipelineLayout(void)
   m_PipelineStageInfo.depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
   m_PipelineStageInfo.depthStencilInfo.pNext = nullptr;
   m_PipelineStageInfo.depthStencilInfo.flags = 0;
+  /*
+    Reverse-Z keeps the larger depth. The fragment shader neither
+    writes depth nor discards, so hardware tests before shading.
+    After a pre-pass depth is final and colour only passes on the
+    exact depth it laid down
+  */
   m_PipelineStageInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
-  m_PipelineStageInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
-  m_PipelineStageInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+  if (DEPTH_PREPASS)
+  {
+    m_PipelineStageInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    m_PipelineStageInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+  }
+  else
+  {
+    m_PipelineStageInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
+    m_PipelineStageInfo.depthStencilInfo.depthCompareOp = camera->isReverseZ() ? VK_COMPARE_OP_GREATER_OR_EQUAL
+                                                                               : VK_COMPARE_OP_LESS_OR_EQUAL;
+  }
   m_PipelineStageInfo.depthStencilInfo.stencilTestEnable = VK_FALSE;
   m_PipelineStageInfo.depthStencilInfo.front = {};
   m_PipelineStageInfo.depthStencilInfo.back = {};
@@ -1048,10 +1277,30 @@ void GraphicsHandler::createPipelineLayout(void)
   m_PipelineStageInfo.pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   m_PipelineStageInfo.pipelineLayoutInfo.pNext = nullptr;
   m_PipelineStageInfo.pipelineLayoutInfo.flags = 0;
-  m_PipelineStageInfo.pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(m_DescriptorLayouts.size());
-  m_PipelineStageInfo.pipelineLayoutInfo.pSetLayouts = m_DescriptorLayouts.data();
-  m_PipelineStageInfo.pipelineLayoutInfo.pushConstantRangeCount = 0;
-  m_PipelineStageInfo.pipelineLayoutInfo.pPushConstantRanges = nullptr;
+  // Per-image sets first, the bindless set lands at BINDLESS_SET
+  m_PipelineSetLayouts = m_DescriptorLayouts;
+  m_PipelineSetLayouts.push_back(bindless->getLayout());
+  if (m_PipelineSetLayouts.size() != BINDLESS_SET + 1)
+  {
+    G_EXCEPT("Bindless set index does not follow the per-image sets");
+  }
+
+  // Model matrix and bindless indexes of each draw, only the indexes when the matrix does not fit
+  m_DrawConstantsRange.offset = 0;
+  m_DrawConstantsRange.size = drawData->isAvailable(DrawDataPath::PushConstants) ? sizeof(DrawConstants)
+                                                                                 : DRAW_CONSTANTS_HEADER_SIZE;
+  // Pushed to the stages that declare a block, both when neither does
+  m_DrawConstantsRange.stageFlags = m_ReflectedPushConstants.size > 0 ? m_ReflectedPushConstants.stageFlags
+                                                                      : VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  if (m_ReflectedPushConstants.offset + m_ReflectedPushConstants.size > sizeof(DrawConstants))
+  {
+    G_EXCEPT("Shaders read more push constants than DrawConstants holds");
+  }
+
+  m_PipelineStageInfo.pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(m_PipelineSetLayouts.size());
+  m_PipelineStageInfo.pipelineLayoutInfo.pSetLayouts = m_PipelineSetLayouts.data();
+  m_PipelineStageInfo.pipelineLayoutInfo.pushConstantRangeCount = 1;
+  m_PipelineStageInfo.pipelineLayoutInfo.pPushConstantRanges = &m_DrawConstantsRange;
 
   // Create pipeline layout
   if (vkCreatePipelineLayout(m_Device,
@@ -1079,28 +1328,72 @@ void GraphicsHandler::createRenderPass(void)
   m_PipelineStageInfo.colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   m_PipelineStageInfo.colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-  m_PipelineStageInfo.renderAttachments = {m_PipelineStageInfo.colorAttachment};
+  /* Depth is cleared on load and thrown away after the pass */
+  m_PipelineStageInfo.depthAttachment.flags = 0;
+  m_PipelineStageInfo.depthAttachment.format = m_DepthFormat;
+  m_PipelineStageInfo.depthAttachment.samples = m_SurfaceDetails.selectedSampleCount;
+  m_PipelineStageInfo.depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  m_PipelineStageInfo.depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  m_PipelineStageInfo.depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  m_PipelineStageInfo.depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  m_PipelineStageInfo.depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  m_PipelineStageInfo.depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  m_PipelineStageInfo.renderAttachments = {m_PipelineStageInfo.colorAttachment, m_PipelineStageInfo.depthAttachment};
+
+  /*
+    With MSAA the samples are resolved into the swap image as the
+    subpass ends and never stored themselves
+  */
+  const bool multisampled = m_SurfaceDetails.selectedSampleCount != VK_SAMPLE_COUNT_1_BIT;
+  if (multisampled)
+  {
+    m_PipelineStageInfo.renderAttachments[0].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    m_PipelineStageInfo.renderAttachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    m_PipelineStageInfo.resolveAttachment.flags = 0;
+    m_PipelineStageInfo.resolveAttachment.format = m_SurfaceDetails.selectedFormat.format;
+    m_PipelineStageInfo.resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    m_PipelineStageInfo.resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    m_PipelineStageInfo.resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    m_PipelineStageInfo.resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    m_PipelineStageInfo.resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    m_PipelineStageInfo.resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    m_PipelineStageInfo.resolveAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    m_PipelineStageInfo.renderAttachments.push_back(m_PipelineStageInfo.resolveAttachment);
+
+    m_PipelineStageInfo.resolveAttachmentRef.attachment = 2;
+    m_PipelineStageInfo.resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  }
 
   m_PipelineStageInfo.colorAttachmentRef.attachment = 0;
   m_PipelineStageInfo.colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+  m_PipelineStageInfo.depthAttachmentRef.attachment = 1;
+  m_PipelineStageInfo.depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
   m_PipelineStageInfo.subpass.flags = 0;
   m_PipelineStageInfo.subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
   m_PipelineStageInfo.subpass.inputAttachmentCount = 0;
   m_PipelineStageInfo.subpass.pInputAttachments = nullptr;
   m_PipelineStageInfo.subpass.colorAttachmentCount = 1;
   m_PipelineStageInfo.subpass.pColorAttachments = &m_PipelineStageInfo.colorAttachmentRef;
-  m_PipelineStageInfo.subpass.pResolveAttachments = nullptr;
-  m_PipelineStageInfo.subpass.pDepthStencilAttachment = nullptr;
+  m_PipelineStageInfo.subpass.pResolveAttachments = multisampled ? &m_PipelineStageInfo.resolveAttachmentRef : nullptr;
+  m_PipelineStageInfo.subpass.pDepthStencilAttachment = &m_PipelineStageInfo.depthAttachmentRef;
   m_PipelineStageInfo.subpass.preserveAttachmentCount = 0;
   m_PipelineStageInfo.subpass.pPreserveAttachments = nullptr;
 
   m_PipelineStageInfo.dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
   m_PipelineStageInfo.dependency.dstSubpass = 0;
-  m_PipelineStageInfo.dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  m_PipelineStageInfo.dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  m_PipelineStageInfo.dependency.srcAccessMask = 0;
-  m_PipelineStageInfo.dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  // The depth image is shared across frames in flight, the previous frame's depth tests finish before this clear
+  m_PipelineStageInfo.dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  m_PipelineStageInfo.dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  m_PipelineStageInfo.dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  m_PipelineStageInfo.dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
   m_PipelineStageInfo.renderInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
   m_PipelineStageInfo.renderInfo.pNext = nullptr;
@@ -1146,96 +1439,598 @@ void GraphicsHandler::createGraphicsPipeline(void)
   m_PipelineStageInfo.pipelineInfo.basePipelineHandle = nullptr;
   m_PipelineStageInfo.pipelineInfo.basePipelineIndex = -1;
 
-  if (vkCreateGraphicsPipelines(m_Device,
-                                nullptr,
-                                1,
-                                &m_PipelineStageInfo.pipelineInfo,
-                                nullptr,
-                                &m_Pipeline) != VK_SUCCESS)
-  {
-    G_EXCEPT("Failed to create graphics pipeline");
-  }
-
-  vkDestroyShaderModule(m_Device, m_PipelineStageInfo.vertexModule, nullptr);
-  vkDestroyShaderModule(m_Device, m_PipelineStageInfo.fragmentModule, nullptr);
+  buildPipelines(m_Pipelines, m_DepthPipelines);
   return;
 }
 
-void GraphicsHandler::createFrameBuffers(void)
+void GraphicsHandler::buildPipelines(std::array<VkPipeline, DRAW_DATA_PATH_COUNT> &pipelines,
+                                     std::array<VkPipeline, DRAW_DATA_PATH_COUNT> &depthPipelines)
 {
-  m_Framebuffers.resize(m_SwapViews.size());
+  // Specialization constant 0 selects where shaders read DrawConstants from
+  VkSpecializationMapEntry pathEntry{};
+  pathEntry.constantID = 0;
+  pathEntry.offset = 0;
+  pathEntry.size = sizeof(uint32_t);
 
-  for (const auto &view : m_SwapViews)
+  for (uint32_t path = 0; path < DRAW_DATA_PATH_COUNT; path++)
   {
-    std::vector<VkImageView> attachments = {view};
-    VkFramebufferCreateInfo fbInfo{};
-    fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    fbInfo.pNext = nullptr;
-    fbInfo.flags = 0;
-    fbInfo.renderPass = m_RenderPass;
-    fbInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    fbInfo.pAttachments = attachments.data();
-    fbInfo.width = m_SurfaceDetails.capabilities.currentExtent.width;
-    fbInfo.height = m_SurfaceDetails.capabilities.currentExtent.height;
-    fbInfo.layers = 1;
-    if (vkCreateFramebuffer(m_Device,
-                            &fbInfo,
-                            nullptr,
-                            &m_Framebuffers[(&view - &m_SwapViews[0])]) != VK_SUCCESS)
+    if (!drawData->isAvailable(static_cast<DrawDataPath>(path)))
     {
-      G_EXCEPT("Failed to create framebuffer");
+      continue;
     }
-  }
 
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &pathEntry;
+    specializationInfo.dataSize = sizeof(path);
+    specializationInfo.pData = &path;
+
+    // Vertex stage first, the pre-pass takes it alone
+    std::vector<VkPipelineShaderStageCreateInfo> stageInfos = m_PipelineStageInfo.stageInfos;
+    for (auto &stageInfo : stageInfos)
+    {
+      stageInfo.pSpecializationInfo = &specializationInfo;
+    }
+    VkGraphicsPipelineCreateInfo pipelineInfo = m_PipelineStageInfo.pipelineInfo;
+    pipelineInfo.pStages = stageInfos.data();
+
+    if (vkCreateGraphicsPipelines(m_Device,
+                                  m_PipelineCache,
+                                  1,
+                                  &pipelineInfo,
+                                  nullptr,
+                                  &pipelines[path]) != VK_SUCCESS)
+    {
+      G_EXCEPT("Failed to create graphics pipeline");
+    }
+
+    /*
+      Pre-pass pipeline : vertex stage only, writes depth and
+      no colour. Everything else matches so depth comes out identical
+    */
+    if (DEPTH_PREPASS)
+    {
+      VkPipelineDepthStencilStateCreateInfo depthInfo = m_PipelineStageInfo.depthStencilInfo;
+      depthInfo.depthWriteEnable = VK_TRUE;
+      depthInfo.depthCompareOp = camera->isReverseZ() ? VK_COMPARE_OP_GREATER : VK_COMPARE_OP_LESS;
+
+      VkPipelineColorBlendAttachmentState noColor = m_PipelineStageInfo.colorBlendAttachmentInfo;
+      noColor.blendEnable = VK_FALSE;
+      noColor.colorWriteMask = 0;
+      VkPipelineColorBlendStateCreateInfo noColorBlending = m_PipelineStageInfo.colorBlendingInfo;
+      noColorBlending.pAttachments = &noColor;
+
+      VkGraphicsPipelineCreateInfo depthPipelineInfo = pipelineInfo;
+      depthPipelineInfo.stageCount = 1;
+      depthPipelineInfo.pDepthStencilState = &depthInfo;
+      depthPipelineInfo.pColorBlendState = &noColorBlending;
+
+      if (vkCreateGraphicsPipelines(m_Device,
+                                    m_PipelineCache,
+                                    1,
+                                    &depthPipelineInfo,
+                                    nullptr,
+                                    &depthPipelines[path]) != VK_SUCCESS)
+      {
+        G_EXCEPT("Failed to create depth pre-pass pipeline");
+      }
+    }
+  }
   return;
 }
 
-void GraphicsHandler::createCommandPool(void)
+std::filesystem::path GraphicsHandler::getShaderPath(const std::string &name)
 {
-  VkCommandPoolCreateInfo commandPoolInfo{};
-  commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-  commandPoolInfo.pNext = nullptr;
-  commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-  commandPoolInfo.queueFamilyIndex = selectedDevice->graphicsFamilyIndex;
+  static const std::filesystem::path directory = ShaderWatcher::getExecutableDirectory() / SHADER_DIRECTORY;
+  return directory / name;
+}
 
-  if (vkCreateCommandPool(m_Device,
-                          &commandPoolInfo,
-                          nullptr,
-                          &m_CommandPool) != VK_SUCCESS)
+std::shared_ptr<const FileView> GraphicsHandler::openShader(const std::string &name)
+{
+  // Hot reload writes loose binaries, they win over the pack while it is on
+  std::filesystem::path loose = getShaderPath(name);
+  if (!SHADER_HOT_RELOAD || !std::filesystem::exists(loose))
   {
-    G_EXCEPT("Failed to create graphics command pool");
+    std::shared_ptr<const FileView> packed = openPackedAsset(std::string(SHADER_DIRECTORY) + "/" + name);
+    if (packed != nullptr)
+    {
+      return packed;
+    }
   }
-  return;
+  return std::make_shared<const FileView>(loose.string());
 }
 
-void GraphicsHandler::createCommandBuffers(void)
+void GraphicsHandler::mountAssets(void)
 {
-  VkResult result;
+  std::filesystem::path packPath = ShaderWatcher::getExecutableDirectory() / ASSET_PACK_FILE;
+  if (!std::filesystem::exists(packPath))
+  {
+    return;
+  }
+  auto pack = std::make_shared<const AssetPack>(packPath.string());
+  mountAssetPack(pack);
+  std::cout << "[+] Mounted " << pack->getFileCount() << " packed assets from " << packPath.string() << std::endl;
+  return;
+}
 
-  // allocate command buffer for each framebuffer
-  m_CommandBuffers.resize(m_Framebuffers.size());
+std::filesystem::path GraphicsHandler::getPipelineCachePath(void)
+{
+  return ShaderWatcher::getExecutableDirectory() / PIPELINE_CACHE_FILE;
+}
 
-  VkCommandBufferAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.pNext = nullptr;
-  allocInfo.commandPool = m_CommandPool;
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandBufferCount = (uint32_t)m_CommandBuffers.size();
+void GraphicsHandler::loadPipelineCache(void)
+{
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.pNext = nullptr;
+  cacheInfo.flags = 0;
+  cacheInfo.initialDataSize = 0;
+  cacheInfo.pInitialData = nullptr;
+
+  // Data from another driver or device would be ignored anyway, it is only passed on when it matches
+  std::unique_ptr<FileView> data;
+  std::filesystem::path path = getPipelineCachePath();
+  if (std::filesystem::exists(path))
+  {
+    try
+    {
+      data = std::make_unique<FileView>(path.string());
+    }
+    catch (ExceptionHandler &e)
+    {
+      std::cout << "\t[-] " << e.getErrorDescription() << std::endl;
+    }
+  }
 
-  result = vkAllocateCommandBuffers(m_Device,
-                                    &allocInfo,
-                                    m_CommandBuffers.data());
-  if (result != VK_SUCCESS)
+  // Header version one, laid out as the spec gives it
+  struct
   {
-    G_EXCEPT("Failed to allocate command buffers!");
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+  } header{};
+  const VkPhysicalDeviceProperties &properties = selectedDevice->devProperties.properties;
+  if (data != nullptr && data->getSize() >= sizeof(header))
+  {
+    memcpy(&header, data->getData(), sizeof(header));
+    if (header.headerVersion == 1 &&
+        header.vendorID == properties.vendorID &&
+        header.deviceID == properties.deviceID &&
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+    {
+      cacheInfo.initialDataSize = data->getSize();
+      cacheInfo.pInitialData = data->getData();
+    }
   }
 
+  if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+  {
+    G_EXCEPT("Failed to create pipeline cache");
+  }
+  std::cout << "\t[+] " << (cacheInfo.initialDataSize != 0 ? "Reusing " : "Starting ")
+            << cacheInfo.initialDataSize << " bytes of pipeline cache" << std::endl;
   return;
 }
 
-void GraphicsHandler::createSyncObjects(void)
+void GraphicsHandler::savePipelineCache(void)
 {
-  VkResult result;
+  size_t size = 0;
+  if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+  {
+    return;
+  }
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &size, data.data()) != VK_SUCCESS)
+  {
+    return;
+  }
+
+  // Written beside the cache then renamed over it, a crash never leaves half a file
+  std::filesystem::path path = getPipelineCachePath();
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(size));
+    if (!file)
+    {
+      std::cout << "[-] Failed to write pipeline cache " << temporary.string() << std::endl;
+      return;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error)
+  {
+    std::cout << "[-] Failed to replace pipeline cache " << path.string() << " : " << error.message() << std::endl;
+  }
+  return;
+}
+
+void GraphicsHandler::benchmarkUploads(void)
+{
+  const VkDeviceSize size = UPLOAD_BENCHMARK_SIZE;
+  const int iterations = 8;
+
+  std::vector<char> source(size);
+  for (VkDeviceSize i = 0; i < size; i++)
+  {
+    source[i] = static_cast<char>(i * 31);
+  }
+
+  std::cout << "[+] Upload bandwidth, " << (size >> 20) << " MiB per write" << std::endl;
+  auto report = [size](UploadPath path, double milliseconds) {
+    std::cout << "\t[+] " << getUploadPathName(path) << " : "
+              << (size / (milliseconds * 1.0e6)) << " GB/s, " << milliseconds << " ms" << std::endl;
+  };
+
+  for (UploadPath path : {UploadPath::Direct, UploadPath::Host})
+  {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory bufferMemory = VK_NULL_HANDLE;
+    void *mapped = nullptr;
+    if (!memory->createMappedBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, path, buffer, bufferMemory, &mapped))
+    {
+      std::cout << "\t[-] " << getUploadPathName(path) << " : no memory for it" << std::endl;
+      continue;
+    }
+
+    report(path, measureMilliseconds([&](void)
+                                     { memcpy(mapped, source.data(), size); },
+                                     iterations));
+
+    // The same write, then copied into device local memory and waited on
+    if (path == UploadPath::Host)
+    {
+      VkBuffer deviceBuffer = VK_NULL_HANDLE;
+      VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
+      memory->createDeviceBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, deviceBuffer, deviceMemory);
+
+      report(UploadPath::Staged, measureMilliseconds([&](void)
+                                                     {
+                                                       memcpy(mapped, source.data(), size);
+                                                       VkBufferCopy region{0, 0, size};
+                                                       VkCommandBuffer commandBuffer = beginSingleCommands();
+                                                       vkCmdCopyBuffer(commandBuffer, buffer, deviceBuffer, 1, &region);
+                                                       endSingleCommands(commandBuffer); },
+                                                     iterations));
+
+      vkDestroyBuffer(m_Device, deviceBuffer, nullptr);
+      vkFreeMemory(m_Device, deviceMemory, nullptr);
+    }
+
+    // Freeing the memory unmaps it
+    vkDestroyBuffer(m_Device, buffer, nullptr);
+    vkFreeMemory(m_Device, bufferMemory, nullptr);
+  }
+
+  std::cout << "\t[+] Per-frame data takes the " << getUploadPathName(memory->getUniformPath()) << " path" << std::endl;
+  return;
+}
+
+void GraphicsHandler::reportFirstFrame(void)
+{
+  if (m_FirstFramePresented)
+  {
+    return;
+  }
+  m_FirstFramePresented = true;
+  double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_StartupBegin).count();
+  std::cout << "[+] First frame presented " << milliseconds << " ms after startup" << std::endl;
+  return;
+}
+
+void GraphicsHandler::checkShaderInterface(const ShaderReflection &reflection) const
+{
+  VkShaderStageFlagBits stage = reflection.getStage();
+  for (const auto &binding : reflection.getBindings())
+  {
+    // The bindless layout is fixed, its arrays are the same for every shader
+    if (binding.set == BINDLESS_SET)
+    {
+      continue;
+    }
+    std::string name = "set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding);
+    if (!declaresBinding(binding.set, binding.binding))
+    {
+      G_EXCEPT("Declares " + name + " which the pipeline layout does not have");
+    }
+    const auto &setBindings = m_FrameSetBindings[binding.set];
+    auto layoutBinding = std::find_if(setBindings.begin(), setBindings.end(), [&binding](const VkDescriptorSetLayoutBinding &b)
+                                      { return b.binding == binding.binding; });
+    bool dynamicUniform = binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+                          layoutBinding->descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    if (binding.type != layoutBinding->descriptorType && !dynamicUniform)
+    {
+      G_EXCEPT("Declares " + name + " as another type than the pipeline layout");
+    }
+    if (!(layoutBinding->stageFlags & stage))
+    {
+      G_EXCEPT("Reads " + name + " which the pipeline layout does not give this stage");
+    }
+  }
+
+  VkPushConstantRange pushConstants = reflection.getPushConstants();
+  if (pushConstants.size > 0 &&
+      (pushConstants.offset + pushConstants.size > m_DrawConstantsRange.size || !(m_DrawConstantsRange.stageFlags & stage)))
+  {
+    G_EXCEPT("Push constant block is outside the pipeline layout's range");
+  }
+
+  if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+  {
+    reflection.checkVertexInput(m_PipelineStageInfo.attributeDescription);
+  }
+  return;
+}
+
+/*
+  Only stages that fit the current pipeline layout are swapped in,
+  a change to sets or push constants still needs a restart. Anything
+  failing keeps the running pipelines, so a broken save never stops
+  the frame loop
+*/
+void GraphicsHandler::reloadShaders(void)
+{
+  m_ShaderFrame++;
+  destroyRetiredPipelines(false);
+
+  if (!shaderWatcher)
+  {
+    return;
+  }
+  std::vector<CompiledShader> compiled = shaderWatcher->takeCompiled();
+  if (compiled.empty())
+  {
+    return;
+  }
+
+  // Latest good build of each stage
+  std::unique_ptr<FileView> vertexCode;
+  std::unique_ptr<FileView> fragmentCode;
+  for (auto &shader : compiled)
+  {
+    std::string name = shader.source.filename().string();
+    if (!shader.code)
+    {
+      std::cout << "[-] " << name << " failed to compile, keeping the running version" << std::endl
+                << shader.log << std::flush;
+      continue;
+    }
+    try
+    {
+      ShaderReflection reflection(shader.code->getWords(), shader.code->getSize());
+      if (reflection.getStage() != shader.stage)
+      {
+        G_EXCEPT("Compiled to another stage than its extension names");
+      }
+      checkShaderInterface(reflection);
+    }
+    catch (ExceptionHandler &e)
+    {
+      std::cout << "[-] " << name << " not reloaded : " << e.getErrorDescription() << std::endl;
+      continue;
+    }
+    std::cout << "[+] Recompiled " << name << " in " << shader.milliseconds << " ms" << std::endl;
+    (shader.stage == VK_SHADER_STAGE_VERTEX_BIT ? vertexCode : fragmentCode) = std::move(shader.code);
+  }
+  if (!vertexCode && !fragmentCode)
+  {
+    return;
+  }
+
+  auto buildStart = std::chrono::high_resolution_clock::now();
+
+  // Stage infos hold the vertex stage first, as the pre-pass expects
+  std::vector<VkPipelineShaderStageCreateInfo> runningStages = m_PipelineStageInfo.stageInfos;
+  VkShaderModule vertexModule = m_PipelineStageInfo.vertexModule;
+  VkShaderModule fragmentModule = m_PipelineStageInfo.fragmentModule;
+  std::array<VkPipeline, DRAW_DATA_PATH_COUNT> pipelines{};
+  std::array<VkPipeline, DRAW_DATA_PATH_COUNT> depthPipelines{};
+  try
+  {
+    if (vertexCode)
+    {
+      vertexModule = createShaderModule(*vertexCode);
+    }
+    if (fragmentCode)
+    {
+      fragmentModule = createShaderModule(*fragmentCode);
+    }
+    m_PipelineStageInfo.stageInfos[0].module = vertexModule;
+    m_PipelineStageInfo.stageInfos[1].module = fragmentModule;
+    buildPipelines(pipelines, depthPipelines);
+  }
+  catch (ExceptionHandler &e)
+  {
+    for (uint32_t path = 0; path < DRAW_DATA_PATH_COUNT; path++)
+    {
+      if (pipelines[path] != VK_NULL_HANDLE)
+      {
+        vkDestroyPipeline(m_Device, pipelines[path], nullptr);
+      }
+      if (depthPipelines[path] != VK_NULL_HANDLE)
+      {
+        vkDestroyPipeline(m_Device, depthPipelines[path], nullptr);
+      }
+    }
+    if (vertexModule != m_PipelineStageInfo.vertexModule)
+    {
+      vkDestroyShaderModule(m_Device, vertexModule, nullptr);
+    }
+    if (fragmentModule != m_PipelineStageInfo.fragmentModule)
+    {
+      vkDestroyShaderModule(m_Device, fragmentModule, nullptr);
+    }
+    m_PipelineStageInfo.stageInfos = runningStages;
+    std::cout << "[-] Shader reload failed, keeping the running pipelines : " << e.getErrorDescription() << std::endl;
+    return;
+  }
+
+  // Frames in flight may still use the old pipelines, their modules are no longer needed by anything
+  for (uint32_t path = 0; path < DRAW_DATA_PATH_COUNT; path++)
+  {
+    if (m_Pipelines[path] != VK_NULL_HANDLE)
+    {
+      m_RetiredPipelines.push_back({m_Pipelines[path], m_ShaderFrame});
+    }
+    if (m_DepthPipelines[path] != VK_NULL_HANDLE)
+    {
+      m_RetiredPipelines.push_back({m_DepthPipelines[path], m_ShaderFrame});
+    }
+  }
+  m_Pipelines = pipelines;
+  m_DepthPipelines = depthPipelines;
+
+  if (vertexModule != m_PipelineStageInfo.vertexModule)
+  {
+    vkDestroyShaderModule(m_Device, m_PipelineStageInfo.vertexModule, nullptr);
+    m_PipelineStageInfo.vertexModule = vertexModule;
+    m_PipelineStageInfo.vertexStageInfo.module = vertexModule;
+  }
+  if (fragmentModule != m_PipelineStageInfo.fragmentModule)
+  {
+    vkDestroyShaderModule(m_Device, m_PipelineStageInfo.fragmentModule, nullptr);
+    m_PipelineStageInfo.fragmentModule = fragmentModule;
+    m_PipelineStageInfo.fragmentStageInfo.module = fragmentModule;
+  }
+
+  double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count();
+  std::cout << "\t[+] Pipelines rebuilt in " << buildMilliseconds << " ms" << std::endl;
+  return;
+}
+
+void GraphicsHandler::destroyRetiredPipelines(bool all)
+{
+  const uint64_t framesInFlight = static_cast<uint64_t>(MAX_FRAMES_IN_FLIGHT);
+  size_t count = 0;
+  while (count < m_RetiredPipelines.size() &&
+         (all || m_RetiredPipelines[count].second + framesInFlight <= m_ShaderFrame))
+  {
+    vkDestroyPipeline(m_Device, m_RetiredPipelines[count].first, nullptr);
+    count++;
+  }
+  m_RetiredPipelines.erase(m_RetiredPipelines.begin(), m_RetiredPipelines.begin() + count);
+  return;
+}
+
+void GraphicsHandler::createFrameBuffers(void)
+{
+  m_Framebuffers.resize(m_SwapViews.size());
+
+  for (const auto &view : m_SwapViews)
+  {
+    // Same order as the render pass attachments
+    std::vector<VkImageView> attachments = {view, m_DepthView};
+    if (m_ColorView != VK_NULL_HANDLE)
+    {
+      attachments = {m_ColorView, m_DepthView, view};
+    }
+    VkFramebufferCreateInfo fbInfo{};
+    fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fbInfo.pNext = nullptr;
+    fbInfo.flags = 0;
+    fbInfo.renderPass = m_RenderPass;
+    fbInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    fbInfo.pAttachments = attachments.data();
+    fbInfo.width = m_SurfaceDetails.capabilities.currentExtent.width;
+    fbInfo.height = m_SurfaceDetails.capabilities.currentExtent.height;
+    fbInfo.layers = 1;
+    if (vkCreateFramebuffer(m_Device,
+                            &fbInfo,
+                            nullptr,
+                            &m_Framebuffers[(&view - &m_SwapViews[0])]) != VK_SUCCESS)
+    {
+      G_EXCEPT("Failed to create framebuffer");
+    }
+  }
+
+  return;
+}
+
+void GraphicsHandler::createCommandPool(void)
+{
+  VkCommandPoolCreateInfo commandPoolInfo{};
+  commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  commandPoolInfo.pNext = nullptr;
+  commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  commandPoolInfo.queueFamilyIndex = selectedDevice->graphicsFamilyIndex;
+
+  if (vkCreateCommandPool(m_Device,
+                          &commandPoolInfo,
+                          nullptr,
+                          &m_CommandPool) != VK_SUCCESS)
+  {
+    G_EXCEPT("Failed to create graphics command pool");
+  }
+  return;
+}
+
+void GraphicsHandler::createCommandBuffers(void)
+{
+  VkResult result;
+
+  // allocate command buffer for each framebuffer
+  m_CommandBuffers.resize(m_Framebuffers.size());
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.pNext = nullptr;
+  allocInfo.commandPool = m_CommandPool;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = (uint32_t)m_CommandBuffers.size();
+
+  result = vkAllocateCommandBuffers(m_Device,
+                                    &allocInfo,
+                                    m_CommandBuffers.data());
+  if (result != VK_SUCCESS)
+  {
+    G_EXCEPT("Failed to allocate command buffers!");
+  }
+
+  // Secondary buffers, reset a whole pool at a time before recording
+  VkCommandPoolCreateInfo recordPoolInfo{};
+  recordPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  recordPoolInfo.pNext = nullptr;
+  recordPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  recordPoolInfo.queueFamilyIndex = selectedDevice->graphicsFamilyIndex;
+
+  m_RecordSlots.resize(m_Framebuffers.size());
+  for (auto &slots : m_RecordSlots)
+  {
+    slots.resize(jobs->getThreadCount());
+    for (auto &slot : slots)
+    {
+      if (vkCreateCommandPool(m_Device, &recordPoolInfo, nullptr, &slot.pool) != VK_SUCCESS)
+      {
+        G_EXCEPT("Failed to create recording command pool");
+      }
+
+      VkCommandBufferAllocateInfo secondaryInfo{};
+      secondaryInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+      secondaryInfo.pNext = nullptr;
+      secondaryInfo.commandPool = slot.pool;
+      secondaryInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+      secondaryInfo.commandBufferCount = 1;
+      if (vkAllocateCommandBuffers(m_Device, &secondaryInfo, &slot.buffer) != VK_SUCCESS)
+      {
+        G_EXCEPT("Failed to allocate secondary command buffer");
+      }
+      if (DEPTH_PREPASS && vkAllocateCommandBuffers(m_Device, &secondaryInfo, &slot.depthBuffer) != VK_SUCCESS)
+      {
+        G_EXCEPT("Failed to allocate depth pre-pass command buffer");
+      }
+    }
+  }
+
+  return;
+}
+
+void GraphicsHandler::createSyncObjects(void)
+{
+  VkResult result;
 
   VkSemaphoreCreateInfo semaphoreCreateInfo{};
   semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1289,147 +2084,163 @@ void GraphicsHandler::createSyncObjects(void)
   return;
 }
 
-void GraphicsHandler::createDescriptorPool(void)
+void GraphicsHandler::createDescriptorSets(void)
 {
-  VkResult result;
+  descriptors = std::make_unique<DescriptorAllocator>(m_Device);
 
-  VkDescriptorPoolSize modelPool{};
-  modelPool.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-  modelPool.descriptorCount = static_cast<uint32_t>(m_SwapImages.size());
-
-  VkDescriptorPoolSize viewPool{};
-  viewPool.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-  viewPool.descriptorCount = static_cast<uint32_t>(m_SwapImages.size());
-
-  VkDescriptorPoolSize projPool{};
-  projPool.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-  projPool.descriptorCount = static_cast<uint32_t>(m_SwapImages.size());
-
-  // Container for the pool size structs
-  std::vector<VkDescriptorPoolSize> poolDescriptors = {modelPool, viewPool, projPool};
-
-  VkDescriptorPoolCreateInfo poolInfo{};
-  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-  poolInfo.pNext = nullptr;
-  poolInfo.flags = 0; // Optional flag for allowing freeing after creation
-  poolInfo.poolSizeCount = static_cast<uint32_t>(poolDescriptors.size());
-  poolInfo.pPoolSizes = poolDescriptors.data();
-  // maximum number of sets that can be allocated
-  poolInfo.maxSets =
-      static_cast<uint32_t>(m_SwapImages.size()) * static_cast<uint32_t>(m_DescriptorLayouts.size());
-
-  // Create the descriptor pool
-  result = vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool);
-  if (result != VK_SUCCESS)
-  {
-    G_EXCEPT("Failed to create descriptor pool");
-  }
+  // The view/projection block sits at offset 0, the draw data after it bound as either kind of buffer
+  VkDeviceSize alignment = std::max(memory->getUniformAlignment(),
+                                    selectedDevice->devProperties.properties.limits.minStorageBufferOffsetAlignment);
+  m_DrawDataOffset = (sizeof(UniformVPBuffer) + alignment - 1) / alignment * alignment;
+
+  createFrameUniforms();
   return;
 }
 
-void GraphicsHandler::createDescriptorSets(void)
+void GraphicsHandler::createFrameUniforms(void)
 {
-  for (const auto &image : m_SwapImages)
-  {
-    // Layout[0] = set0 -- Model + View bindings
-    // Layout[1] = set1 -- Projection binding only
-    m_Set0Allocs.push_back(m_DescriptorLayouts[0]);
-    m_Set1Allocs.push_back(m_DescriptorLayouts[1]);
-  }
+  // Uniform slots are the wider of the two layouts, the packed table fits in the same space
+  const VkDeviceSize drawDataSize = DRAW_DATA_MAX_DRAWS * drawData->getUniformStride();
 
-  // Set0 -- Model + View -- Allocations
-  VkDescriptorSetAllocateInfo set0AllocInfo{};
-  set0AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-  set0AllocInfo.pNext = nullptr;
-  set0AllocInfo.descriptorPool = m_DescriptorPool;
-  set0AllocInfo.descriptorSetCount = static_cast<uint32_t>(m_Set0Allocs.size());
-  set0AllocInfo.pSetLayouts = m_Set0Allocs.data();
+  for (size_t i = m_FrameUniforms.size(); i < m_SwapImages.size(); i++)
+  {
+    FrameUniforms uniforms;
+    uniforms.buffer = memory->createUniformBuffer(m_DrawDataOffset + drawDataSize,
+                                                  &uniforms.mapped,
+                                                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
-  // Set1 -- Projection -- Allocations
-  VkDescriptorSetAllocateInfo set1AllocInfo{};
-  set1AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-  set1AllocInfo.pNext = nullptr;
-  set1AllocInfo.descriptorPool = m_DescriptorPool;
-  set1AllocInfo.descriptorSetCount = static_cast<uint32_t>(m_Set1Allocs.size());
-  set1AllocInfo.pSetLayouts = m_Set1Allocs.data();
+    // Identity until something writes them, never garbage
+    UniformVPBuffer viewProjection;
+    viewProjection.view = glm::mat4(1.0f);
+    viewProjection.proj = glm::mat4(1.0f);
+    memcpy(uniforms.mapped, &viewProjection, sizeof(viewProjection));
 
-  // Set 0 Allocations
-  m_ModelViewSets.resize(m_Set0Allocs.size());
-  // Allocate sets
-  if (vkAllocateDescriptorSets(m_Device, &set0AllocInfo, m_ModelViewSets.data()) != VK_SUCCESS)
-  {
-    G_EXCEPT("Failed to allocate model & view descriptor sets");
-  }
+    if (drawData->isAvailable(DrawDataPath::InstanceTable))
+    {
+      uniforms.drawTable = bindless->addBuffer(uniforms.buffer,
+                                               m_DrawDataOffset,
+                                               DRAW_DATA_MAX_DRAWS * sizeof(DrawConstants));
+    }
 
-  // Set 1 Allocations
-  m_ProjectionSets.resize(m_Set1Allocs.size());
-  if (vkAllocateDescriptorSets(m_Device, &set1AllocInfo, m_ProjectionSets.data()) != VK_SUCCESS)
-  {
-    G_EXCEPT("Failed to allocate projection descriptor sets");
+    m_FrameUniforms.push_back(uniforms);
   }
   return;
 }
 
-void GraphicsHandler::bindDescriptorSets(void)
+void GraphicsHandler::createDrawDataTuner(void)
 {
-  for (const auto &image : m_SwapImages)
+  const VkPhysicalDeviceLimits &limits = selectedDevice->devProperties.properties.limits;
+
+  // Without timestamp bits on the graphics queue, tuning goes by recording time alone
+  bool gpuTimed = DRAW_DATA_TUNING_FRAMES > 0 &&
+                  limits.timestampPeriod > 0.0f &&
+                  selectedDevice->queueFamiles[selectedDevice->graphicsFamilyIndex].timestampValidBits > 0;
+  if (gpuTimed)
+  {
+    VkQueryPoolCreateInfo queryInfo{};
+    queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryInfo.pNext = nullptr;
+    queryInfo.flags = 0;
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = static_cast<uint32_t>(2 * m_SwapImages.size());
+    queryInfo.pipelineStatistics = 0;
+
+    if (vkCreateQueryPool(m_Device, &queryInfo, nullptr, &m_TimestampPool) != VK_SUCCESS)
+    {
+      G_EXCEPT("Failed to create timestamp query pool");
+    }
+    // Images a recreated swapchain adds beyond these go untimed
+    m_FrameTimings.resize(m_SwapImages.size());
+  }
+
+  drawData = std::make_unique<DrawDataTuner>(limits, DRAW_DATA_TUNING_FRAMES, gpuTimed);
+
+  // Every swap image needs a table slot of its own
+  if (bindless->getBufferCapacity() < m_SwapImages.size())
+  {
+    drawData->disable(DrawDataPath::InstanceTable);
+  }
+  // Shaders without the per-draw uniform binding can only take push constants or the table
+  if (!declaresBinding(0, 0))
   {
+    drawData->disable(DrawDataPath::DynamicUniform);
   }
+
+  std::cout << "\t[+] " << limits.maxPushConstantsSize << " bytes of push constants, "
+            << getDrawDataPathName(drawData->getPath()) << " until tuned" << std::endl;
   return;
 }
 
-void GraphicsHandler::bindescriptorsets(void)
+void GraphicsHandler::readFrameTimestamps(uint32_t imageIndex)
 {
-  for (size_t i = 0; i < m_SwapImages.size(); i++)
+  if (m_TimestampPool == VK_NULL_HANDLE ||
+      imageIndex >= m_FrameTimings.size() ||
+      !m_FrameTimings[imageIndex].pending)
   {
-    // Each descriptor info needs it's own descriptor set
-    // VkDescriptorBufferInfo bufferInfo{};
-    // bufferInfo.buffer = m_UniformBuffers[i];
-    // bufferInfo.offset = 0;
-    // bufferInfo.range = sizeof(UniformBufferObject);
-
-    VkDescriptorBufferInfo uniformModelBufferInfo{};
-    uniformModelBufferInfo.buffer = m_UniformModelBuffers[i];
-    uniformModelBufferInfo.offset = 0;
-    uniformModelBufferInfo.range = sizeof(UniformModelBuffer);
-
-    VkDescriptorBufferInfo uniformVPBufferInfo{};
-    uniformVPBufferInfo.buffer = m_UniformVPBuffers[i];
-    uniformVPBufferInfo.offset = 0;
-    uniformVPBufferInfo.range = sizeof(UniformVPBuffer);
-
-    // Descriptor writes container
-    std::array<VkWriteDescriptorSet, 2> descriptorSets{};
+    return;
+  }
+  m_FrameTimings[imageIndex].pending = false;
 
-    // Describe DescriptorWrites for uniform buffer object
-    descriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorSets[0].dstSet = m_DescriptorSets[i];
-    descriptorSets[0].dstBinding = 0;
-    descriptorSets[0].dstArrayElement = 0;
-    descriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    descriptorSets[0].descriptorCount = 1;
-    descriptorSets[0].pBufferInfo = &uniformModelBufferInfo;
-    descriptorSets[0].pImageInfo = nullptr;
-    descriptorSets[0].pTexelBufferView = nullptr;
+  // No wait flag, a result that is not ready is dropped rather than stalling the frame
+  std::array<uint64_t, 2> timestamps{};
+  if (vkGetQueryPoolResults(m_Device,
+                            m_TimestampPool,
+                            2 * imageIndex,
+                            2,
+                            sizeof(timestamps),
+                            timestamps.data(),
+                            sizeof(uint64_t),
+                            VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+  {
+    return;
+  }
 
-    descriptorSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorSets[1].dstSet = m_DescriptorSets[i];
-    descriptorSets[1].dstBinding = 1;
-    descriptorSets[1].dstArrayElement = 0;
-    descriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    descriptorSets[1].descriptorCount = 1;
-    descriptorSets[1].pBufferInfo = &uniformVPBufferInfo;
-    descriptorSets[1].pImageInfo = nullptr;
-    descriptorSets[1].pTexelBufferView = nullptr;
+  // Only the low timestampValidBits bits count, the counter may wrap in between
+  uint32_t validBits = selectedDevice->queueFamiles[selectedDevice->graphicsFamilyIndex].timestampValidBits;
+  uint64_t mask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+  uint64_t ticks = (timestamps[1] - timestamps[0]) & mask;
 
-    // Update the descriptor set specified in writeInfo
-    vkUpdateDescriptorSets(m_Device,
-                           static_cast<uint32_t>(descriptorSets.size()),
-                           descriptorSets.data(),
-                           0,
-                           nullptr);
-  }
+  double milliseconds = ticks * static_cast<double>(selectedDevice->devProperties.properties.limits.timestampPeriod) / 1e6;
+  drawData->addGpuSample(m_FrameTimings[imageIndex].drawData, milliseconds);
+  return;
+}
 
+/*
+  Called after the image's fence wait, the sets it handed out last
+  time are no longer read. The writes are the same every time an
+  image comes round, within a frame repeated requests hit the cache
+*/
+void GraphicsHandler::acquireFrameSets(uint32_t imageIndex)
+{
+  descriptors->beginFrame(imageIndex);
+
+  // Only what the shaders declare is written, the rest would not be in the layout
+  auto declared = [this](uint32_t set, std::vector<DescriptorWrite> writes) {
+    writes.erase(std::remove_if(writes.begin(), writes.end(), [this, set](const DescriptorWrite &write)
+                                { return !declaresBinding(set, write.binding); }),
+                 writes.end());
+    return writes;
+  };
+
+  // Binding 0 covers one draw's constants, the dynamic offset picks which
+  VkBuffer buffer = m_FrameUniforms[imageIndex].buffer;
+  m_FrameSets[0] = descriptors->getSet(m_DescriptorLayouts[0],
+                                       declared(0, {DescriptorWrite::forBuffer(0,
+                                                                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                                                                               buffer,
+                                                                               m_DrawDataOffset,
+                                                                               sizeof(DrawConstants)),
+                                                    DescriptorWrite::forBuffer(1,
+                                                                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                                                               buffer,
+                                                                               0,
+                                                                               sizeof(UniformVPBuffer))}));
+  m_FrameSets[1] = descriptors->getSet(m_DescriptorLayouts[1],
+                                       declared(1, {DescriptorWrite::forBuffer(0,
+                                                                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                                                               buffer,
+                                                                               0,
+                                                                               sizeof(UniformVPBuffer))}));
   return;
 }
 
@@ -1527,16 +2338,17 @@ bool GraphicsHandler::loadDebugUtils(void)
   return true;
 }
 
-VkShaderModule GraphicsHandler::createShaderModule(const std::vector<char> &code)
+VkShaderModule GraphicsHandler::createShaderModule(const FileView &code)
 {
   VkShaderModule module;
 
+  // Read straight from the mapping, which is page aligned
   VkShaderModuleCreateInfo moduleInfo{};
   moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
   moduleInfo.pNext = nullptr;
   moduleInfo.flags = 0;
-  moduleInfo.codeSize = code.size();
-  moduleInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+  moduleInfo.codeSize = code.getSize();
+  moduleInfo.pCode = code.getWords();
 
   if (vkCreateShaderModule(m_Device, &moduleInfo, nullptr, &module) != VK_SUCCESS)
   {
@@ -1678,63 +2490,14 @@ VkExtent2D GraphicsHandler::chooseSwapChainExtent(void)
   }
 }
 
-std::vector<char> GraphicsHandler::readFile(std::string filename)
-{
-  size_t fileSize;
-  std::ifstream file;
-  std::vector<char> buffer;
-
-  // check if file exists
-  try
-  {
-    std::filesystem::exists(filename);
-    file.open(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open())
-    {
-      std::ostringstream oss;
-      oss << "Failed to open file " << filename;
-      G_EXCEPT(oss.str());
-    }
-
-    // prepare buffer to hold shader bytecode
-    fileSize = (size_t)file.tellg();
-    buffer.resize(fileSize);
-
-    // go back to beginning of file and read in
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-    file.close();
-  }
-  catch (std::filesystem::filesystem_error &e)
-  {
-    std::ostringstream oss;
-    oss << "Filesystem Exception : " << e.what() << std::endl;
-    G_EXCEPT(oss.str());
-  }
-  catch (std::exception &e)
-  {
-    std::ostringstream oss;
-    oss << "Standard Exception : " << e.what();
-    G_EXCEPT(oss.str());
-  }
-  catch (...)
-  {
-    G_EXCEPT("Unhandled exception while loading a file");
-  }
-
-  if (buffer.empty())
-  {
-    G_EXCEPT("File reading operation returned empty buffer");
-  }
-
-  return buffer;
-}
-
 void GraphicsHandler::recreateSwapChain(void)
 {
   vkDeviceWaitIdle(m_Device);
 
+  // Nothing is in flight, good time to pack geometry
+  defragmentGeometry();
+  destroyRetiredPipelines(true);
+
   /*
     Ensure resources weren't previously destroyed before
     attempting to do so again
@@ -1772,17 +2535,20 @@ void GraphicsHandler::recreateSwapChain(void)
 
   createGraphicsPipeline();
 
-  createFrameBuffers();
+  createColorResources();
+
+  createDepthResources();
 
-  createDescriptorPool();
+  createFrameBuffers();
 
-  createDescriptorSets();
+  // Descriptor pools outlive the swapchain, only new images need uniforms
+  createFrameUniforms();
 
   createCommandBuffers();
 
-  // Recreate the camera
-  camera = std::make_unique<Camera>(m_SurfaceDetails.capabilities.currentExtent.width,
-                                    m_SurfaceDetails.capabilities.currentExtent.height);
+  // The simulation thread owns the camera, it only picks up the new aspect
+  m_AspectRatio = m_SurfaceDetails.capabilities.currentExtent.width /
+                  static_cast<float>(m_SurfaceDetails.capabilities.currentExtent.height);
 
   std::cout << "\t[+] Done!" << std::endl;
   return;
@@ -1904,17 +2670,20 @@ void GraphicsHandler::updateUniformModelBuffer(uint32_t imageIndex)
   return;
 }
 
-void GraphicsHandler::updateUniformVPBuffer(uint32_t imageIndex)
+/*
+  The packet's camera at the same point between ticks the draws
+  are culled and interpolated at. The image's fence must have
+  been waited on, the block sits in the buffer its draws read
+*/
+void GraphicsHandler::updateUniformVPBuffer(uint32_t imageIndex, const FramePacket &packet, float alpha)
 {
-  // UniformVPBuffer uvp;
-  // // Point left hand down to visualize the axis
-  // // Origin is at top left
-  // uvp.view = glm::lookAt(camera->getPosition(), camera->getPosition() + camera->DEFAULT_FORWARD_VECTOR, glm::vec3(0.0f, -1.0f, 0.0f));
-  // uvp.proj = glm::perspective(glm::radians(45.0f), selectedSwapExtent.width / (float)selectedSwapExtent.height, 0.1f, 100.0f);
-  // uvp.proj[1][1] *= -1;
+  UniformVPBuffer uvp;
+  uvp.view = packet.getView(alpha);
+  // Reverse-Z unless turned off, the depth compare and clear follow the camera
+  uvp.proj = packet.projection;
 
-  // // Transfer
-  // memcpy(m_UniformVPPtrs[imageIndex], &uvp, sizeof(UniformVPBuffer));
+  // Transfer
+  memcpy(m_FrameUniforms[imageIndex].mapped, &uvp, sizeof(UniformVPBuffer));
   return;
 }
 
@@ -1983,7 +2752,7 @@ void GraphicsHandler::endSingleCommands(VkCommandBuffer commandBuffer)
   return;
 }
 
-VkImageView GraphicsHandler::createImageView(VkImage image, VkFormat format)
+VkImageView GraphicsHandler::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect)
 {
   VkImageView imageView;
 
@@ -1999,7 +2768,7 @@ VkImageView GraphicsHandler::createImageView(VkImage image, VkFormat format)
       VK_COMPONENT_SWIZZLE_IDENTITY,
       VK_COMPONENT_SWIZZLE_IDENTITY,
       VK_COMPONENT_SWIZZLE_IDENTITY};
-  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.aspectMask = aspect;
   viewInfo.subresourceRange.baseMipLevel = 0;
   viewInfo.subresourceRange.levelCount = 1;
   viewInfo.subresourceRange.baseArrayLayer = 0;
@@ -2014,147 +2783,198 @@ VkImageView GraphicsHandler::createImageView(VkImage image, VkFormat format)
 }
 
 /*
-  THIS FUNCTION MUST BE CALLED AND PASSED MODELCLASS OBJECTS IN THE SAME ORDER THEY
-  ARE CALLED IN ModelClass->loadModelData()
-
-  loadModelData() GENERATES OFFSETS FROM WHAT THEY ARE GIVEN
+  Model data is built on a worker and copied into the
+  geometry pool's vertex and index heaps by the streamer
 
-  Loads vertex data into the buffer
+  Vertex and Index data are device local
 */
-// void GraphicsHandler::processModelData(ModelClass *modelObj)
-// {
-//   std::cout << "[+] Moving allocated model :: " << modelObj->typeName
-//             << " :: into gpu memory" << std::endl;
-
-//   VkResult result;
-
-//   VkBuffer vertexStagingBuffer{};
-//   VkDeviceMemory vertexStagingMemory{};
-
-//   VkBuffer indexStagingBuffer{};
-//   VkDeviceMemory indexStagingMemory{};
-
-//   // Create the vertex staging buffer
-//   createBuffer(modelObj->vertexDataSize,
-//                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-//                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-//                vertexStagingBuffer,
-//                vertexStagingMemory);
-
-//   // Map vertex staging
-//   void *vertexDataPtr;
-//   result = vkMapMemory(m_Device,
-//                        vertexStagingMemory,
-//                        0,
-//                        modelObj->vertexDataSize,
-//                        0,
-//                        &vertexDataPtr);
-//   if (result != VK_SUCCESS)
-//   {
-//     G_EXCEPT("Failed to map memory for processing of model data");
-//   }
-//   // fill vertex stage
-//   memcpy(vertexDataPtr, modelObj->vertices.data(), modelObj->vertexDataSize);
-
-//   // Unmap vertex staging
-//   vkUnmapMemory(m_Device, vertexStagingMemory);
-
-//   // Copy vertex stage -> vertex buffer
-//   copyBuffer(vertexStagingBuffer, m_VertexBuffer, modelObj->vertexStartOffset, modelObj->vertexDataSize);
-//   std::cout << "Copying vertex data into buffer at dst offset -> " << modelObj->vertexStartOffset << std::endl;
-
-//   // create index stage
-//   createBuffer(modelObj->indexDataSize,
-//                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-//                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-//                indexStagingBuffer,
-//                indexStagingMemory);
-
-//   // Map index stage
-//   void *indexDataPtr;
-//   result = vkMapMemory(m_Device,
-//                        indexStagingMemory,
-//                        0,
-//                        modelObj->indexDataSize,
-//                        0,
-//                        &indexDataPtr);
-//   if (result != VK_SUCCESS)
-//   {
-//     G_EXCEPT("Failed to map memory for processing of model data");
-//   }
+void GraphicsHandler::loadEntities(void)
+{
+  std::cout << "\tModel -> " << Human.typeName << std::endl;
+  modelAssets[&Human] = streamer->requestModel(Human, glm::vec3(0.0f));
 
-//   // fill index stage
-//   memcpy(indexDataPtr, modelObj->indices.data(), modelObj->indexDataSize);
+  // Grid vertices only exist in debug builds
+  if (!grid.empty())
+  {
+    processGridData();
+  }
+  return;
+}
 
-//   // unmap index stage
-//   vkUnmapMemory(m_Device, indexStagingMemory);
+/*
+  Holes left by unloaded models are only packed once enough
+  free space is splintered, the device must be idle
+*/
+void GraphicsHandler::defragmentGeometry(void)
+{
+  if (memory == nullptr || memory->geometry->getFragmentation() < 0.5f)
+  {
+    return;
+  }
 
-//   // Copy index stage -> index buffer
-//   copyBuffer(indexStagingBuffer, m_IndexBuffer, modelObj->indexStartOffset, modelObj->indexDataSize);
-//   std::cout << "Copying index data into buffer at dst offset -> " << modelObj->indexStartOffset << std::endl;
+  std::cout << "[+] Defragmenting geometry pool" << std::endl;
+  VkCommandBuffer commandBuffer = beginSingleCommands();
+  memory->geometry->defragment(commandBuffer);
+  endSingleCommands(commandBuffer);
 
-//   // cleanup vertex stage
-//   vkDestroyBuffer(m_Device, vertexStagingBuffer, nullptr);
-//   vkFreeMemory(m_Device, vertexStagingMemory, nullptr);
+  memory->geometry->releaseRetired();
 
-//   // cleanup index stage
-//   vkDestroyBuffer(m_Device, indexStagingBuffer, nullptr);
-//   vkFreeMemory(m_Device, indexStagingMemory, nullptr);
-//   return;
-// }
+  // Heaps in the queued keys may have moved, sort again on the next frame
+  m_QueuedTick = UINT64_MAX;
+  return;
+}
 
-/*
-  The index buffer and vertex buffer have been created
+// The textures of the meshes entities were made with, meshes sharing one share the request
+void GraphicsHandler::loadTextures(void)
+{
+  for (const ModelClass *model : renderMeshes)
+  {
+    if (!model->texturePath.empty() && textureAssets.count(model->texturePath) == 0)
+    {
+      textureAssets[model->texturePath] = streamer->requestTexture(model->texturePath, glm::vec3(0.0f));
+    }
+  }
+  return;
+}
 
-  This will load...
-  vertex data into the vertex buffer AND
-  index data into the index buffer AND
-  MVP matrice data into an MVP buffer
+void GraphicsHandler::streamAssets(const glm::vec3 &cameraPosition)
+{
+  // Slots freed frames ago are no longer read by anything in flight
+  bindless->advanceFrame();
 
-  Vertex and Index data are device local
-  MVP matrice data buffer is HOST_VISIBLE and can simply be written to each frame
+  streamer->updatePriorities(cameraPosition);
+  streamer->pump();
+  updateBindlessTextures();
+  return;
+}
+
+/*
+  Descriptors are written while earlier frames are still pending,
+  which update-after-bind allows for slots those frames never index.
+  Slots and textures given up here are only reused or destroyed
+  once those frames have completed
 */
-// void GraphicsHandler::loadEntities(void)
-// {
-//   std::pair<int, int> prevBufferOffsets = {0, 0};
-//   std::pair<int, int> nextBufferOffsets = {0, 0};
+void GraphicsHandler::updateBindlessTextures(void)
+{
+  // Textures no mesh samples any more are evicted, or cancelled when still streaming
+  for (auto asset = textureAssets.begin(); asset != textureAssets.end();)
+  {
+    const std::string &path = asset->first;
+    bool used = std::any_of(renderMeshes.begin(), renderMeshes.end(), [&path](const ModelClass *model)
+                            { return model->texturePath == path; });
+    if (used)
+    {
+      asset++;
+      continue;
+    }
+    if (!streamer->evict(asset->second))
+    {
+      streamer->cancel(asset->second);
+    }
+    asset = textureAssets.erase(asset);
+  }
 
-//   std::cout << "\tModel -> " << Human.typeName << std::endl;
-//   nextBufferOffsets = Human.loadModelData(prevBufferOffsets);
-//   std::cout << "Model Previous -> " << prevBufferOffsets.first << ", " << prevBufferOffsets.second << std::endl;
-//   std::cout << "Model next -> " << nextBufferOffsets.first << ", " << nextBufferOffsets.second << std::endl;
+  // Slots of textures that are no longer resident go back to the array
+  bool changed = false;
+  for (auto slot = textureSlots.begin(); slot != textureSlots.end();)
+  {
+    auto asset = textureAssets.find(slot->first);
+    if (asset != textureAssets.end() && streamer->isResident(asset->second))
+    {
+      slot++;
+      continue;
+    }
+    bindless->removeTexture(slot->second);
+    slot = textureSlots.erase(slot);
+    changed = true;
+  }
 
-//   if (nextBufferOffsets.first == -1 ||
-//       nextBufferOffsets.second == -1)
-//   {
-//     G_EXCEPT("Model data would exceed allocated buffer limits!");
-//   }
+  for (const auto &[path, handle] : textureAssets)
+  {
+    if (textureSlots.count(path) != 0 || !streamer->isResident(handle))
+    {
+      continue;
+    }
+    const Texture &texture = textures->get(path);
+    uint32_t slot = bindless->addTexture(texture.view, texture.sampler);
+    if (slot == BINDLESS_INVALID_INDEX)
+    {
+      G_EXCEPT("Bindless texture array is full");
+    }
+    textureSlots[path] = slot;
+    changed = true;
+  }
 
-//   // Update offset
-//   prevBufferOffsets = nextBufferOffsets;
+  if (!changed && meshTextureSlots.size() == renderMeshes.size())
+  {
+    return;
+  }
+  meshTextureSlots.assign(renderMeshes.size(), BINDLESS_INVALID_INDEX);
+  for (size_t mesh = 0; mesh < renderMeshes.size(); mesh++)
+  {
+    auto slot = textureSlots.find(renderMeshes[mesh]->texturePath);
+    if (slot != textureSlots.end())
+    {
+      meshTextureSlots[mesh] = slot->second;
+    }
+  }
+  return;
+}
 
-//   // Load grid vertices
-//   nextBufferOffsets = loadGridVertices(prevBufferOffsets);
-//   std::cout << "Grid Previous -> " << prevBufferOffsets.first << ", " << prevBufferOffsets.second << std::endl;
-//   std::cout << "Grid next -> " << nextBufferOffsets.first << ", " << nextBufferOffsets.second << std::endl;
+void GraphicsHandler::createEntities(void)
+{
+  // Bounds are filled in once the model has streamed in
+  MeshId humanMesh = entities.addMesh(MeshBounds{});
+  renderMeshes.push_back(&Human);
 
-//   if (nextBufferOffsets.first == -1 ||
-//       nextBufferOffsets.second == -1)
-//   {
-//     G_EXCEPT("Grid vertices would exceed buffer limits!");
-//   }
+  Entity human = entities.create(COMPONENT_TRANSFORM | COMPONENT_MESH);
+  entities.setMesh(human, humanMesh);
 
-//   // update offset
-//   prevBufferOffsets = nextBufferOffsets;
+  // Placed through the hierarchy so anything attached later follows it
+  TransformNode humanNode = transforms->create(TRANSFORM_NODE_INVALID, human);
+  transforms->setLocal(humanNode, glm::vec3(0.0f, 0.0f, 0.0f));
+  return;
+}
 
-//   std::cout << "After grid -> " << prevBufferOffsets.first << ", " << prevBufferOffsets.second << std::endl;
-//   std::cout << "After grid -> " << nextBufferOffsets.first << ", " << nextBufferOffsets.second << std::endl;
+/*
+  One simulation tick. Each pass walks the component arrays
+  once, the packed instances are what recordCommandBuffer draws.
+  Runs on the simulation thread, touches nothing the
+  render thread writes besides the atomic aspect ratio
+*/
+void GraphicsHandler::updateEntities(FramePacket &packet)
+{
+  // Bounds are written by the decode job, the streamer's lock orders them before Resident
+  for (MeshId mesh = 0; mesh < renderMeshes.size(); mesh++)
+  {
+    const ModelClass *model = renderMeshes[mesh];
+    if (streamer->isResident(modelAssets[model]))
+    {
+      entities.setMeshBounds(mesh, {model->boundsCenter, model->boundsRadius});
+    }
+  }
 
-//   // After all model data is loaded we will pass those to an actual buffer
-//   processModelData(&Human);
-//   processGridData();
-//   return;
-// }
+  // Matrices are only rebuilt when the camera moved or the window was resized
+  camera->setAspectRatio(m_AspectRatio.load());
+  camera->update();
+  packet.cameraPosition = camera->getPosition();
+  packet.cameraForward = camera->getForward();
+  packet.cameraMoved = packet.cameraPosition != packet.previousCameraPosition ||
+                       packet.cameraForward != packet.previousCameraForward;
+  packet.projection = camera->getProjection();
+  packet.view = camera->getView();
+  packet.viewProjection = camera->getViewProjection();
+  packet.frustum = camera->getFrustum();
+
+  // Last tick's matrices become the previous ones, then only what moved since is recomputed
+  beginTransformTick(entities, jobs.get());
+  transforms->update(entities);
+  updateWorldMatrices(entities, jobs.get());
+  updateWorldBounds(entities, jobs.get());
+  cullEntities(entities, packet.frustum, jobs.get());
+  packInstances(entities, packet.instances, packet.batches);
+  return;
+}
 
 void GraphicsHandler::createGridVertices(void)
 {
@@ -2182,72 +3002,72 @@ void GraphicsHandler::createGridVertices(void)
   return;
 }
 
-std::pair<int, int> GraphicsHandler::loadGridVertices(std::pair<int, int> previousOffsets)
+void GraphicsHandler::processGridData(void)
 {
-  gridStartOffset = previousOffsets.first;
-  int endVertexOffset = previousOffsets.first + gridVertexDataSize;
+  std::cout << "[+] Loading grid vertices into buffer" << std::endl;
 
-  if (endVertexOffset > VERTEX_BUFFER_SIZE)
-  {
-    std::cout << "\t[-] Self check : Grid data will exceed vertex buffer size" << std::endl;
-    return {-1, -1};
-  }
+  gridGeometry = memory->geometry->allocate(gridVertexDataSize, 0);
+
+  VkCommandBuffer commandBuffer = beginSingleCommands();
+  memory->geometry->upload(commandBuffer, gridGeometry, grid.data(), nullptr);
+  endSingleCommands(commandBuffer);
 
-  return {endVertexOffset, previousOffsets.second};
+  memory->geometry->releaseRetired();
+  return;
 }
 
-void GraphicsHandler::processGridData(void)
+/*
+  The renderer draws one packet for several frames at a growing
+  alpha, the order only changes with a new packet. Items are
+  ordered front to back by the tick's camera, close enough for the
+  interpolated one
+*/
+void GraphicsHandler::buildRenderQueue(const FramePacket &packet)
 {
-  std::cout << "[+] Loading grid vertices into buffer" << std::endl;
-
-  VkResult result;
-
-  VkBuffer vertexStagingBuffer{};
-  VkDeviceMemory vertexStagingMemory{};
-
-  // Create the vertex staging buffer
-  createBuffer(gridVertexDataSize,
-               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               vertexStagingBuffer,
-               vertexStagingMemory);
-
-  // Map vertex staging
-  void *vertexDataPtr;
-  result = vkMapMemory(m_Device,
-                       vertexStagingMemory,
-                       0,
-                       gridVertexDataSize,
-                       0,
-                       &vertexDataPtr);
-  if (result != VK_SUCCESS)
+  if (packet.tick == m_QueuedTick)
   {
-    G_EXCEPT("Failed to map memory for processing of grid data");
+    return;
   }
-  // fill vertex stage
-  memcpy(vertexDataPtr, grid.data(), gridVertexDataSize);
+  m_QueuedTick = packet.tick;
+  m_RenderQueue.clear();
 
-  // Unmap vertex staging
-  vkUnmapMemory(m_Device, vertexStagingMemory);
+  // One of each so far, the key keeps room for more
+  const uint8_t pipelineId = 0;
+  const uint8_t descriptorSetId = 0;
 
-  // Copy vertex stage -> vertex buffer
-  copyBuffer(vertexStagingBuffer, m_VertexBuffer, gridStartOffset, gridVertexDataSize);
-  std::cout << "Copying grid data into buffer at dst offset -> " << gridStartOffset << std::endl;
+  for (const auto &batch : packet.batches)
+  {
+    const ModelClass &model = *renderMeshes[batch.mesh];
+
+    // Streamed in, skipped until its geometry is resident
+    if (model.geometry == GEOMETRY_INVALID_HANDLE)
+    {
+      continue;
+    }
+    const GeometryAllocation &allocation = memory->geometry->get(model.geometry);
 
-  // Cleanup
-  vkDestroyBuffer(m_Device, vertexStagingBuffer, nullptr);
-  vkFreeMemory(m_Device, vertexStagingMemory, nullptr);
+    for (uint32_t instance = batch.firstInstance; instance < batch.firstInstance + batch.instanceCount; instance++)
+    {
+      glm::vec3 offset = glm::vec3(packet.instances[instance].model[3]) - packet.cameraPosition;
+      DrawItem item;
+      item.key = makeDrawKey(pipelineId,
+                             descriptorSetId,
+                             static_cast<uint8_t>(allocation.vertexHeap),
+                             static_cast<uint16_t>(batch.mesh),
+                             glm::dot(offset, offset));
+      item.instance = instance;
+      item.mesh = batch.mesh;
+      m_RenderQueue.push(item);
+    }
+  }
+  m_RenderQueue.sort();
   return;
 }
 
-void GraphicsHandler::recordCommandBuffer(uint32_t imageIndex)
+void GraphicsHandler::recordCommandBuffer(uint32_t imageIndex, const FramePacket &packet, float alpha)
 {
   VkResult result;
 
-  // Begin recording command buffer
-  UniformModelBuffer identityMatrix;
-  identityMatrix.model = glm::mat4(1.0);
-
   VkCommandBufferBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   beginInfo.pNext = nullptr;
@@ -2260,6 +3080,43 @@ void GraphicsHandler::recordCommandBuffer(uint32_t imageIndex)
     G_EXCEPT("Failed to begin command buffer!");
   }
 
+  // The image's fence has been waited on, its last timestamps are written
+  readFrameTimestamps(imageIndex);
+
+  buildRenderQueue(packet);
+  const uint32_t itemCount = static_cast<uint32_t>(m_RenderQueue.size());
+
+  /*
+    Items and the grid each take a draw data slot. Frames with more
+    draws than slots, or images without a table, fall back to push
+    constants when they fit and are left out of tuning
+  */
+  m_FrameDrawData = drawData->beginFrame();
+  if (m_FrameDrawData.path != DrawDataPath::PushConstants)
+  {
+    bool fits = itemCount < DRAW_DATA_MAX_DRAWS &&
+                (m_FrameDrawData.path != DrawDataPath::InstanceTable ||
+                 m_FrameUniforms[imageIndex].drawTable != BINDLESS_INVALID_INDEX);
+    if (!fits && drawData->isAvailable(DrawDataPath::PushConstants))
+    {
+      m_FrameDrawData.path = DrawDataPath::PushConstants;
+      m_FrameDrawData.measured = false;
+    }
+    else if (!fits && m_FrameDrawData.path == DrawDataPath::InstanceTable)
+    {
+      m_FrameDrawData.path = DrawDataPath::DynamicUniform;
+      m_FrameDrawData.measured = false;
+    }
+  }
+
+  // Render pass time of frames being tuned
+  bool timed = m_FrameDrawData.measured && imageIndex < m_FrameTimings.size();
+  if (timed)
+  {
+    vkCmdResetQueryPool(m_CommandBuffers[imageIndex], m_TimestampPool, 2 * imageIndex, 2);
+    vkCmdWriteTimestamp(m_CommandBuffers[imageIndex], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampPool, 2 * imageIndex);
+  }
+
   // Begin render pass
   VkRenderPassBeginInfo renderPassInfo{};
   renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -2269,69 +3126,78 @@ void GraphicsHandler::recordCommandBuffer(uint32_t imageIndex)
   renderPassInfo.renderArea.offset = {0, 0};
   renderPassInfo.renderArea.extent = selectedSwapExtent;
 
-  VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-  renderPassInfo.clearValueCount = 1;
-  renderPassInfo.pClearValues = &clearColor;
+  // Depth clears to the far end of the range, 0 under reverse-Z
+  std::array<VkClearValue, 2> clearValues{};
+  clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+  clearValues[1].depthStencil = {camera->isReverseZ() ? 0.0f : 1.0f, 0};
+  renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+  renderPassInfo.pClearValues = clearValues.data();
 
+  // Everything inside the pass comes from secondary buffers
   vkCmdBeginRenderPass(m_CommandBuffers[imageIndex],
                        &renderPassInfo,
-                       VK_SUBPASS_CONTENTS_INLINE);
-
-  vkCmdBindPipeline(m_CommandBuffers[imageIndex],
-                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    m_Pipeline);
-
-  // Due to using dynamic state, primitive topology must be set
-  // render pass
-  vkCmdSetPrimitiveTopologyEXT(m_CommandBuffers[imageIndex], VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
-
-  // Bind index buffer here
-  vkCmdBindIndexBuffer(m_CommandBuffers[imageIndex],
-                       m_IndexBuffer,
-                       0,
-                       VK_INDEX_TYPE_UINT16);
-  // Bind vertex buffers
-  VkBuffer vertexBuffers[] = {m_VertexBuffer};
-  std::vector<VkDeviceSize> offsets = {Human.vertexStartOffset};
-  vkCmdBindVertexBuffers(m_CommandBuffers[imageIndex], 0, 1, vertexBuffers, offsets.data());
-
-  // Bind our descriptor sets
-  std::vector<uint32_t> dynamicOffsets = {0, 0};
-  vkCmdBindDescriptorSets(m_CommandBuffers[imageIndex],
-                          VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          m_PipelineLayout,
-                          0,
-                          1,
-                          &m_DescriptorSets[imageIndex],
-                          2,
-                          dynamicOffsets.data());
-
-  // Iterate all objects and draw
-  // Later optimisation will determine which SHOULD be rendered and not
-
-  // Draw human entities
-  // vkCmdDraw(m_CommandBuffers[i], static_cast<uint32_t>(Human.vertices.size()), 1, 0, 0);
-  identityMatrix.model = Human.humans.at(0).worldMatrix;
-  vkCmdPushConstants(m_CommandBuffers[imageIndex], m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(UniformModelBuffer), &identityMatrix);
-  vkCmdDrawIndexed(m_CommandBuffers[imageIndex],
-                   static_cast<uint32_t>(Human.indices.size()),
-                   1,
-                   Human.indexStartOffset,
-                   Human.vertexStartOffset,
-                   0);
+                       VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
   /*
-      Rebind vertex buffer at new offset for grid data
-    */
-  offsets = {gridStartOffset};
-  vkCmdBindVertexBuffers(m_CommandBuffers[imageIndex], 0, 1, vertexBuffers, offsets.data());
-
-  identityMatrix.model = glm::mat4(1.0);
-  vkCmdPushConstants(m_CommandBuffers[imageIndex], m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(UniformModelBuffer), &identityMatrix);
-  vkCmdDraw(m_CommandBuffers[imageIndex], grid.size(), 1, 0, 0);
+    The sorted queue is split into contiguous ranges, each one
+    recorded by a job into its own secondary buffer. The first
+    range also draws the grid so there is always one
+  */
+  auto recordStart = std::chrono::high_resolution_clock::now();
+  acquireFrameSets(imageIndex);
+  std::vector<RecordSlot> &slots = m_RecordSlots[imageIndex];
+  const size_t rangeCount = std::clamp<size_t>((itemCount + RECORD_MIN_INSTANCES - 1) / RECORD_MIN_INSTANCES,
+                                               1,
+                                               slots.size());
+  const uint32_t rangeSize = static_cast<uint32_t>((itemCount + rangeCount - 1) / rangeCount);
+
+  JobCounter recorded;
+  for (size_t i = 0; i < rangeCount; i++)
+  {
+    uint32_t firstItem = std::min(static_cast<uint32_t>(i) * rangeSize, itemCount);
+    uint32_t endItem = std::min(firstItem + rangeSize, itemCount);
+    RecordSlot *slot = &slots[i];
+    auto record = [this, imageIndex, &packet, alpha, slot, firstItem, endItem, i](void) {
+      recordInstances(imageIndex, packet, alpha, *slot, firstItem, endItem, i == 0);
+    };
+    jobs->run(record, &recorded);
+  }
+  jobs->wait(recorded);
+  auto recordEnd = std::chrono::high_resolution_clock::now();
+  drawData->addCpuSample(m_FrameDrawData, std::chrono::duration<double, std::milli>(recordEnd - recordStart).count());
+
+  // Every range's depth goes down before any range is shaded
+  std::vector<VkCommandBuffer> secondaryBuffers;
+  m_FrameStats = RenderStats{};
+  for (size_t i = 0; i < rangeCount; i++)
+  {
+    if (slots[i].result != VK_SUCCESS)
+    {
+      G_EXCEPT("Failed to record secondary command buffer");
+    }
+    m_FrameStats += slots[i].stats;
+    if (DEPTH_PREPASS)
+    {
+      secondaryBuffers.push_back(slots[i].depthBuffer);
+    }
+  }
+  for (size_t i = 0; i < rangeCount; i++)
+  {
+    secondaryBuffers.push_back(slots[i].buffer);
+  }
+  vkCmdExecuteCommands(m_CommandBuffers[imageIndex],
+                       static_cast<uint32_t>(secondaryBuffers.size()),
+                       secondaryBuffers.data());
 
   vkCmdEndRenderPass(m_CommandBuffers[imageIndex]);
 
+  if (timed)
+  {
+    vkCmdWriteTimestamp(m_CommandBuffers[imageIndex], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampPool, 2 * imageIndex + 1);
+    m_FrameTimings[imageIndex].drawData = m_FrameDrawData;
+    m_FrameTimings[imageIndex].pending = true;
+  }
+
   result = vkEndCommandBuffer(m_CommandBuffers[imageIndex]);
   if (result != VK_SUCCESS)
   {
@@ -2340,26 +3206,235 @@ void GraphicsHandler::recordCommandBuffer(uint32_t imageIndex)
   return;
 }
 
+/*
+  Runs as a job, errors are left in the slot for recordCommandBuffer
+  to raise on the calling thread
+*/
+void GraphicsHandler::recordInstances(uint32_t imageIndex,
+                                      const FramePacket &packet,
+                                      float alpha,
+                                      RecordSlot &slot,
+                                      uint32_t firstItem,
+                                      uint32_t endItem,
+                                      bool drawGrid)
+{
+  // The image's previous submission has finished, the whole pool can be recycled
+  vkResetCommandPool(m_Device, slot.pool, 0);
+  slot.stats = RenderStats{};
+
+  VkCommandBufferInheritanceInfo inheritanceInfo{};
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.pNext = nullptr;
+  inheritanceInfo.renderPass = m_RenderPass;
+  inheritanceInfo.subpass = 0;
+  inheritanceInfo.framebuffer = m_Framebuffers[imageIndex];
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.pNext = nullptr;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+  // Drawn between the packet's two ticks, instances were culled against the newer one
+  glm::vec3 cameraPosition = packet.getCameraPosition(alpha);
+  Frustum frustum = packet.getFrustum(alpha);
+
+  /*
+    Both passes record the same draws with the same matrices, the
+    colour pass only differs in pipeline so its depth compares equal
+  */
+  const DrawDataPath drawPath = m_FrameDrawData.path;
+  char *drawSlots = static_cast<char *>(m_FrameUniforms[imageIndex].mapped) + m_DrawDataOffset;
+  const VkDeviceSize uniformStride = drawData->getUniformStride();
+
+  // Slots are written by the first pass only, the second reads what it wrote
+  auto recordPass = [&](VkCommandBuffer commandBuffer, VkPipeline pipeline, bool writeDrawData) {
+    VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    if (result != VK_SUCCESS)
+    {
+      return result;
+    }
+
+    DrawConstants identityMatrix;
+    identityMatrix.model = glm::mat4(1.0);
+
+    // Secondary buffers inherit no state, each one sets up its own
+    BindCache binds(commandBuffer, slot.stats);
+    binds.bindPipeline(pipeline);
+
+    // Due to using dynamic state, primitive topology must be set
+    // render pass
+    vkCmdSetPrimitiveTopologyEXT(commandBuffer, VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
+
+    // Set 0 holds one dynamic binding, the draw constants slot, when the shaders declare it
+    const uint32_t dynamicOffsets[] = {0};
+    const uint32_t dynamicOffsetCount = declaresBinding(0, 0) ? 1 : 0;
+    binds.bindDescriptorSet(m_PipelineLayout, 0, m_FrameSets[0], dynamicOffsetCount, dynamicOffsets);
+    binds.bindDescriptorSet(m_PipelineLayout, 1, m_FrameSets[1], 0, nullptr);
+    // Every texture and buffer any draw indexes, whatever the material count
+    binds.bindDescriptorSet(m_PipelineLayout, BINDLESS_SET, bindless->getSet(), 0, nullptr);
+
+    // The table is found once per command buffer, draws index it with firstInstance
+    if (drawPath == DrawDataPath::InstanceTable)
+    {
+      DrawConstants header;
+      header.drawTable = m_FrameUniforms[imageIndex].drawTable;
+      vkCmdPushConstants(commandBuffer, m_PipelineLayout, m_DrawConstantsRange.stageFlags, 0, DRAW_CONSTANTS_HEADER_SIZE, &header);
+      slot.stats.pushConstants++;
+    }
+
+    // Hands one draw's constants to the shaders, returns the firstInstance its draws pass
+    auto setDrawData = [&](uint32_t drawIndex, const DrawConstants &constants) -> uint32_t {
+      if (drawPath == DrawDataPath::DynamicUniform)
+      {
+        VkDeviceSize offset = drawIndex * uniformStride;
+        if (writeDrawData)
+        {
+          memcpy(drawSlots + offset, &constants, sizeof(DrawConstants));
+        }
+        const uint32_t drawOffsets[] = {static_cast<uint32_t>(offset)};
+        binds.bindDescriptorSet(m_PipelineLayout, 0, m_FrameSets[0], 1, drawOffsets);
+        return 0;
+      }
+      if (drawPath == DrawDataPath::InstanceTable)
+      {
+        if (writeDrawData)
+        {
+          memcpy(drawSlots + drawIndex * sizeof(DrawConstants), &constants, sizeof(DrawConstants));
+        }
+        return drawIndex;
+      }
+      vkCmdPushConstants(commandBuffer, m_PipelineLayout, m_DrawConstantsRange.stageFlags, 0, sizeof(DrawConstants), &constants);
+      slot.stats.pushConstants++;
+      return 0;
+    };
+    // Frames only outgrow the slots when push constants cannot take over, the rest are left out
+    auto hasDrawSlot = [&](uint32_t drawIndex) {
+      return drawPath == DrawDataPath::PushConstants || drawIndex < DRAW_DATA_MAX_DRAWS;
+    };
+
+    // Items of one mesh are adjacent, buffers are only bound when the mesh changes
+    const std::vector<DrawItem> &items = m_RenderQueue.getItems();
+    for (uint32_t i = firstItem; i < endItem; i++)
+    {
+      const DrawItem &item = items[i];
+      const ModelClass &model = *renderMeshes[item.mesh];
+
+      // Evicted since the queue was built
+      if (model.geometry == GEOMETRY_INVALID_HANDLE || !hasDrawSlot(i))
+      {
+        continue;
+      }
+
+      // Bind the heaps holding the model's data at its offsets
+      const GeometryAllocation &allocation = memory->geometry->get(model.geometry);
+      binds.bindIndexBuffer(memory->geometry->getIndexBuffer(allocation.indexHeap),
+                            allocation.indexOffset,
+                            VK_INDEX_TYPE_UINT16);
+      binds.bindVertexBuffer(memory->geometry->getVertexBuffer(allocation.vertexHeap),
+                             allocation.vertexOffset);
+
+      const InstanceData &instanceData = packet.instances[item.instance];
+      identityMatrix.model = interpolateTransform(instanceData.previousModel, instanceData.model, alpha);
+      identityMatrix.textureIndex = item.mesh < meshTextureSlots.size() ? meshTextureSlots[item.mesh] : BINDLESS_INVALID_INDEX;
+      uint32_t firstInstance = setDrawData(i, identityMatrix);
+      if (model.meshlets.meshlets.empty())
+      {
+        vkCmdDrawIndexed(commandBuffer,
+                         static_cast<uint32_t>(model.indices.size()),
+                         1,
+                         0,
+                         0,
+                         firstInstance);
+        slot.stats.drawCalls++;
+        continue;
+      }
+
+      // Reject off screen and back facing clusters before emitting draws
+      slot.meshletDraws.clear();
+      cullMeshlets(model.meshlets,
+                   identityMatrix.model,
+                   frustum,
+                   cameraPosition,
+                   slot.meshletDraws);
+
+      for (const auto &range : slot.meshletDraws)
+      {
+        vkCmdDrawIndexed(commandBuffer,
+                         range.indexCount,
+                         1,
+                         range.firstIndex,
+                         0,
+                         firstInstance);
+      }
+      slot.stats.drawCalls += static_cast<uint32_t>(slot.meshletDraws.size());
+    }
+
+    /*
+        Rebind vertex buffer at new offset for grid data
+      */
+    const uint32_t gridDrawIndex = static_cast<uint32_t>(items.size());
+    if (drawGrid && gridGeometry != GEOMETRY_INVALID_HANDLE && hasDrawSlot(gridDrawIndex))
+    {
+      const GeometryAllocation &gridAllocation = memory->geometry->get(gridGeometry);
+      binds.bindVertexBuffer(memory->geometry->getVertexBuffer(gridAllocation.vertexHeap),
+                             gridAllocation.vertexOffset);
+
+      identityMatrix.model = glm::mat4(1.0);
+      identityMatrix.textureIndex = BINDLESS_INVALID_INDEX;
+      uint32_t firstInstance = setDrawData(gridDrawIndex, identityMatrix);
+      vkCmdDraw(commandBuffer, grid.size(), 1, 0, firstInstance);
+      slot.stats.drawCalls++;
+    }
+
+    return vkEndCommandBuffer(commandBuffer);
+  };
+
+  if (DEPTH_PREPASS)
+  {
+    slot.result = recordPass(slot.depthBuffer, m_DepthPipelines[static_cast<uint32_t>(drawPath)], true);
+    if (slot.result != VK_SUCCESS)
+    {
+      return;
+    }
+  }
+  slot.result = recordPass(slot.buffer, m_Pipelines[static_cast<uint32_t>(drawPath)], !DEPTH_PREPASS);
+  return;
+}
+
+RenderStats GraphicsHandler::getFrameStats(void) const
+{
+  return m_FrameStats;
+}
+
 /* CLEANUP / DESTRUCTOR */
 
 GraphicsHandler::~GraphicsHandler()
 {
   std::cout << "[+] Cleaning up Vulkan resources" << std::endl;
 
+  // No reload may start while the pipelines go
+  shaderWatcher.reset();
+
   // Wait for all queues to complete before destruction
   vkDeviceWaitIdle(m_Device);
 
   cleanupSwapChain();
+  destroyRetiredPipelines(true);
+  vkDestroyShaderModule(m_Device, m_PipelineStageInfo.vertexModule, nullptr);
+  vkDestroyShaderModule(m_Device, m_PipelineStageInfo.fragmentModule, nullptr);
 
-  // Cleanup descriptor layouts
-  if (!m_DescriptorLayouts.empty())
+  // Pipelines built this run, reloads included, are ready for the next
+  if (m_PipelineCache != VK_NULL_HANDLE)
   {
-    for (auto &layout : m_DescriptorLayouts)
-    {
-      vkDestroyDescriptorSetLayout(m_Device, layout, nullptr);
-    }
+    savePipelineCache();
+    vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
   }
 
+  // Cleanup descriptor layouts, the cache owns every one of them
+  layouts.reset();
+  m_DescriptorLayouts.clear();
+
   // /* Vertex buffer/memory */
   // if (m_VertexBuffer != VK_NULL_HANDLE)
   // {
@@ -2478,6 +3553,17 @@ GraphicsHandler::~GraphicsHandler()
   {
     vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
   }
+  if (m_TimestampPool != VK_NULL_HANDLE)
+  {
+    vkDestroyQueryPool(m_Device, m_TimestampPool, nullptr);
+  }
+  // Device owned resources go before the device
+  streamer.reset();
+  textures.reset();
+  bindless.reset();
+  descriptors.reset();
+  memory.reset();
+
   if (m_Device != VK_NULL_HANDLE)
   {
     vkDestroyDevice(m_Device, nullptr);
@@ -2497,12 +3583,6 @@ GraphicsHandler::~GraphicsHandler()
 
 void GraphicsHandler::cleanupSwapChain(void)
 {
-  /*
-    Reset camera object
-    It relies on swapchain extent data
-  */
-  camera.reset();
-
   // Frame buffers
   for (const auto &buffer : m_Framebuffers)
   {
@@ -2515,10 +3595,51 @@ void GraphicsHandler::cleanupSwapChain(void)
   // Command buffers
   vkFreeCommandBuffers(m_Device, m_CommandPool, static_cast<uint32_t>(m_CommandBuffers.size()), m_CommandBuffers.data());
 
-  // Destroy pipeline object
-  if (m_Pipeline != VK_NULL_HANDLE)
+  // Destroying the pools frees their secondary buffers
+  for (const auto &slots : m_RecordSlots)
+  {
+    for (const auto &slot : slots)
+    {
+      if (slot.pool != VK_NULL_HANDLE)
+      {
+        vkDestroyCommandPool(m_Device, slot.pool, nullptr);
+      }
+    }
+  }
+  m_RecordSlots.clear();
+
+  // Destroy pipeline objects
+  for (uint32_t path = 0; path < DRAW_DATA_PATH_COUNT; path++)
+  {
+    if (m_Pipelines[path] != VK_NULL_HANDLE)
+    {
+      vkDestroyPipeline(m_Device, m_Pipelines[path], nullptr);
+      m_Pipelines[path] = VK_NULL_HANDLE;
+    }
+    if (m_DepthPipelines[path] != VK_NULL_HANDLE)
+    {
+      vkDestroyPipeline(m_Device, m_DepthPipelines[path], nullptr);
+      m_DepthPipelines[path] = VK_NULL_HANDLE;
+    }
+  }
+  // Render targets go with the extent they were sized for
+  if (m_ColorView != VK_NULL_HANDLE)
   {
-    vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+    vkDestroyImageView(m_Device, m_ColorView, nullptr);
+    vkDestroyImage(m_Device, m_ColorImage, nullptr);
+    vkFreeMemory(m_Device, m_ColorMemory, nullptr);
+    m_ColorView = VK_NULL_HANDLE;
+    m_ColorImage = VK_NULL_HANDLE;
+    m_ColorMemory = VK_NULL_HANDLE;
+  }
+  if (m_DepthView != VK_NULL_HANDLE)
+  {
+    vkDestroyImageView(m_Device, m_DepthView, nullptr);
+    vkDestroyImage(m_Device, m_DepthImage, nullptr);
+    vkFreeMemory(m_Device, m_DepthMemory, nullptr);
+    m_DepthView = VK_NULL_HANDLE;
+    m_DepthImage = VK_NULL_HANDLE;
+    m_DepthMemory = VK_NULL_HANDLE;
   }
   // Destroy pipeline layout
   if (m_PipelineLayout != VK_NULL_HANDLE)
@@ -2530,11 +3651,6 @@ void GraphicsHandler::cleanupSwapChain(void)
   {
     vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
   }
-  // Free descriptor pool
-  if (m_DescriptorPool != VK_NULL_HANDLE)
-  {
-    vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
-  }
   // ensure we destroy all views to swap chain images
   if (!m_SwapViews.empty())
   {
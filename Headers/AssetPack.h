@@ -0,0 +1,142 @@
+#ifndef HEADERS_ASSETPACK_H_
+#define HEADERS_ASSETPACK_H_
+
+#include "ExceptionHandler.h"
+#include "FileView.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    Many asset files in one, so startup maps a single file instead of
+    opening and stat'ing every shader and texture :
+
+        header
+        table of contents, sorted by path hash then path
+        path strings
+        file contents, each aligned to ASSET_PACK_ALIGNMENT
+
+    Paths are relative to the directory the pack was built from, with
+    '/' separators, e.g. "shaders/vert.spv". Contents are stored as they
+    are, or LZ4 compressed when that saves enough to be worth unpacking.
+    Stored files are read in place from the pack's mapping
+*/
+
+const char ASSET_PACK_MAGIC[4] = {'V', 'P', 'A', 'K'};
+const uint32_t ASSET_PACK_VERSION = 1;
+const char ASSET_PACK_EXTENSION[] = ".vpak";
+
+// Keeps SPIR-V words and texture container levels aligned in place
+const uint64_t ASSET_PACK_ALIGNMENT = 16;
+
+// Compressed contents must come in under this fraction of their size, else they are stored
+const double ASSET_PACK_MIN_SAVING = 0.125;
+
+enum class AssetCompression : uint32_t
+{
+    Stored = 0,
+    Lz4 = 1
+};
+
+struct AssetPackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesSize;
+};
+
+struct AssetPackEntry
+{
+    uint64_t pathHash;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint64_t offset;
+    // Bytes in the pack, and once unpacked
+    uint64_t storedSize;
+    uint64_t size;
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+class AssetPack
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    AssetPack(void) = delete;
+    AssetPack(const AssetPack &) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+
+    // Maps the pack and checks its table of contents, throws when it is not a valid pack
+    explicit AssetPack(const std::string &path);
+    ~AssetPack(void);
+
+    // Binary search over the table of contents, O(log n)
+    bool contains(const std::string &path) const;
+    // null when the pack has no such file; populate as for FileView
+    std::shared_ptr<const FileView> open(const std::string &path, bool populate = false) const;
+
+    uint32_t getFileCount(void) const;
+    const std::string &getPath(void) const;
+
+    // FNV-1a of the path, the table's sort key
+    static uint64_t hashPath(const std::string &path);
+
+private:
+    std::shared_ptr<const FileView> file;
+    const AssetPackEntry *entries = nullptr;
+    uint32_t entryCount = 0;
+    const char *names = nullptr;
+
+private:
+    const AssetPackEntry *find(const std::string &path) const;
+};
+
+/*
+    Collects files by the path they will have in the pack and reads
+    them only once the pack is written
+*/
+class AssetPackWriter
+{
+public:
+    AssetPackWriter(void);
+    AssetPackWriter(const AssetPackWriter &) = delete;
+    AssetPackWriter &operator=(const AssetPackWriter &) = delete;
+    ~AssetPackWriter(void);
+
+    // Adding a path again replaces its source
+    void add(const std::string &packPath, const std::string &sourcePath);
+
+    // Written beside path and renamed over it, returns false if it could not be written
+    bool write(const std::string &path, bool compress) const;
+
+    size_t getFileCount(void) const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> files;
+};
+
+/*
+    Packs searched before the filesystem by every asset load. Mounted
+    at startup, before anything is loaded; later mounts win over
+    earlier ones for paths both hold
+*/
+void mountAssetPack(std::shared_ptr<const AssetPack> pack);
+bool isAssetPacked(const std::string &path);
+// null when no mounted pack has the path
+std::shared_ptr<const FileView> openPackedAsset(const std::string &path, bool populate = false);
+// Mounted packs first, then the file on disk; throws when neither has it
+std::shared_ptr<const FileView> openAsset(const std::string &path, bool populate = false);
+
+#define AP_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef HEADERS_ASSETSTREAMER_H_
+#define HEADERS_ASSETSTREAMER_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+#include "JobSystem.h"
+#include "TextureHandler.h"
+#include "Models.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class MemoryHandler;
+
+using AssetHandle = uint32_t;
+const AssetHandle ASSET_INVALID_HANDLE = UINT32_MAX;
+
+enum class AssetState
+{
+    Queued,    // Waiting for the I/O thread
+    Reading,   // File being read
+    Decoding,  // CPU side data being built on a worker
+    Ready,     // Waiting for an upload batch
+    Uploading, // Copies submitted, fence not signaled yet
+    Resident,
+    Evicted,   // Was resident, freed once no frame in flight can read it
+    Cancelled,
+    Failed
+};
+
+// Staging bytes recorded into one upload batch, a larger asset still goes alone
+const VkDeviceSize ASSET_UPLOAD_BUDGET = 64 * 1024 * 1024;
+
+/*
+    Moves models and textures to the GPU without the frame loop
+    ever waiting on them, in three stages :
+
+    I/O thread : maps files and reads their pages in, most urgent
+                 request first
+    Workers    : decode and build CPU side data as jobs
+    pump()     : render thread, once a frame; records ready assets
+                 into one upload batch and publishes them as
+                 resident once its fence has signaled
+
+    Priority is the distance from the camera to the position given
+    with the request plus a bias, smaller values stream first
+*/
+class AssetStreamer
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    AssetStreamer(void) = delete;
+    AssetStreamer(const AssetStreamer &) = delete;
+    AssetStreamer &operator=(const AssetStreamer &) = delete;
+
+    AssetStreamer(VkDevice device,
+                  VkQueue queue,
+                  uint32_t queueFamilyIndex,
+                  MemoryHandler &memoryHandler,
+                  TextureHandler &textureHandler,
+                  JobSystem &jobSystem);
+    ~AssetStreamer(void);
+
+    // Requesting an asset that is already in flight returns its handle
+    AssetHandle requestTexture(const std::string &path, const glm::vec3 &position, float bias = 0.0f);
+
+    // model must outlive the request, its geometry is only set once resident
+    AssetHandle requestModel(ModelClass &model, const glm::vec3 &position, float bias = 0.0f);
+
+    // Drops a request that is not resident yet, returns false if it was too late
+    bool cancel(AssetHandle handle);
+
+    // Render thread only, drops a resident texture; Requesting it again before
+    // it is freed makes it resident again. Returns false when it is not resident
+    bool evict(AssetHandle handle);
+
+    void updatePriorities(const glm::vec3 &cameraPosition);
+
+    // Render thread only, never waits on the GPU or the other stages
+    void pump(void);
+
+    AssetState getState(AssetHandle handle) const;
+    bool isResident(AssetHandle handle) const;
+
+    // Requests that are neither resident, cancelled nor failed
+    size_t getPendingCount(void) const;
+
+private:
+    enum class AssetType
+    {
+        Texture,
+        Model
+    };
+
+    // state and priority are guarded by requestMutex, the payload
+    // is handed between stages under the same lock
+    struct Request
+    {
+        AssetHandle handle = ASSET_INVALID_HANDLE;
+        AssetType type = AssetType::Texture;
+        std::string path;
+        ModelClass *model = nullptr;
+
+        glm::vec3 position = glm::vec3(0.0f);
+        float bias = 0.0f;
+        float priority = 0.0f;
+        AssetState state = AssetState::Queued;
+
+        std::shared_ptr<const TextureData> texture;
+        GeometryHandle geometry = GEOMETRY_INVALID_HANDLE;
+        VkDeviceSize uploadBytes = 0;
+    };
+
+    VkDevice device = nullptr;
+    VkQueue queue = nullptr;
+    MemoryHandler &memory;
+    TextureHandler &textures;
+    JobSystem &jobs;
+    TextureHandler::FormatSupport formats;
+
+    mutable std::mutex requestMutex;
+    std::condition_variable requestAvailable;
+    std::condition_variable decodeFinished;
+
+    std::unordered_map<AssetHandle, std::shared_ptr<Request>> requests;
+    std::vector<std::shared_ptr<Request>> queued;
+    std::vector<std::shared_ptr<Request>> ready;
+    // With the frame they were evicted on, oldest first
+    std::vector<std::pair<std::shared_ptr<Request>, uint64_t>> evicted;
+    AssetHandle nextHandle = 0;
+    glm::vec3 lastCameraPosition = glm::vec3(0.0f);
+
+    // Bounds decoded data waiting in memory
+    size_t decodesInFlight = 0;
+    size_t maxDecodesInFlight = 1;
+    bool stopping = false;
+    std::thread ioThread;
+
+    // Render thread only
+    VkCommandPool commandPool = nullptr;
+    VkCommandBuffer commandBuffer = nullptr;
+    VkFence uploadFence = nullptr;
+    std::vector<std::shared_ptr<Request>> batch;
+    bool batchPending = false;
+    // Counts pump() calls, one a frame
+    uint64_t frame = 0;
+
+private:
+    AssetHandle enqueue(std::shared_ptr<Request> request);
+    void ioLoop(void);
+    // file is null for models, which have nothing to read
+    void decode(std::shared_ptr<Request> request, std::shared_ptr<const FileView> file);
+
+    void startBatch(void);
+    void finishBatch(void);
+
+    // Frees what was evicted on or before completedFrame
+    void releaseEvicted(uint64_t completedFrame);
+    void freeAsset(const Request &request);
+
+    static bool isSettled(AssetState state);
+};
+
+#define AS_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef HEADERS_BATCHMATH_H_
+#define HEADERS_BATCHMATH_H_
+
+#include "Primitives.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+
+/*
+    Matrix kernels over whole arrays instead of one object at a time.
+    The widest path the CPU supports is picked on first use: AVX2 with
+    FMA (checked at run time, the build only assumes SSE2), SSE2 on
+    any x86-64, NEON on AArch64, plain glm everywhere else.
+    Every path gives the same results up to float rounding
+*/
+enum class BatchMathPath
+{
+    Scalar,
+    SSE,
+    AVX2,
+    NEON
+};
+
+BatchMathPath getBatchMathPath(void);
+bool isBatchMathPathSupported(BatchMathPath path);
+// Benchmarks only, not safe while other threads run batch kernels
+void setBatchMathPath(BatchMathPath path);
+const char *getBatchMathPathName(BatchMathPath path);
+
+// Rotation and scale from the quaternion and scale, translation in the last column
+glm::mat4 composeTransform(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale);
+
+// out[i] = composeTransform(positions[i], rotations[i], scales[i])
+void composeTransforms(const glm::vec3 *positions,
+                       const glm::quat *rotations,
+                       const glm::vec3 *scales,
+                       glm::mat4 *out,
+                       size_t count);
+
+// out[i] = lhs[i] * rhs[i], out may alias either input
+void multiplyMatrices(const glm::mat4 *lhs, const glm::mat4 *rhs, glm::mat4 *out, size_t count);
+
+// out[i] = lhs * rhs[i], for pre-multiplying a view projection into model matrices
+void multiplyMatrices(const glm::mat4 &lhs, const glm::mat4 *rhs, glm::mat4 *out, size_t count);
+
+#endif
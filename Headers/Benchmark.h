@@ -0,0 +1,61 @@
+#ifndef HEADERS_BENCHMARK_H_
+#define HEADERS_BENCHMARK_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+    CPU micro benchmarks, compiled in when ENGINE_BENCHMARKS is
+    defined in Defines.h; main() runs them instead of opening a window
+*/
+
+// Average milliseconds per call of job over iterations runs
+template <typename Function>
+double measureMilliseconds(Function &&job, int iterations)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        job();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+void runBenchmarks(void);
+
+// Entity store passes against per model vectors of instance objects
+void benchmarkEntityLayout(size_t entityCount);
+
+// Hierarchy updates on one thread against the worker pool, for all, few and no moved roots
+void benchmarkTransformHierarchy(size_t rootCount, size_t childCount, size_t grandchildCount);
+
+// Cost of queueing and completing independent and chained jobs
+void benchmarkJobOverhead(size_t jobCount);
+
+// One parallelFor workload on 1, 2, 4.. threads up to the core count
+void benchmarkJobScaling(size_t itemCount);
+
+// Batch math kernels on every path the CPU supports against per element glm calls
+void benchmarkBatchMath(size_t transformCount);
+
+/*
+    CPU record cost of each draw data path only : pushes copied into
+    a command stream, uniform slots at common offset alignments with a
+    rebind each, and a packed table, all in host memory. It says
+    nothing about which path wins on a device; DrawDataTuner times
+    every path with GPU timestamps at startup and prints that table
+    as "Draw data paths on this device"
+*/
+void benchmarkDrawDataRecording(size_t drawCount);
+
+/*
+    Clusters a flat gridSize x gridSize grid, the models in the tree
+    are too small to be split, and checks the meshlets cover it exactly.
+    Culls it from in front, from behind and close up, checking every
+    triangle in view survives while the rest is rejected
+*/
+void benchmarkMeshlets(uint32_t gridSize);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef HEADERS_BINDLESSDESCRIPTORS_H_
+#define HEADERS_BINDLESSDESCRIPTORS_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+
+#include <vector>
+
+// Returned when an array is full, shaders treat it as "no resource"
+const uint32_t BINDLESS_INVALID_INDEX = UINT32_MAX;
+
+// Bindings of the global set
+const uint32_t BINDLESS_TEXTURE_BINDING = 0;
+const uint32_t BINDLESS_BUFFER_BINDING = 1;
+
+/*
+    One descriptor set shared by every draw, holding large arrays of
+    textures and storage buffers. Draws select their resources with
+    indexes passed in push constants, so the set is bound once per
+    command buffer however many materials there are.
+
+    Built on descriptor indexing: slots are partially bound, so unused
+    ones may hold nothing, and update-after-bind, so resources can be
+    added while command buffers using the set are pending. A freed
+    slot is only handed out again once the frames that may still read
+    it have completed
+*/
+class BindlessDescriptors
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    BindlessDescriptors(void) = delete;
+    BindlessDescriptors(const BindlessDescriptors &) = delete;
+    BindlessDescriptors &operator=(const BindlessDescriptors &) = delete;
+
+    // Capacities are clamped to the device's update-after-bind limits
+    BindlessDescriptors(VkDevice device,
+                        const VkPhysicalDeviceDescriptorIndexingProperties &limits,
+                        uint32_t maxTextures,
+                        uint32_t maxBuffers);
+    ~BindlessDescriptors(void);
+
+    // Whether the device has the descriptor indexing features this needs
+    static bool isSupported(const VkPhysicalDeviceDescriptorIndexingFeatures &features);
+
+    // Render thread only, returns the slot for shaders or BINDLESS_INVALID_INDEX when full
+    uint32_t addTexture(VkImageView view, VkSampler sampler);
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+    void removeTexture(uint32_t index);
+    void removeBuffer(uint32_t index);
+
+    // Once a frame, slots freed MAX_FRAMES_IN_FLIGHT frames ago become reusable
+    void advanceFrame(void);
+
+    VkDescriptorSetLayout getLayout(void) const;
+    VkDescriptorSet getSet(void) const;
+
+    uint32_t getTextureCapacity(void) const;
+    uint32_t getBufferCapacity(void) const;
+
+    void cleanup(void);
+
+private:
+    // Slot handout for one binding's array
+    struct SlotArray
+    {
+        uint32_t capacity = 0;
+        uint32_t next = 0;
+        std::vector<uint32_t> freeSlots;
+        // Slot and the frame it was freed on
+        std::vector<std::pair<uint32_t, uint64_t>> retired;
+
+        uint32_t acquire(void);
+        void release(uint32_t index, uint64_t frame);
+        void recycle(uint64_t completedFrame);
+    };
+
+    VkDevice device = nullptr;
+    VkDescriptorSetLayout layout = nullptr;
+    VkDescriptorPool pool = nullptr;
+    VkDescriptorSet set = nullptr;
+
+    SlotArray textures;
+    SlotArray buffers;
+    uint64_t frame = 0;
+
+private:
+    void createLayout(void);
+    void createSet(void);
+};
+
+#define BD_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
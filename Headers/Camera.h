@@ -1,6 +1,8 @@
 #ifndef HEADERS_CAMERAHANDLER_H_
 #define HEADERS_CAMERAHANDLER_H_
 
+#include "Primitives.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -8,47 +10,73 @@
 #include <glm/gtx/string_cast.hpp>
 #include <iostream>
 
+/*
+    View, projection, view projection and frustum are cached and only
+    rebuilt by update() after something they depend on has changed,
+    so a camera that stands still costs no matrix work.
+    By default the projection is infinite reverse-Z: the near plane
+    maps to depth 1 and infinity to 0, which spreads float precision
+    evenly over distance. Depth tests compare with GREATER and the
+    depth buffer clears to 0
+*/
 class Camera
 {
 public:
     Camera(int extentWidth, int extentHeight);
     ~Camera(void);
 
-    void moveLeft(void);
-    void moveRight(void);
-    void moveUp(void);
-    void moveDown(void);
-    void moveForward(void);
-    void moveBackward(void);
+    // deltaTime in seconds, one simulation tick
+    // Forward/backward follow the view direction, left/right stay level, up/down are along the world axis
+    void moveLeft(float deltaTime);
+    void moveRight(float deltaTime);
+    void moveUp(float deltaTime);
+    void moveDown(float deltaTime);
+    void moveForward(float deltaTime);
+    void moveBackward(float deltaTime);
 
+    // Degrees, x pitches and y yaws, z is ignored
     void rotate(glm::vec3 rotateBy);
 
-    void update(void);
+    void setAspectRatio(float ratio);
+    // Off falls back to a finite 0..1 depth projection ending at farZ
+    // Depth compare and clear are fixed when the pipeline is built, switch before that
+    void setReverseZ(bool enabled);
 
-    glm::vec3 getPosition(void);
+    // Rebuilds what changed since the last call, returns false when nothing did
+    bool update(void);
 
-private:
-    int viewWidth;
-    int viewHeight;
+    glm::vec3 getPosition(void) const;
+    glm::vec3 getForward(void) const;
+    bool isReverseZ(void) const;
 
-    float fovDegrees = 90.0f; // field of view
-    float fovRadians = (fovDegrees / 360.0f) / (glm::two_pi<float>());
-    float aspectRatio = static_cast<float>(viewWidth) / static_cast<float>(viewHeight);
-    float nearZ = 0.01f;
-    float farZ = 1000.0f;
+    // Valid as of the last update()
+    const glm::mat4 &getView(void) const;
+    const glm::mat4 &getProjection(void) const;
+    const glm::mat4 &getViewProjection(void) const;
+    const Frustum &getFrustum(void) const;
 
+private:
+    float fovDegrees = 45.0f; // vertical field of view
+    float fovRadians = glm::radians(fovDegrees);
+    float aspectRatio;
+    float nearZ = 0.1f;
+    float farZ = 1000.0f; // finite projection only
+    bool reverseZ = true;
 
     // xyz coords
     glm::vec3 position;
-    // Changes based on angle of camera
-    glm::vec3 upVector;
-    // Origin of camera focus
-    glm::vec3 lookAt;
-    // rotation vector
-    glm::vec3 rotVector;
+    // Degrees, pitch clamped short of straight up/down so lookAt keeps a valid basis
+    float pitch = 0.0f;
+    float yaw = 0.0f;
+    glm::vec3 forward;
+
+    bool viewDirty = true;
+    bool projectionDirty = true;
 
     glm::mat4 viewMatrix;
     glm::mat4 projMatrix;
+    glm::mat4 viewProjMatrix;
+    Frustum frustum;
 
 public:
     /* CONSTANTS */
@@ -58,6 +86,9 @@ public:
     const glm::vec3 DEFAULT_BACKWARD_VECTOR = {0.0f, 0.0f, -1.0f};
     const glm::vec3 DEFAULT_RIGHT_VECTOR = {1.0f, 0.0f, 0.0f};
     const glm::vec3 DEFAULT_LEFT_VECTOR = {-1.0f, 0.0f, 0.0f};
+    // Units per second
+    const float MOVE_SPEED = 24.0f;
+    const float MAX_PITCH = 89.0f;
 };
 
-#endif
\ No newline at end of file
+#endif
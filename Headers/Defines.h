@@ -17,6 +17,7 @@
 #include <string>
 #include <cstring>
 #include <filesystem>
+#include <memory>
 
 /* DEFINES */
 
@@ -24,6 +25,10 @@
 
 //#define NDEBUG
 
+/* Run CPU benchmarks from main() instead of the engine */
+
+//#define ENGINE_BENCHMARKS
+
 /* Present Modes */
 
 #define PRESENT_MODE VK_PRESENT_MODE_IMMEDIATE_KHR
@@ -55,6 +60,72 @@ inline const char *presentModeToString(VkPresentModeKHR pmode)
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
+// Simulation ticks per second, independent of the frame rate
+const int SIMULATION_TICK_RATE = 120;
+
+// Fewest instances worth a secondary command buffer of their own
+const uint32_t RECORD_MIN_INSTANCES = 256;
+
+/*
+    Lays down depth for everything before shading anything, colour
+    draws then only pass where they are the nearest surface. Costs a
+    second vertex pass, pays off when fragments are expensive and
+    crowds overlap heavily
+*/
+const bool DEPTH_PREPASS = false;
+
+// Most MSAA samples to use, capped by what the device supports; VK_SAMPLE_COUNT_1_BIT turns it off
+const VkSampleCountFlagBits MSAA_MAX_SAMPLES = VK_SAMPLE_COUNT_8_BIT;
+
+// Slots in the global bindless set, clamped to device limits; set index follows the per-image sets
+const uint32_t BINDLESS_MAX_TEXTURES = 4096;
+const uint32_t BINDLESS_MAX_BUFFERS = 1024;
+const uint32_t BINDLESS_SET = 2;
+
+/*
+    Frames each per-draw data path is timed for at startup before the
+    fastest is kept, see DrawDataTuner; 0 goes by device limits alone
+*/
+const uint32_t DRAW_DATA_TUNING_FRAMES = 120;
+
+/*
+    Shader sources next to the executable are recompiled when saved
+    and their pipelines replaced between frames, see ShaderWatcher.
+    Binaries are read from SHADER_DIRECTORY under the same directory
+*/
+#ifndef NDEBUG
+const bool SHADER_HOT_RELOAD = true;
+#else
+const bool SHADER_HOT_RELOAD = false;
+#endif
+const char *const SHADER_DIRECTORY = "shaders";
+// GLSL to SPIR-V compiler, found through PATH
+const char *const SHADER_COMPILER = "glslc";
+
+// Mounted from beside the executable when present, see AssetPack and the packbuilder target
+const char *const ASSET_PACK_FILE = "assets.vpak";
+
+// Driver pipeline cache kept beside the executable between runs, ignored when another device wrote it
+const char *const PIPELINE_CACHE_FILE = "pipeline.cache";
+
+/*
+    Adapter to use over the highest scored one, by the UUID printed
+    for each adapter at startup. The environment variable overrides
+    it per run, e.g. to test on lavapipe; empty selects by score
+*/
+const char *const DEVICE_UUID_OVERRIDE = "";
+const char *const DEVICE_UUID_ENVIRONMENT = "MOOGIN_DEVICE_UUID";
+
+/*
+    Per-frame uniform and draw data goes straight into video memory
+    when the device maps most of it (resizable BAR, unified memory),
+    host memory the device reads across the bus otherwise
+*/
+const bool DIRECT_UPLOADS = true;
+// Times host writes on every upload path once at startup, see GraphicsHandler::benchmarkUploads
+const bool UPLOAD_BENCHMARK = false;
+const VkDeviceSize UPLOAD_BENCHMARK_SIZE = 64ull * 1024 * 1024;
+
 /*
     device level layers are deprecated and
     only instance level requests need to be made
@@ -69,7 +140,11 @@ const std::vector<const char *> requestedInstanceExtensions = {
 
 const std::vector<const char *> requestedDeviceExtensions = {
     "VK_KHR_swapchain",
-    "VK_EXT_extended_dynamic_state"};
+    "VK_EXT_extended_dynamic_state",
+    "VK_EXT_descriptor_indexing"};
+
+// Limits, memory and extensions of an adapter, see DeviceCapabilities.h
+struct DeviceCapabilities;
 
 // Contains Physical render device on system with Vulkan support
 // Also contains other relevant info such as supported Queues etc
@@ -90,6 +165,13 @@ struct DEVICEINFO
     VkPhysicalDeviceProperties2 devProperties{};
     VkPhysicalDeviceFeatures2 devFeatures{};
     VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedFeatures{};
+    // Chained behind extendedFeatures and devProperties, bindless textures and buffers
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+    // Chained behind indexingProperties, the UUID a device override is given by
+    VkPhysicalDeviceIDProperties idProperties{};
+
+    std::shared_ptr<const DeviceCapabilities> capabilities;
 };
 
 struct SwapChainSupportDetails
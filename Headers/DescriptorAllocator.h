@@ -0,0 +1,121 @@
+#ifndef HEADERS_DESCRIPTORALLOCATOR_H_
+#define HEADERS_DESCRIPTORALLOCATOR_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Sets the first pool of a frame holds, each further pool doubles up to DESCRIPTOR_MAX_SETS_PER_POOL
+const uint32_t DESCRIPTOR_SETS_PER_POOL = 64;
+const uint32_t DESCRIPTOR_MAX_SETS_PER_POOL = 4096;
+
+// One descriptor of a set, buffer or image depending on type
+struct DescriptorWrite
+{
+    uint32_t binding = 0;
+    VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    VkDescriptorBufferInfo buffer{};
+    VkDescriptorImageInfo image{};
+
+    static DescriptorWrite forBuffer(uint32_t binding,
+                                     VkDescriptorType type,
+                                     VkBuffer buffer,
+                                     VkDeviceSize offset,
+                                     VkDeviceSize range);
+    static DescriptorWrite forImage(uint32_t binding,
+                                    VkDescriptorType type,
+                                    VkImageView view,
+                                    VkSampler sampler,
+                                    VkImageLayout layout);
+
+    bool operator==(const DescriptorWrite &other) const;
+};
+
+/*
+    Hands out descriptor sets from pools owned by the frame using
+    them. Nothing is freed one set at a time: beginning a frame resets
+    all of its pools at once, so a transient set costs a bump
+    allocation. A frame that runs a pool dry moves on to the next one,
+    creating it when needed, and keeps those pools for later frames.
+
+    getSet() caches sets by a hash of their layout and writes, asking
+    twice within a frame for the same resources returns the same set.
+
+    Render thread only, recording threads wanting their own sets need
+    their own allocator
+*/
+class DescriptorAllocator
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    DescriptorAllocator(void) = delete;
+    DescriptorAllocator(const DescriptorAllocator &) = delete;
+    DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+    explicit DescriptorAllocator(VkDevice device);
+    ~DescriptorAllocator(void);
+
+    // Resets the frame's pools, the GPU must be done with the sets it handed out last time
+    // Frames are created on first use, any index works
+    void beginFrame(uint32_t frame);
+
+    // Valid until the current frame begins again
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    VkDescriptorSet getSet(VkDescriptorSetLayout layout, const std::vector<DescriptorWrite> &writes);
+
+    // Lives until cleanup, for sets that never change
+    VkDescriptorSet allocatePersistent(VkDescriptorSetLayout layout);
+
+    // Pools created so far over all frames
+    size_t getPoolCount(void) const;
+
+    void cleanup(void);
+
+private:
+    struct CachedSet
+    {
+        VkDescriptorSetLayout layout = nullptr;
+        std::vector<DescriptorWrite> writes;
+        VkDescriptorSet set = nullptr;
+    };
+
+    struct PoolChain
+    {
+        std::vector<VkDescriptorPool> pools;
+        // Pools before this one are full until the next reset
+        size_t current = 0;
+    };
+
+    struct Frame
+    {
+        PoolChain chain;
+        // Hash of layout and writes -> sets sharing that hash
+        std::unordered_map<uint64_t, std::vector<CachedSet>> cache;
+    };
+
+    VkDevice device = nullptr;
+    std::vector<Frame> frames;
+    uint32_t currentFrame = 0;
+    PoolChain persistent;
+
+private:
+    VkDescriptorPool createPool(uint32_t maxSets);
+    VkDescriptorSet allocateFrom(PoolChain &chain, VkDescriptorSetLayout layout);
+    void resetChain(PoolChain &chain);
+    void destroyChain(PoolChain &chain);
+
+    static uint64_t hashWrites(VkDescriptorSetLayout layout, const std::vector<DescriptorWrite> &writes);
+};
+
+#define DA_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef HEADERS_DESCRIPTORLAYOUTCACHE_H_
+#define HEADERS_DESCRIPTORLAYOUTCACHE_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+
+#include <unordered_map>
+#include <vector>
+
+/*
+    Owns descriptor set layouts by the bindings they were made from.
+    Asking twice for the same bindings, in any order, returns the same
+    layout, so pipelines built from reflected shaders share layouts and
+    sets allocated for one are compatible with the others.
+
+    Layouts live until cleanup, render thread only
+*/
+class DescriptorLayoutCache
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    DescriptorLayoutCache(void) = delete;
+    DescriptorLayoutCache(const DescriptorLayoutCache &) = delete;
+    DescriptorLayoutCache &operator=(const DescriptorLayoutCache &) = delete;
+
+    explicit DescriptorLayoutCache(VkDevice device);
+    ~DescriptorLayoutCache(void);
+
+    // Immutable samplers are not supported, bindings must not reference any
+    VkDescriptorSetLayout getLayout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+
+    // Distinct layouts created so far
+    size_t size(void) const;
+
+    void cleanup(void);
+
+private:
+    struct CachedLayout
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        VkDescriptorSetLayout layout = nullptr;
+    };
+
+    VkDevice device = nullptr;
+    // Hash of the sorted bindings -> layouts sharing that hash
+    std::unordered_map<uint64_t, std::vector<CachedLayout>> layouts;
+    size_t count = 0;
+
+private:
+    static uint64_t hashBindings(const std::vector<VkDescriptorSetLayoutBinding> &bindings);
+    static bool sameBindings(const std::vector<VkDescriptorSetLayoutBinding> &a,
+                             const std::vector<VkDescriptorSetLayoutBinding> &b);
+};
+
+#define LC_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
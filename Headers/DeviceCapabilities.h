@@ -0,0 +1,82 @@
+#ifndef HEADERS_DEVICECAPABILITIES_H_
+#define HEADERS_DEVICECAPABILITIES_H_
+
+#include "Defines.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+// Smallest host visible device local heap taken as resizable BAR, without it drivers expose a 256 MiB window
+const VkDeviceSize RESIZABLE_BAR_MIN_SIZE = 256ull * 1024 * 1024;
+
+struct MemoryHeapInfo
+{
+    VkDeviceSize size = 0;
+    bool deviceLocal = false;
+    // Some memory type on the heap is both device local and host visible
+    bool hostVisibleDeviceLocal = false;
+};
+
+/*
+    What one adapter offers, probed once at startup and kept for the
+    life of the handler. missing lists what the renderer needs and
+    the adapter lacks, the adapter is only selectable when it is empty.
+    Software implementations such as lavapipe are probed the same way
+    and stay selectable, they only score below any hardware
+*/
+struct DeviceCapabilities
+{
+    std::string name;
+    VkPhysicalDeviceType type = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+    uint32_t apiVersion = 0;
+    uint32_t driverVersion = 0;
+    uint32_t vendorID = 0;
+    uint32_t deviceID = 0;
+    std::array<uint8_t, VK_UUID_SIZE> uuid{};
+
+    VkPhysicalDeviceLimits limits{};
+
+    std::vector<MemoryHeapInfo> heaps;
+    // Largest device local heap
+    VkDeviceSize deviceLocalSize = 0;
+    // Largest device local heap the host can write straight into
+    VkDeviceSize hostVisibleDeviceLocalSize = 0;
+    // All of video memory is mappable, resizable BAR or unified memory
+    bool resizableBar = false;
+
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    uint32_t graphicsFamily = UINT32_MAX;
+    bool graphicsTimestamps = false;
+
+    // Sorted, see hasExtension
+    std::vector<std::string> extensions;
+
+    bool extendedDynamicState = false;
+    bool bindless = false;
+    bool textureCompressionBC = false;
+
+    std::vector<std::string> missing;
+    int score = 0;
+
+    bool hasExtension(const char *extension) const;
+    bool isSoftware(void) const;
+};
+
+// Reads the device's properties, features and queue families as queryDevices filled them, then its memory and extensions
+DeviceCapabilities probeDevice(const DEVICEINFO &device);
+
+// 0 for adapters with anything missing, otherwise higher for what the renderer makes use of
+int scoreDevice(const DeviceCapabilities &capabilities);
+
+const char *getDeviceTypeName(VkPhysicalDeviceType type);
+
+// 8-4-4-4-12 lower case hex, the form the override is given in
+std::string formatDeviceUuid(const std::array<uint8_t, VK_UUID_SIZE> &uuid);
+// Takes either case, with or without the dashes
+bool parseDeviceUuid(const std::string &text, std::array<uint8_t, VK_UUID_SIZE> &uuid);
+
+// DEVICE_UUID_ENVIRONMENT when set, else DEVICE_UUID_OVERRIDE, empty when neither is
+std::string getDeviceOverride(void);
+
+#endif
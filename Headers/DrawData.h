@@ -0,0 +1,110 @@
+#ifndef HEADERS_DRAWDATA_H_
+#define HEADERS_DRAWDATA_H_
+
+#include "Defines.h"
+#include "Primitives.h"
+
+#include <array>
+#include <vector>
+
+// Per-draw data slots in each frame's buffer, frames with more draws are recorded with push constants
+const uint32_t DRAW_DATA_MAX_DRAWS = 16384;
+
+// Frames of a tuning block left out of its averages while caches and clocks settle
+const uint32_t DRAW_DATA_WARMUP_FRAMES = 8;
+
+/*
+    How DrawConstants reach the shaders, handed to both stages as
+    specialization constant 0 so each path has its own pipeline
+
+    PushConstants  : pushed before every draw
+    DynamicUniform : written to the frame's uniform buffer, set 0
+                     binding 0 rebound at the draw's dynamic offset
+    InstanceTable  : written packed to a storage buffer in the bindless
+                     set, draws pass their index as firstInstance and
+                     only the table slot is pushed
+*/
+enum class DrawDataPath : uint32_t
+{
+    PushConstants = 0,
+    DynamicUniform = 1,
+    InstanceTable = 2
+};
+const uint32_t DRAW_DATA_PATH_COUNT = 3;
+
+const char *getDrawDataPathName(DrawDataPath path);
+
+// Path a frame was recorded with, and whether its times count towards tuning
+struct DrawDataFrame
+{
+    DrawDataPath path = DrawDataPath::PushConstants;
+    bool measured = false;
+};
+
+/*
+    Picks the per-draw data path. Without tuning the choice follows
+    the device limits alone: push constants whenever DrawConstants
+    fit maxPushConstantsSize, else the instance table, else dynamic
+    uniforms.
+
+    With tuning frames set every available path is recorded for that
+    many frames in turn, timed on the CPU while recording and on the
+    GPU with timestamps, and the path with the cheapest frames is kept.
+    Render thread only
+*/
+class DrawDataTuner
+{
+public:
+    DrawDataTuner(void) = delete;
+    DrawDataTuner(const DrawDataTuner &) = delete;
+    DrawDataTuner &operator=(const DrawDataTuner &) = delete;
+
+    // gpuTimed : GPU samples will be reported, tuning waits for them
+    DrawDataTuner(const VkPhysicalDeviceLimits &limits, uint32_t tuningFrames, bool gpuTimed);
+    ~DrawDataTuner(void);
+
+    // Before the first frame, for paths the engine could not set up
+    void disable(DrawDataPath path);
+    bool isAvailable(DrawDataPath path) const;
+
+    // Path to record the next frame with, moves tuning along
+    DrawDataFrame beginFrame(void);
+    void addCpuSample(const DrawDataFrame &frame, double milliseconds);
+    void addGpuSample(const DrawDataFrame &frame, double milliseconds);
+
+    bool isTuning(void) const;
+    DrawDataPath getPath(void) const;
+
+    // DrawConstants size rounded up to the uniform offset alignment
+    VkDeviceSize getUniformStride(void) const;
+
+private:
+    struct PathTimes
+    {
+        double cpuMilliseconds = 0.0;
+        uint32_t cpuSamples = 0;
+        double gpuMilliseconds = 0.0;
+        uint32_t gpuSamples = 0;
+    };
+
+    std::array<bool, DRAW_DATA_PATH_COUNT> available{};
+    std::array<PathTimes, DRAW_DATA_PATH_COUNT> times{};
+    // Paths tuned, in the order they are run
+    std::vector<DrawDataPath> schedule;
+
+    DrawDataPath path = DrawDataPath::PushConstants;
+    uint32_t maxPushConstantsSize = 0;
+    VkDeviceSize uniformStride = 0;
+    uint32_t tuningFrames = 0;
+    bool gpuTimed = false;
+    bool tuning = false;
+    uint32_t frame = 0;
+    // Measured frames whose GPU time has not come back yet
+    uint32_t pendingGpuSamples = 0;
+
+private:
+    DrawDataPath chooseByLimits(void) const;
+    void finishTuning(void);
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef HEADERS_ENTITYSTORE_H_
+#define HEADERS_ENTITYSTORE_H_
+
+#include "ExceptionHandler.h"
+#include "Primitives.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Index into the entity table, generation tells reused slots apart
+struct Entity
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+};
+const Entity ENTITY_INVALID = {};
+
+using ComponentMask = uint32_t;
+const ComponentMask COMPONENT_TRANSFORM = 1 << 0; // position/rotation/scale and world matrix
+const ComponentMask COMPONENT_MESH = 1 << 1;      // world bounds and visibility, needs a transform
+
+// Per row flags of what the transform passes still have to refresh
+const uint8_t TRANSFORM_LOCAL_DIRTY = 1 << 0;  // world matrix from position/rotation/scale
+const uint8_t TRANSFORM_BOUNDS_DIRTY = 1 << 1; // world bounds from the world matrix
+const uint8_t TRANSFORM_MOVED = 1 << 2;        // world matrix changed this tick, previous one lags
+const uint8_t TRANSFORM_RESET = 1 << 3;        // no previous matrix yet, the next world matrix is copied
+
+// Index into the mesh table of the store
+using MeshId = uint32_t;
+const MeshId MESH_INVALID = UINT32_MAX;
+
+// Model space bounding sphere shared by every entity drawing the mesh
+struct MeshBounds
+{
+    glm::vec3 center = {0.0f, 0.0f, 0.0f};
+    float radius = 0.0f;
+};
+
+/*
+    Every entity with the same component mask and render mesh lives
+    in one archetype; Components are stored as parallel arrays (SoA)
+    indexed by row so systems walk contiguous memory. Columns of
+    components outside the mask stay empty
+
+    The mesh is shared by the whole archetype so per mesh work such
+    as instance packing is a straight copy of its rows
+*/
+struct Archetype
+{
+    ComponentMask mask = 0;
+    MeshId mesh = MESH_INVALID;
+    std::vector<Entity> entities;
+
+    // COMPONENT_TRANSFORM
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<glm::mat4> previousWorldMatrices; // as of the tick before, for interpolation
+    std::vector<uint8_t> transformFlags;
+    bool transformsDirty = false; // some row has a flag set, static archetypes are skipped
+    bool transformsMoved = false; // some row has TRANSFORM_MOVED set
+
+    // COMPONENT_MESH
+    std::vector<glm::vec4> worldBounds; // xyz center, w radius
+    std::vector<uint8_t> visible;
+    size_t visibleCount = 0;
+
+    size_t size(void) const
+    {
+        return entities.size();
+    }
+};
+
+/*
+    Owns all entities and their components, rows are kept packed
+    by moving the last row into the hole left by a destroyed entity
+    so row order is not stable
+*/
+class EntityStore
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    EntityStore(void);
+    ~EntityStore(void);
+    EntityStore(const EntityStore &) = delete;
+    EntityStore &operator=(const EntityStore &) = delete;
+
+    Entity create(ComponentMask mask);
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+    size_t getEntityCount(void) const;
+
+    void setTransform(Entity entity,
+                      const glm::vec3 &position,
+                      const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                      const glm::vec3 &scale = glm::vec3(1.0f));
+    // For entities placed by a TransformHierarchy, bypasses position/rotation/scale
+    void setWorldMatrix(Entity entity, const glm::mat4 &world);
+    // Moves the entity into the archetype drawing mesh
+    void setMesh(Entity entity, MeshId mesh);
+    MeshId getMesh(Entity entity) const;
+    const glm::mat4 &getWorldMatrix(Entity entity) const;
+
+    MeshId addMesh(const MeshBounds &bounds);
+    // Only entities drawing the mesh are refreshed, and only if the bounds changed
+    void setMeshBounds(MeshId mesh, const MeshBounds &bounds);
+    const std::vector<MeshBounds> &getMeshBounds(void) const;
+
+    // Systems iterate these directly, see EntitySystems.h
+    std::vector<Archetype> &getArchetypes(void);
+    const std::vector<Archetype> &getArchetypes(void) const;
+
+private:
+    // Where an entity's row currently lives
+    struct EntityRecord
+    {
+        uint32_t generation = 0;
+        uint32_t archetype = UINT32_MAX;
+        uint32_t row = 0;
+    };
+
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeIndexes;
+    std::vector<Archetype> archetypes;
+    std::vector<MeshBounds> meshBounds;
+
+private:
+    uint32_t findArchetype(ComponentMask mask, MeshId mesh);
+    const EntityRecord &getRecord(Entity entity) const;
+    uint32_t addRow(Archetype &archetype, Entity entity);
+    void removeRow(Archetype &archetype, uint32_t row);
+};
+
+#define E_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef HEADERS_ENTITYSYSTEMS_H_
+#define HEADERS_ENTITYSYSTEMS_H_
+
+#include "BatchMath.h"
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+/*
+    Per frame passes over the entity store, each one walks the
+    component arrays of every matching archetype front to back
+    Given a job system, rows are split in batches run as jobs
+*/
+
+// Rows of one archetype handled by a single job
+const size_t ENTITY_BATCH_SIZE = 4096;
+
+// Per instance data as it is written to the instance buffer
+struct InstanceData
+{
+    alignas(16) glm::mat4 model;
+    alignas(16) glm::mat4 previousModel; // one tick earlier, blended in by the renderer
+};
+
+// Contiguous instances drawing the same mesh
+struct InstanceBatch
+{
+    MeshId mesh = MESH_INVALID;
+    uint32_t firstInstance = 0;
+    uint32_t instanceCount = 0;
+};
+
+/*
+    Blends two world matrices column by column; close enough to a
+    proper rotation blend for the small steps between two ticks
+*/
+glm::mat4 interpolateTransform(const glm::mat4 &previous, const glm::mat4 &current, float alpha);
+
+// Start of a simulation tick, rows that moved last tick store their world matrix as the previous one
+void beginTransformTick(EntityStore &store, JobSystem *jobs = nullptr);
+
+// World matrices from position/rotation/scale, only rows set since the last update
+void updateWorldMatrices(EntityStore &store, JobSystem *jobs = nullptr);
+
+// World space spheres from the mesh bounds and world matrices, only rows that moved
+void updateWorldBounds(EntityStore &store, JobSystem *jobs = nullptr);
+
+// Flags entities whose world bounds intersect the frustum, returns the visible count
+size_t cullEntities(EntityStore &store, const Frustum &frustum, JobSystem *jobs = nullptr);
+
+/*
+    Packs the world matrices of visible entities grouped by mesh
+    Batches are ordered by mesh id, empty meshes produce no batch
+*/
+void packInstances(const EntityStore &store,
+                   std::vector<InstanceData> &instances,
+                   std::vector<InstanceBatch> &batches);
+
+#endif
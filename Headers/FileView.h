@@ -0,0 +1,71 @@
+#ifndef HEADERS_FILEVIEW_H_
+#define HEADERS_FILEVIEW_H_
+
+#include "ExceptionHandler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    Read only view of a whole file's bytes, released with the view.
+    The bytes are word aligned, so they can be handed to Vulkan as
+    SPIR-V and copied straight into staging memory without first
+    being read into a buffer of their own.
+
+    A view is a mapping of a file on disk, a range of another view's
+    mapping for files stored in an archive, or memory holding a file
+    unpacked from one. Mappings start on a page boundary.
+
+    A mapping sees the file as it was mapped as long as writers
+    replace it by renaming over it, truncating a mapped file in place
+    is not safe
+*/
+class FileView
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    FileView(void) = delete;
+    FileView(const FileView &) = delete;
+    FileView &operator=(const FileView &) = delete;
+
+    // populate : read every page in now, so later accesses never wait on the disk
+    explicit FileView(const std::string &path, bool populate = false);
+    // size bytes of archive from a word aligned offset, the archive stays mapped while the view lives
+    FileView(std::shared_ptr<const FileView> archive, size_t offset, size_t size, const std::string &path, bool populate = false);
+    // Contents held in memory, the first size bytes of words
+    FileView(std::vector<uint32_t> words, size_t size, const std::string &path);
+    ~FileView(void);
+
+    // nullptr for an empty file
+    const unsigned char *getData(void) const;
+    size_t getSize(void) const;
+    // Same bytes, aligned for VkShaderModuleCreateInfo::pCode
+    const uint32_t *getWords(void) const;
+
+    const std::string &getPath(void) const;
+
+private:
+    std::string path;
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+
+    // Owned mapping, only for views of a file on disk
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+    std::shared_ptr<const FileView> archive;
+    std::vector<uint32_t> words;
+};
+
+#define FV_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
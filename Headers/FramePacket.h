@@ -0,0 +1,83 @@
+#ifndef HEADERS_FRAMEPACKET_H_
+#define HEADERS_FRAMEPACKET_H_
+
+#include "EntitySystems.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Everything the render thread needs from one simulation tick
+struct FramePacket
+{
+    uint64_t tick = 0;
+    // Wall time the tick's state belongs to, see SimulationClock::getAlpha
+    std::chrono::steady_clock::time_point tickTime;
+
+    // Camera at the end of the previous tick and of this one
+    glm::vec3 previousCameraPosition = glm::vec3(0.0f);
+    glm::vec3 previousCameraForward = glm::vec3(0.0f, 0.0f, 1.0f);
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    glm::vec3 cameraForward = glm::vec3(0.0f, 0.0f, 1.0f);
+    // False when both ticks saw the same camera, the tick's matrices are then used as they are
+    bool cameraMoved = false;
+    glm::mat4 projection = glm::mat4(1.0f);
+    // Of this tick, culling ran against them
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    Frustum frustum;
+
+    // Visible instances grouped by mesh
+    std::vector<InstanceData> instances;
+    std::vector<InstanceBatch> batches;
+
+    // Camera alpha of the way from the previous tick to this one
+    glm::vec3 getCameraPosition(float alpha) const;
+    glm::mat4 getView(float alpha) const;
+    glm::mat4 getViewProjection(float alpha) const;
+    Frustum getFrustum(float alpha) const;
+};
+
+/*
+    Hands packets from the simulation thread to the render thread
+    Simulation and renderer each own a packet (double buffered) and
+    the newest published packet waits in a third slot, so neither
+    side ever waits on the other: the simulation overwrites a packet
+    the renderer has not picked up yet, the renderer keeps drawing
+    the packet it holds (further along between ticks) until a newer
+    one is published.
+    Packets are reused, their vectors keep their capacity
+*/
+class FrameExchange
+{
+public:
+    FrameExchange(void);
+    ~FrameExchange(void);
+    FrameExchange(const FrameExchange &) = delete;
+    FrameExchange &operator=(const FrameExchange &) = delete;
+
+    // Simulation thread : the packet to fill, owned until publish()
+    FramePacket &getWritePacket(void);
+    void publish(void);
+
+    // Render thread : the newest packet, blocks only until the first one, nullptr once stopped
+    const FramePacket *acquire(void);
+    // Wakes the render thread for good
+    void stop(void);
+
+private:
+    FramePacket packets[3];
+    size_t writeIndex = 0;
+    size_t readyIndex = 1;
+    size_t readIndex = 2;
+    bool fresh = false;
+    bool received = false;
+    bool stopping = false;
+
+    std::mutex exchangeMutex;
+    std::condition_variable published;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef HEADERS_GEOMETRYPOOL_H_
+#define HEADERS_GEOMETRYPOOL_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+
+#include <map>
+
+class MemoryHandler;
+
+// Identifies a mesh's vertex/index ranges within the pool
+// Offsets behind a handle may change after defragmentation
+// so they should be looked up when recording commands
+using GeometryHandle = uint32_t;
+const GeometryHandle GEOMETRY_INVALID_HANDLE = UINT32_MAX;
+
+// Where a mesh lives, heap indexes select the buffer to bind
+struct GeometryAllocation
+{
+    uint32_t vertexHeap = 0;
+    VkDeviceSize vertexOffset = 0;
+    VkDeviceSize vertexSize = 0;
+
+    uint32_t indexHeap = 0;
+    VkDeviceSize indexOffset = 0;
+    VkDeviceSize indexSize = 0;
+
+    bool live = false;
+};
+
+/*
+    Hands out vertex and index ranges for meshes from a set of
+    device local heaps; A new heap is added whenever a request does not
+    fit in the existing ones. Freed ranges are coalesced and heaps can
+    be compacted to remove holes left behind by unloaded meshes
+*/
+class GeometryPool
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    GeometryPool(void) = delete;
+    GeometryPool(const GeometryPool &) = delete;
+    GeometryPool &operator=(const GeometryPool &) = delete;
+
+    GeometryPool(MemoryHandler &memoryHandler, VkDeviceSize vertexHeapSize, VkDeviceSize indexHeapSize);
+    ~GeometryPool(void);
+
+    // Reserves ranges for a mesh, either size may be 0
+    GeometryHandle allocate(VkDeviceSize vertexBytes, VkDeviceSize indexBytes);
+    void free(GeometryHandle handle);
+
+    const GeometryAllocation &get(GeometryHandle handle) const;
+    VkBuffer getVertexBuffer(uint32_t heap) const;
+    VkBuffer getIndexBuffer(uint32_t heap) const;
+
+    // Records staging copies of mesh data into its ranges
+    // Staging memory is kept until releaseRetired()
+    void upload(VkCommandBuffer commandBuffer,
+                GeometryHandle handle,
+                const void *vertexData,
+                const void *indexData);
+
+    /*
+        Records copies packing every live range to the front of a new
+        buffer per fragmented heap, empty heaps other than the first are dropped
+        Replaced buffers are kept until releaseRetired()
+    */
+    void defragment(VkCommandBuffer commandBuffer);
+
+    // Frees staging/replaced buffers, only call once
+    // the command buffers that referenced them have completed
+    void releaseRetired(void);
+
+    // 0 when free space is one contiguous block per heap, approaches 1 as it splinters
+    float getFragmentation(void) const;
+
+    void cleanup(void);
+
+private:
+    struct Heap
+    {
+        VkBuffer buffer = nullptr;
+        VkDeviceMemory memory = nullptr;
+        VkDeviceSize size = 0;
+        // Free ranges keyed by offset -> size
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+    };
+
+    struct RetiredBuffer
+    {
+        VkBuffer buffer = nullptr;
+        VkDeviceMemory memory = nullptr;
+    };
+
+    MemoryHandler &memory;
+
+    VkDeviceSize vertexHeapSize = 0;
+    VkDeviceSize indexHeapSize = 0;
+
+    std::vector<Heap> vertexHeaps;
+    std::vector<Heap> indexHeaps;
+
+    std::vector<GeometryAllocation> allocations;
+    std::vector<GeometryHandle> freeHandles;
+
+    std::vector<RetiredBuffer> retired;
+
+private:
+    void createHeap(Heap &heap, VkDeviceSize size, VkBufferUsageFlags usage);
+
+    // Finds space in any heap, grows the heap list when none fits
+    void allocateRange(std::vector<Heap> &heaps,
+                       VkDeviceSize heapSize,
+                       VkBufferUsageFlags usage,
+                       VkDeviceSize bytes,
+                       uint32_t &heapIndex,
+                       VkDeviceSize &offset);
+    void freeRange(Heap &heap, VkDeviceSize offset, VkDeviceSize bytes);
+
+    void compactHeaps(VkCommandBuffer commandBuffer, std::vector<Heap> &heaps, bool isVertexHeap);
+
+    static VkDeviceSize alignSize(VkDeviceSize size);
+};
+
+#define GP_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
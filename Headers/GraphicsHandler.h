@@ -6,8 +6,25 @@
 #include "Defines.h"
 
 #include "MemoryHandler.h"
+#include "JobSystem.h"
+#include "TextureHandler.h"
+#include "AssetStreamer.h"
 #include "ExceptionHandler.h"
 #include "Models.h"
+#include "EntitySystems.h"
+#include "TransformHierarchy.h"
+#include "FramePacket.h"
+#include "RenderQueue.h"
+#include "BindlessDescriptors.h"
+#include "DescriptorAllocator.h"
+#include "DrawData.h"
+#include "ShaderReflection.h"
+#include "DescriptorLayoutCache.h"
+#include "ShaderWatcher.h"
+#include "FileView.h"
+#include "AssetPack.h"
+#include "StartupGraph.h"
+#include "DeviceCapabilities.h"
 #include "Keyboard.h"
 #include "Mouse.h"
 #include "Camera.h"
@@ -36,6 +53,9 @@ public:
         // makes all necessary calls to configure graphics pipeline
         void initGraphics(void);
 
+        // Draws and binds of the last recorded frame, render thread only
+        RenderStats getFrameStats(void) const;
+
 private:
         Display *display;
         Window *window;
@@ -59,29 +79,107 @@ private:
         VkSurfaceKHR m_Surface = nullptr;
         VkSwapchainKHR m_Swap = nullptr;
         VkCommandPool m_CommandPool = nullptr;
-        VkPipeline m_Pipeline = nullptr;
+        // One pipeline per available DrawDataPath, indexed by path
+        std::array<VkPipeline, DRAW_DATA_PATH_COUNT> m_Pipelines{};
+        // Depth only versions of m_Pipelines, created when DEPTH_PREPASS is set
+        std::array<VkPipeline, DRAW_DATA_PATH_COUNT> m_DepthPipelines{};
+        // Pipelines replaced by a shader reload and the frame they were replaced on
+        std::vector<std::pair<VkPipeline, uint64_t>> m_RetiredPipelines;
+        uint64_t m_ShaderFrame = 0;
         VkRenderPass m_RenderPass = nullptr;
         VkPipelineLayout m_PipelineLayout = nullptr;
+        // Loaded from PIPELINE_CACHE_FILE at startup and written back on destruction
+        VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+
+        // Read at startup for the layouts and modules, released once both exist
+        std::shared_ptr<const FileView> m_VertexCode;
+        std::shared_ptr<const FileView> m_FragmentCode;
+        std::vector<ShaderReflection> m_ShaderStages;
+
+        // Time to first frame is measured from initGraphics
+        std::chrono::high_resolution_clock::time_point m_StartupBegin;
+        bool m_FirstFramePresented = false;
 
-        VkDescriptorPool m_DescriptorPool = nullptr;
+        // Set 0 : draw constants + view matrices, set 1 : projection matrix
+        // Reflected from the shaders and owned by the cache
+        std::unique_ptr<DescriptorLayoutCache> layouts;
         std::vector<VkDescriptorSetLayout> m_DescriptorLayouts;
-        // Model + View matrix set
-        std::vector<VkDescriptorSetLayout> m_Set0Allocs;
-        // Projection matrix set
-        std::vector<VkDescriptorSetLayout> m_Set1Allocs;
+        // Bindings the shaders declare in each per-image set, only those are written
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> m_FrameSetBindings;
+        // Push constant block of every stage combined, size 0 when none has one
+        VkPushConstantRange m_ReflectedPushConstants{};
+
+        /*
+          Sets 0 and 1 come from per-frame pools, frames being swap
+          image indexes: an image's pools are reset once its previous
+          submission has completed, so nothing is rebuilt with the swapchain
+        */
+        std::unique_ptr<DescriptorAllocator> descriptors;
+        std::array<VkDescriptorSet, 2> m_FrameSets{};
+
+        // View/projection block then per-draw data, one mapped buffer per swap image
+        struct FrameUniforms
+        {
+          VkBuffer buffer = VK_NULL_HANDLE;
+          void *mapped = nullptr;
+          // Bindless buffer slot of the draw data as an instance table
+          uint32_t drawTable = BINDLESS_INVALID_INDEX;
+        };
+        std::vector<FrameUniforms> m_FrameUniforms;
+        // Offset of the per-draw data, aligned for both uniform and storage binding
+        VkDeviceSize m_DrawDataOffset = 0;
 
-        std::vector<VkDescriptorSet> m_ModelViewSets;
-        std::vector<VkDescriptorSet> m_ProjectionSets;
+        // Per-draw data path, and the one the frame being recorded uses
+        std::unique_ptr<DrawDataTuner> drawData;
+        DrawDataFrame m_FrameDrawData;
+
+        // Two timestamps per swap image around its render pass, read once its fence has passed
+        VkQueryPool m_TimestampPool = VK_NULL_HANDLE;
+        struct FrameTiming
+        {
+          DrawDataFrame drawData;
+          bool pending = false;
+        };
+        std::vector<FrameTiming> m_FrameTimings;
+
+        // Set BINDLESS_SET of every pipeline, bound once per command buffer
+        std::unique_ptr<BindlessDescriptors> bindless;
+        // Per-image set layouts followed by the bindless layout, referenced by pipelineLayoutInfo
+        std::vector<VkDescriptorSetLayout> m_PipelineSetLayouts;
+        VkPushConstantRange m_DrawConstantsRange{};
 
         VkDebugUtilsMessengerEXT m_Debug = nullptr;
         SwapChainSupportDetails m_SurfaceDetails{};
         std::vector<VkImage> m_SwapImages;
         std::vector<VkImageView> m_SwapViews;
         std::vector<VkFramebuffer> m_Framebuffers;
+
+        // Attachment 1 of every framebuffer, cleared each frame so nothing outlives a frame
+        VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+        VkImage m_DepthImage = VK_NULL_HANDLE;
+        VkDeviceMemory m_DepthMemory = VK_NULL_HANDLE;
+        VkImageView m_DepthView = VK_NULL_HANDLE;
+
+        // Attachment 0 when MSAA is on, the swap image is then the resolve attachment
+        VkImage m_ColorImage = VK_NULL_HANDLE;
+        VkDeviceMemory m_ColorMemory = VK_NULL_HANDLE;
+        VkImageView m_ColorView = VK_NULL_HANDLE;
         std::vector<VkCommandBuffer> m_CommandBuffers;
 
         /* Buffers, Memory, Mapped ptrs */
         std::unique_ptr<MemoryHandler> memory;
+
+        /* Frame and background jobs, must outlive anything submitting to them */
+        std::unique_ptr<JobSystem> jobs;
+
+        /* Decoded and uploaded textures */
+        std::unique_ptr<TextureHandler> textures;
+
+        /* Brings models and textures in while frames are rendered */
+        std::unique_ptr<AssetStreamer> streamer;
+
+        /* Recompiles edited shaders, only with SHADER_HOT_RELOAD and the sources present */
+        std::unique_ptr<ShaderWatcher> shaderWatcher;
         
         /* Configured after a device is selected */
         DEVICEINFO *selectedDevice = nullptr;
@@ -97,9 +195,51 @@ private:
         /* Rendered Objects */
         ModelClass Human;
 
+        // Per instance transforms, bounds and mesh references
+        EntityStore entities;
+        // Models drawn by entities, indexed by MeshId
+        std::vector<ModelClass *> renderMeshes;
+        // Parent/child placement of entities, created once the job system runs
+        std::unique_ptr<TransformHierarchy> transforms;
+
+        // Streaming requests of the models above, residency gates their bounds
+        std::unordered_map<const ModelClass *, AssetHandle> modelAssets;
+
+        // Texture requests by path and their bindless slots once resident
+        std::unordered_map<std::string, AssetHandle> textureAssets;
+        std::unordered_map<std::string, uint32_t> textureSlots;
+        // Slot of each mesh's texture, indexed by MeshId, pushed with its draws
+        std::vector<uint32_t> meshTextureSlots;
+
+        // Swap extent aspect, written by the render thread and read by the simulation
+        std::atomic<float> m_AspectRatio = 1.0f;
+
+        /*
+          Secondary command buffers recorded as jobs, one slot per
+          job system thread and swap image. Each slot has its own pool
+          since pools cannot be used from two threads at once
+        */
+        struct RecordSlot
+        {
+          VkCommandPool pool = VK_NULL_HANDLE;
+          VkCommandBuffer buffer = VK_NULL_HANDLE;
+          // Depth pre-pass draws of the same range, executed before any colour buffer
+          VkCommandBuffer depthBuffer = VK_NULL_HANDLE;
+          VkResult result = VK_SUCCESS;
+          // Both passes of the range, summed into m_FrameStats
+          RenderStats stats;
+          // Meshlet ranges surviving culling, reused every frame
+          std::vector<MeshletDrawRange> meshletDraws;
+        };
+        std::vector<std::vector<RecordSlot>> m_RecordSlots;
+
+        // Visible instances sorted by state, rebuilt once per packet and replayed while it is drawn
+        RenderQueue m_RenderQueue;
+        uint64_t m_QueuedTick = UINT64_MAX;
+        RenderStats m_FrameStats;
+
         /* Rendered Debug Objects */
-        uint gridEndOffset = 0;
-        uint gridStartOffset = 0;
+        GeometryHandle gridGeometry = GEOMETRY_INVALID_HANDLE;
         uint gridVertexDataSize = 0;
         std::vector<Vertex> grid;
 
@@ -128,6 +268,10 @@ private:
                 VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
                 VkAttachmentDescription colorAttachment{};
                 VkAttachmentReference colorAttachmentRef{};
+                VkAttachmentDescription depthAttachment{};
+                VkAttachmentReference depthAttachmentRef{};
+                VkAttachmentDescription resolveAttachment{};
+                VkAttachmentReference resolveAttachmentRef{};
                 VkSubpassDescription subpass{};
                 VkSubpassDependency dependency{};
                 VkRenderPassCreateInfo renderInfo{};
@@ -200,8 +344,22 @@ private:
         // Create views for returned swapchain images
         void createSwapViews(void);
 
-        // Create layout for resource bindings
+        // Depth image shared by every framebuffer, sized with the swapchain
+        VkFormat findDepthFormat(void);
+        void createDepthResources(void);
+
+        // Highest count both colour and depth attachments support, up to MSAA_MAX_SAMPLES
+        VkSampleCountFlagBits chooseSampleCount(void);
+        // Multisampled colour target resolved into the swap image, only when MSAA is on
+        void createColorResources(void);
+
+        // Reflects the shaders into set layouts and push constants, checking them against what the engine binds
         void createDescriptorSetLayout(void);
+        bool declaresBinding(uint32_t set, uint32_t binding) const;
+
+        // Opens and reflects the shader binaries, needs no device
+        void readShaders(void);
+        void createShaderModules(void);
 
         // Creates layout for pipeline
         void createPipelineLayout(void);
@@ -211,6 +369,29 @@ private:
 
         // Create graphic pipeline
         void createGraphicsPipeline(void);
+        // One pipeline per available draw data path from the current stage infos, and its pre-pass version
+        void buildPipelines(std::array<VkPipeline, DRAW_DATA_PATH_COUNT> &pipelines,
+                            std::array<VkPipeline, DRAW_DATA_PATH_COUNT> &depthPipelines);
+
+        // Compiled shader by file name, found from the executable rather than the working directory
+        static std::filesystem::path getShaderPath(const std::string &name);
+        // From the mounted packs, or the loose binary when it is newer work of hot reload
+        static std::shared_ptr<const FileView> openShader(const std::string &name);
+        // Mounts ASSET_PACK_FILE from beside the executable when there is one
+        void mountAssets(void);
+        static std::filesystem::path getPipelineCachePath(void);
+        void loadPipelineCache(void);
+        void savePipelineCache(void);
+        // Host write bandwidth of each UploadPath, with UPLOAD_BENCHMARK
+        void benchmarkUploads(void);
+        // Prints the time since initGraphics once, after the first present
+        void reportFirstFrame(void);
+        // Throws when a recompiled stage needs bindings, push constants or inputs the pipeline layout lacks
+        void checkShaderInterface(const ShaderReflection &reflection) const;
+        // Between frames : rebuilds the pipelines from shaders the watcher recompiled
+        void reloadShaders(void);
+        // Pipelines retired MAX_FRAMES_IN_FLIGHT frames ago, or all of them once the device is idle
+        void destroyRetiredPipelines(bool all);
 
         // Create framebuffers
         void createFrameBuffers(void);
@@ -223,31 +404,56 @@ private:
 
         void createSyncObjects(void);
         
-        void createDescriptorPool(void);
-
+        // Creates the descriptor allocator and the uniform buffers the frame sets point at
         void createDescriptorSets(void);
-
-        void bindDescriptorSets(void);
+        // Uniform buffers for swap images that have none yet, existing ones are kept
+        void createFrameUniforms(void);
+        // Resets the image's descriptor pools and fetches its sets 0 and 1 into m_FrameSets
+        void acquireFrameSets(uint32_t imageIndex);
+        // Tuner following device limits, and timestamps when the graphics queue has them
+        void createDrawDataTuner(void);
+        // Hands the image's last GPU time to the tuner, its fence must have been waited on
+        void readFrameTimestamps(uint32_t imageIndex);
         
 
 
 
-        void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-                         VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
-        VkImageView createImageView(VkImage image, VkFormat);
+        VkImageView createImageView(VkImage image, VkFormat, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+
+        // Queue assets with the streamer, they become resident over the next frames
+        void loadEntities(void);
+        void loadTextures(void);
+        // Called once a frame, never waits on loading
+        void streamAssets(const glm::vec3 &cameraPosition);
+        // Gives newly resident textures a bindless slot and points meshes at them
+        void updateBindlessTextures(void);
 
-        void loadentities(void);
+        void createEntities(void);
+        // Simulation thread : one tick of transform, cull and pack passes over the entity store into packet
+        void updateEntities(FramePacket &packet);
+        // Compacts the geometry pool once it is fragmented enough to matter
+        void defragmentGeometry(void);
         
-        void recordCommandBuffer(uint32_t imageIndex);
+        // alpha blends from the packet's previous tick to its own, see SimulationClock::getAlpha
+        void recordCommandBuffer(uint32_t imageIndex, const FramePacket &packet, float alpha);
+        // Sorts the packet's resident instances into m_RenderQueue, nothing to do for a packet already queued
+        void buildRenderQueue(const FramePacket &packet);
+        // Records queue items [firstItem, endItem) into the slot's secondary buffer
+        void recordInstances(uint32_t imageIndex,
+                             const FramePacket &packet,
+                             float alpha,
+                             RecordSlot &slot,
+                             uint32_t firstItem,
+                             uint32_t endItem,
+                             bool drawGrid);
 
         void updateUniformModelBuffer(uint32_t imageIndex);
-        void updateUniformVPBuffer(uint32_t imageIndex);
+        void updateUniformVPBuffer(uint32_t imageIndex, const FramePacket &packet, float alpha);
 
-        static std::vector<char> readFile(std::string filename);
         VkExtent2D chooseSwapChainExtent(void);
         VkSurfaceFormatKHR chooseSwapChainFormat(void);
         VkPresentModeKHR chooseSwapChainPresentMode(void);
-        VkShaderModule createShaderModule(const std::vector<char> &code);
+        VkShaderModule createShaderModule(const FileView &code);
         
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, int dstOffset, VkDeviceSize size);
         // Quick command buffer record start/end
@@ -256,7 +462,6 @@ private:
 
         void cleanupSwapChain(void);
         void recreateSwapChain(void);
-        void processModelData(ModelClass *modelObj);
 
         /*
                   Function pointers used to call debug utilities extension functions
@@ -271,7 +476,6 @@ private:
         PFN_vkCmdSetPrimitiveTopologyEXT vkCmdSetPrimitiveTopologyEXT = nullptr;
 
         void createGridVertices(void);
-        std::pair<int, int> loadGridVertices(std::pair<int, int> prevOffsets);
         void processGridData(void);
 };
 
@@ -0,0 +1,145 @@
+#ifndef HEADERS_JOBSYSTEM_H_
+#define HEADERS_JOBSYSTEM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+// Picks one worker less than the hardware concurrency, the creating thread makes up the rest
+const size_t JOB_SYSTEM_AUTO_WORKERS = SIZE_MAX;
+
+// Loops a worker spins looking for work before it sleeps
+const int JOB_SYSTEM_SPIN_COUNT = 64;
+
+struct Job
+{
+    std::function<void(void)> function;
+    JobCounter *counter = nullptr;
+};
+
+/*
+    Tracks a group of jobs, incremented when one is queued and
+    decremented when it finishes. Jobs queued with runAfter are held
+    here until the count drops to zero, they still run when a job of
+    the group threw; JobSystem::wait() rethrows the first exception.
+    Must outlive its jobs, JobSystem::wait() guarantees that
+*/
+class JobCounter
+{
+public:
+    JobCounter(void) = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    bool isDone(void) const
+    {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending = 0;
+    std::mutex continuationMutex;
+    std::vector<Job> continuations;
+    // Guarded by continuationMutex
+    std::exception_ptr exception;
+};
+
+/*
+    Work stealing scheduler, every thread owns a deque: it pushes and
+    pops at the back while idle threads steal from the front of the
+    others. The thread creating the system owns deque 0 and runs
+    jobs whenever it waits on a counter; other threads push round
+    robin and may still help while waiting.
+    Frame work (culling, transforms, recording) goes in the deques.
+    Long running work such as decoding goes in a background queue
+    only workers take from, once the deques are empty, so a thread
+    waiting on a counter never picks up a job that outlasts its frame
+*/
+class JobSystem
+{
+public:
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // 0 workers runs every job on the threads that wait
+    explicit JobSystem(size_t workerCount = JOB_SYSTEM_AUTO_WORKERS);
+    ~JobSystem(void);
+
+    void run(std::function<void(void)> function, JobCounter *counter = nullptr);
+    // Queued once dependency reaches zero, counter covers it from now on
+    void runAfter(JobCounter &dependency, std::function<void(void)> function, JobCounter *counter = nullptr);
+    // Runs queued jobs on the calling thread until counter reaches zero, then rethrows what any of them threw
+    void wait(JobCounter &counter);
+
+    // function(begin, end) on batches of at most batchSize items
+    template <typename Function>
+    void parallelFor(size_t count, size_t batchSize, Function function, JobCounter &counter)
+    {
+        for (size_t begin = 0; begin < count; begin += batchSize)
+        {
+            size_t end = std::min(begin + batchSize, count);
+            run([function, begin, end](void) { function(begin, end); }, &counter);
+        }
+        return;
+    }
+
+    // Queues a background job, the future carries its result or exception
+    template <typename Function>
+    auto submit(Function &&function) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+        pushBackground(Job{[task](void) { (*task)(); }, nullptr});
+        return result;
+    }
+
+    // Workers plus the creating thread
+    size_t getThreadCount(void) const;
+    // 0 for the creating thread, 1.. for workers, SIZE_MAX for any other thread
+    size_t getThreadIndex(void) const;
+
+private:
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    // Oldest first, taken by workers with nothing else to do
+    JobQueue background;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue = 0;
+
+    // Sleeping workers are only woken when jobs are queued
+    std::atomic<size_t> queuedJobs = 0;
+    std::atomic<size_t> sleepingWorkers = 0;
+    std::mutex sleepMutex;
+    std::condition_variable jobAvailable;
+    std::atomic<bool> stopping = false;
+
+private:
+    void push(Job job);
+    void pushBackground(Job job);
+    void wake(void);
+    bool pop(size_t index, Job &job);
+    bool popBackground(Job &job);
+    void execute(Job &job);
+    void finish(JobCounter &counter);
+    void workerLoop(size_t index);
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HEADERS_LZ4_H_
+#define HEADERS_LZ4_H_
+
+#include <cstddef>
+#include <vector>
+
+/*
+    LZ4 block format, without the frame around it. The compressor is
+    a single pass greedy matcher, fast rather than tight; anything an
+    LZ4 block encoder writes can be decompressed
+*/
+
+// Replaces out with the compressed block
+void compressLz4Block(const unsigned char *source, size_t size, std::vector<unsigned char> &out);
+
+// Returns false unless the block decompresses to exactly size bytes
+bool decompressLz4Block(const unsigned char *source, size_t sourceSize, unsigned char *destination, size_t size);
+
+#endif
@@ -4,26 +4,37 @@
 #include "ExceptionHandler.h"
 #include "Primitives.h"
 #include "Defines.h"
+#include "GeometryPool.h"
+#include "DeviceCapabilities.h"
+
+#include <memory>
+
+// Where data the host writes every frame is placed
+enum class UploadPath
+{
+    // Device local and host visible, written straight into video memory
+    Direct,
+    // Host memory the device reads across the bus
+    Host,
+    // Host memory copied into device local memory on the queue, geometry and textures go this way
+    Staged
+};
+
+const char *getUploadPathName(UploadPath path);
+
+// Share of the host visible device local heap direct buffers may take, the driver maps from it too
+const double DIRECT_UPLOAD_HEAP_SHARE = 0.25;
 
 struct MemoryInitParameters
 {
-    uint32_t vertexSize = 256;
-    uint32_t indexSize = 256;
+    // Block sizes of the geometry pool heaps
+    VkDeviceSize vertexSize = 256;
+    VkDeviceSize indexSize = 256;
     VkPhysicalDevice &m_PhysicalDevice;
     VkDevice &m_Device;
     DEVICEINFO *selectedDevice;
     SwapChainSupportDetails &m_SurfaceDetails;
-
-    MemoryInitParameters &operator=(MemoryInitParameters &n)
-    {
-        vertexSize = n.vertexSize;
-        indexSize = n.indexSize;
-        m_PhysicalDevice = n.m_PhysicalDevice;
-        m_Device = n.m_Device;
-        selectedDevice = n.selectedDevice;
-        m_SurfaceDetails = n.m_SurfaceDetails;
-    }
-} memVar;
+};
 
 class MemoryHandler
 {
@@ -43,27 +54,71 @@ public:
     MemoryHandler(MemoryInitParameters &params);
     ~MemoryHandler(void);
 
-    VkBuffer *createUniformBuffer(void);
+    /*
+        Host visible and coherent, mapped into *mapped until cleanup.
+        Placed in video memory while the direct budget lasts, in host
+        memory after that or without a large enough heap. Only ever
+        write through the mapping, reads from video memory are uncached
+    */
+    VkBuffer createUniformBuffer(VkDeviceSize size,
+                                 void **mapped,
+                                 VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                 UploadPath *path = nullptr);
+    // Direct when the device maps enough of its video memory, Host otherwise
+    UploadPath getUniformPath(void) const;
+
+    // Mapped buffer on the Direct or Host path, false when there is no memory for it. Freed by the caller
+    bool createMappedBuffer(VkDeviceSize size,
+                            VkBufferUsageFlags usage,
+                            UploadPath path,
+                            VkBuffer &buffer,
+                            VkDeviceMemory &bufferMemory,
+                            void **mapped);
+    // Device local and never mapped, filled by copies. Freed by the caller
+    void createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &bufferMemory);
+    // Offsets of uniform ranges bound from one buffer must be multiples of this
+    VkDeviceSize getUniformAlignment(void) const;
     VkDeviceMemory *getBufferMemory(VkBuffer *buf);
     void *getBufferPtr(VkBuffer *buf);
 
-    void appendVertexData();
+    /*
+        Image with its own memory allocation. preferred flags are
+        added to properties when a memory type has them all (lazily
+        allocated for transient attachments), otherwise dropped
+    */
+    void createImage(uint32_t width,
+                     uint32_t height,
+                     uint32_t mipLevels,
+                     VkFormat format,
+                     VkImageTiling tiling,
+                     VkImageUsageFlags usage,
+                     VkMemoryPropertyFlags properties,
+                     VkImage &image,
+                     VkDeviceMemory &imageMemory,
+                     VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT,
+                     VkMemoryPropertyFlags preferred = 0);
 
     void cleanup(void);
 
+    // Vertex/index storage for every mesh
+    std::unique_ptr<GeometryPool> geometry;
+
 private:
+    friend class GeometryPool;
+    friend class TextureHandler;
+
+    MemoryInitParameters memVar;
 
     std::vector<VkBuffer> m_UniformBuffers;
     std::vector<VkDeviceMemory> m_UniformMemory;
     std::vector<void *> m_UniformPtrs;
 
-    VkBuffer m_VertexBuffer = nullptr;
-    VkDeviceMemory m_VertexMemory = nullptr;
-    void *m_VertexPtr = nullptr;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
 
-    VkBuffer m_IndexBuffer = nullptr;
-    VkDeviceMemory m_IndexMemory = nullptr;
-    void *m_IndexPtr = nullptr;
+    // Device local, host visible and coherent type on the largest such heap, UINT32_MAX without one
+    uint32_t directType = UINT32_MAX;
+    VkDeviceSize directBudget = 0;
+    VkDeviceSize directUsed = 0;
 
 private:
     void createBuffer(VkDeviceSize size,
@@ -71,13 +126,21 @@ private:
                       VkMemoryPropertyFlags properties,
                       VkBuffer &buffer,
                       VkDeviceMemory &bufferMemory);
-    void createVertexBuffer(void);
-    void createIndexBuffer(void);
+    // On typeIndex, or the first type with properties for UINT32_MAX; false and nothing created without memory for it
+    bool tryCreateBuffer(VkDeviceSize size,
+                         VkBufferUsageFlags usage,
+                         VkMemoryPropertyFlags properties,
+                         uint32_t typeIndex,
+                         VkBuffer &buffer,
+                         VkDeviceMemory &bufferMemory);
+    // Direct uploads only pay off on a heap larger than the fixed 256 MiB BAR window
+    void findDirectMemory(void);
 
     //std::vector<VkImage> m_SwapImages;
     //void createUniformBuffers(void);
 
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    bool tryFindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex);
 };
 
 #define M_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
@@ -0,0 +1,83 @@
+#ifndef HEADERS_MESHLET_H_
+#define HEADERS_MESHLET_H_
+
+#include "Primitives.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Dense meshes are split into small clusters of triangles (meshlets)
+    Each cluster carries a bounding sphere and a normal cone so whole
+    groups of triangles can be rejected before any draw is emitted
+*/
+
+// Limits per cluster, 124 triangles keeps the local index
+// list of a cluster within a multiple of 4 bytes
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+    // Range into MeshletData::vertices
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+
+    // Range into MeshletData::indices, always a multiple of 3
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+
+    // Bounding sphere in model space
+    glm::vec3 center = {0.0f, 0.0f, 0.0f};
+    float radius = 0.0f;
+
+    // Normal cone, a cutoff of 1 means the cluster
+    // faces too many directions to ever be back facing
+    glm::vec3 coneAxis = {0.0f, 0.0f, 0.0f};
+    float coneCutoff = 1.0f;
+};
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+
+    // Unique vertices referenced by each meshlet
+    std::vector<uint32_t> vertices;
+
+    // Triangle list reordered so each meshlet is a contiguous range
+    // Values index the original vertex data so the same vertex buffer
+    // can be bound and ranges drawn with vkCmdDrawIndexed
+    std::vector<uint16_t> indices;
+};
+
+// A contiguous range of MeshletData::indices that survived culling
+struct MeshletDrawRange
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// Partitions a triangle list into meshlets
+// frontFace must match the pipeline so normal cones point outward
+bool buildMeshlets(const std::vector<Vertex> &vertices,
+                   const std::vector<uint16_t> &indices,
+                   MeshletData &meshletData,
+                   VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE);
+
+// Self check, ensures the meshlets cover exactly the original triangle set
+// and that no meshlet exceeds the vertex/triangle limits
+bool validateMeshletCoverage(const std::vector<uint16_t> &originalIndices,
+                             const MeshletData &meshletData);
+
+/*
+    Rejects meshlets outside the frustum or facing away from the camera
+    Surviving neighbouring meshlets are merged into a single draw range
+    Results are appended to drawRanges
+*/
+void cullMeshlets(const MeshletData &meshletData,
+                  const glm::mat4 &model,
+                  const Frustum &frustum,
+                  const glm::vec3 &cameraPosition,
+                  std::vector<MeshletDrawRange> &drawRanges);
+
+#endif
@@ -2,6 +2,8 @@
 #define __MODELS_H_
 
 #include "Primitives.h"
+#include "Meshlet.h"
+#include "GeometryPool.h"
 
 /*
 Base class for all objects that contain vertex data
@@ -15,62 +17,57 @@ Uses Primitives defined in Primitives.h
 #include <string>
 #include <iostream>
 
-// Total allocation for static vertex and index information
-// Data stored in buffers allocated with these constants define MODELS themselves
+// Block size of each geometry pool heap for static vertex and index information
+// The pool adds another block when the existing ones cannot fit a model,
+// grown to the model's size when it is larger than a block
 const int VERTEX_BUFFER_SIZE = 256000000; // 256 MB
 const int INDEX_BUFFER_SIZE = 100000000;  // 100 MB
 // Max uniform buffer size is defined later
 // each graphics device has max which we cannot exceed
 
-class HumanClass
-{
-public:
-  HumanClass(void);
-  ~HumanClass(void);
-
-  /* Model matrix */
-  // Applied to model TYPE vertex data
-  // to achieve a position in WORLD
-  glm::vec3 position;
-  glm::mat4 worldMatrix;
-};
-
 class ModelClass
 {
 public:
   // Will handle loading model data
-  ModelClass(std::string modelTypeName);
+  ModelClass(std::string modelTypeName, std::string modelTexturePath = "");
   ModelClass(void) = delete;
   ~ModelClass(void);
 
   // safety
   ModelClass &operator=(const ModelClass &) = delete;
 
-  // These offsets help each object type track it's own
-  // location in memory; These offsets can be passed to
-  // vulkan binding functions and subsequently the shader
-  // Vertex offset for vertex buffer, etc
-  uint vertexStartOffset = 0;
-  uint indexStartOffset = 0;
+  // Location of this object type's vertex/index data within
+  // the geometry pool; Offsets are looked up through the handle
+  // as defragmentation may move them
+  GeometryHandle geometry = GEOMETRY_INVALID_HANDLE;
 
   int vertexDataSize = 0;
   int indexDataSize = 0;
   std::string typeName;
+  // Sampled by every instance, empty for none
+  std::string texturePath;
 
-  // Returns offsets for VERTEX, INDEX buffer respectively
-  std::pair<int, int> loadModelData(std::pair<int, int> vertexAndIndexBufferOffsets);
+  // Fills vertices/indices, returns false if the data is unusable
+  bool loadModelData(void);
 
   /*
-        ** Humans share the same vertex/index data
+        ** Instances share the same vertex/index data
         **
-        ** In HumanClass, individualized data such as
-        ** transformation data, color data, texture data etc can be defined
+        ** Per instance data such as transforms lives in
+        ** the entity store, see EntityStore.h
          */
-  std::vector<HumanClass> humans;
 
   // Describe this model TYPE
   std::vector<Vertex> vertices;
   std::vector<uint16_t> indices;
+
+  // Model space bounding sphere, set by loadModelData
+  glm::vec3 boundsCenter = {0.0f, 0.0f, 0.0f};
+  float boundsRadius = 0.0f;
+
+  // Only populated for dense meshes, when present
+  // `indices` holds the meshlet ordered triangle list
+  MeshletData meshlets;
 };
 
 #endif // __MODELS_H_
@@ -53,12 +53,83 @@ struct Vertex
 	}
 };
 
+// Six planes extracted from a view projection matrix
+// xyz holds the inward facing normal, w the distance
+struct Frustum
+{
+	std::array<glm::vec4, 6> planes;
+
+	static Frustum fromMatrix(const glm::mat4 &viewProjection)
+	{
+		Frustum frustum;
+
+		// glm is column major, gather rows
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4(viewProjection[0][i],
+								viewProjection[1][i],
+								viewProjection[2][i],
+								viewProjection[3][i]);
+		}
+
+		frustum.planes[0] = rows[3] + rows[0]; // left
+		frustum.planes[1] = rows[3] - rows[0]; // right
+		frustum.planes[2] = rows[3] + rows[1]; // bottom
+		frustum.planes[3] = rows[3] - rows[1]; // top
+		frustum.planes[4] = rows[2];		   // near -- depth range is 0..1, far with reverse-Z
+		frustum.planes[5] = rows[3] - rows[2]; // far, near with reverse-Z
+
+		for (auto &plane : frustum.planes)
+		{
+			float length = glm::length(glm::vec3(plane));
+			// Infinite projections leave a degenerate plane, treat as always inside
+			if (length < 1e-6f)
+			{
+				plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+				continue;
+			}
+			plane /= length;
+		}
+		return frustum;
+	}
+
+	bool intersectsSphere(const glm::vec3 &center, float radius) const
+	{
+		for (const auto &plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
 // Binding = 0
 struct UniformModelBuffer
 {
 	alignas(16) glm::mat4 model;
 };
 
+/*
+	Per-draw data visible to vertex and fragment stages, pushed or
+	read from a buffer depending on the DrawDataPath in use
+	Indexes select from the global bindless arrays, UINT32_MAX for none
+	The indexes come first so DRAW_CONSTANTS_HEADER_SIZE bytes can be
+	pushed on their own when the matrix comes from elsewhere
+*/
+struct DrawConstants
+{
+	// Bindless buffer slot of the frame's instance table, read from push constants only
+	uint32_t drawTable = UINT32_MAX;
+	uint32_t textureIndex = UINT32_MAX;
+	uint32_t materialIndex = UINT32_MAX;
+	alignas(16) glm::mat4 model;
+};
+const uint32_t DRAW_CONSTANTS_HEADER_SIZE = 16;
+
 // Binding = 1
 struct UniformVPBuffer
 {
@@ -0,0 +1,109 @@
+#ifndef HEADERS_RENDERQUEUE_H_
+#define HEADERS_RENDERQUEUE_H_
+
+#include "Primitives.h"
+
+#include <cstdint>
+#include <vector>
+
+// Draw and bind counts of one frame, summed over every command buffer recorded for it
+struct RenderStats
+{
+    uint32_t drawCalls = 0;
+    uint32_t pushConstants = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    // Binds left out because the same state was already bound
+    uint32_t skippedBinds = 0;
+
+    RenderStats &operator+=(const RenderStats &other);
+};
+
+/*
+    One instance to draw. Sorting by key groups items by pipeline,
+    then descriptor set, then vertex buffer and mesh, then front to
+    back so early depth tests reject what is hidden behind nearer items
+*/
+struct DrawItem
+{
+    uint64_t key = 0;
+    uint32_t instance = 0;
+    uint32_t mesh = 0;
+};
+
+/*
+    Key layout, most significant first
+        8 bits  pipeline
+        8 bits  descriptor set
+        8 bits  vertex heap
+        16 bits mesh, which fixes the vertex buffer offset
+        24 bits depth, the high bits of the positive float
+*/
+uint64_t makeDrawKey(uint8_t pipeline, uint8_t descriptorSet, uint8_t vertexHeap, uint16_t mesh, float depth);
+
+class RenderQueue
+{
+public:
+    RenderQueue(void);
+    ~RenderQueue(void);
+
+    // Items keep their capacity across frames
+    void clear(void);
+    void push(const DrawItem &item);
+    void sort(void);
+
+    const std::vector<DrawItem> &getItems(void) const;
+    size_t size(void) const;
+
+private:
+    std::vector<DrawItem> items;
+    // Radix sort ping pong buffer
+    std::vector<DrawItem> scratch;
+};
+
+/*
+    Wraps a command buffer and leaves out binds that would set what is
+    already bound. Command buffers start with nothing bound, so each
+    one being recorded needs its own cache
+*/
+class BindCache
+{
+public:
+    BindCache(VkCommandBuffer commandBuffer, RenderStats &stats);
+    ~BindCache(void);
+
+    void bindPipeline(VkPipeline pipeline);
+    // setIndex below MAX_BOUND_SETS, each index is tracked on its own
+    void bindDescriptorSet(VkPipelineLayout layout,
+                           uint32_t setIndex,
+                           VkDescriptorSet set,
+                           uint32_t dynamicOffsetCount,
+                           const uint32_t *dynamicOffsets);
+    void bindVertexBuffer(VkBuffer buffer, VkDeviceSize offset);
+    void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+
+private:
+    VkCommandBuffer commandBuffer;
+    RenderStats &stats;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    // Offsets a set was last bound with, sets with more are always rebound
+    static const uint32_t MAX_DYNAMIC_OFFSETS = 4;
+    static const uint32_t MAX_BOUND_SETS = 4;
+    struct BoundSet
+    {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        uint32_t dynamicOffsets[MAX_DYNAMIC_OFFSETS] = {};
+        uint32_t dynamicOffsetCount = 0;
+    };
+    BoundSet sets[MAX_BOUND_SETS];
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize vertexOffset = 0;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indexOffset = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef HEADERS_SHADERREFLECTION_H_
+#define HEADERS_SHADERREFLECTION_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Resource a shader declares, count 0 for runtime sized arrays
+struct ReflectedBinding
+{
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uint32_t count = 1;
+};
+
+// Vertex stage input at one location, matrices take one location per column
+struct ReflectedInput
+{
+    uint32_t location = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+};
+
+/*
+    Reads what a SPIR-V module expects from the pipeline around it:
+    descriptor bindings, the push constant block and vertex inputs.
+    Only the declarations are parsed, function bodies are skipped, so
+    resources a shader declares but never touches are still reported.
+
+    The module must be valid SPIR-V, anything malformed throws
+*/
+class ShaderReflection
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    ShaderReflection(void) = delete;
+
+    // size in bytes, code aligned to a word as Vulkan takes it
+    ShaderReflection(const uint32_t *code, size_t size);
+    ~ShaderReflection(void);
+
+    VkShaderStageFlagBits getStage(void) const;
+    const std::vector<ReflectedBinding> &getBindings(void) const;
+    const std::vector<ReflectedInput> &getInputs(void) const;
+    // Size 0 when the stage has no push constants
+    VkPushConstantRange getPushConstants(void) const;
+
+    // Throws when an input has no attribute or reads it as another numeric type
+    void checkVertexInput(const std::vector<VkVertexInputAttributeDescription> &attributes) const;
+
+    /*
+        Bindings of every stage combined, indexed by set then sorted by
+        binding. Stages declaring the same binding must agree on its type
+        and count, the stage flags are merged
+    */
+    static std::vector<std::vector<VkDescriptorSetLayoutBinding>> mergeBindings(const std::vector<ShaderReflection> &stages);
+    // One range covering every stage's block, size 0 when no stage has one
+    static VkPushConstantRange mergePushConstants(const std::vector<ShaderReflection> &stages);
+
+private:
+    // The declarations of a type the reflection needs, by result id
+    struct Type
+    {
+        uint32_t opcode = 0;
+        // Component, element, column or pointee type
+        uint32_t element = 0;
+        // Components, columns or array length; bit width for scalars
+        uint32_t count = 0;
+        // Sampled or depth/sampled flags of images, signedness of ints, storage class of pointers
+        uint32_t flags = 0;
+        uint32_t dimension = 0;
+        std::vector<uint32_t> members;
+    };
+
+    struct Decorations
+    {
+        uint32_t set = UINT32_MAX;
+        uint32_t binding = UINT32_MAX;
+        uint32_t location = UINT32_MAX;
+        uint32_t arrayStride = 0;
+        bool builtIn = false;
+        bool block = false;
+        bool bufferBlock = false;
+        // Per member of a struct
+        std::vector<uint32_t> memberOffsets;
+        std::vector<uint32_t> matrixStrides;
+    };
+
+    struct Variable
+    {
+        uint32_t id = 0;
+        uint32_t pointerType = 0;
+        uint32_t storageClass = 0;
+    };
+
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+    std::vector<ReflectedBinding> bindings;
+    std::vector<ReflectedInput> inputs;
+    VkPushConstantRange pushConstants{};
+
+    std::unordered_map<uint32_t, Type> types;
+    std::unordered_map<uint32_t, Decorations> decorations;
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::vector<Variable> variables;
+
+private:
+    void parse(const uint32_t *words, size_t wordCount);
+    void reflectVariables(void);
+
+    const Type &getType(uint32_t id) const;
+    VkDescriptorType getDescriptorType(uint32_t typeId, uint32_t storageClass) const;
+    uint32_t getArrayCount(uint32_t &typeId) const;
+    uint32_t getSize(uint32_t typeId) const;
+    VkFormat getInputFormat(uint32_t typeId) const;
+};
+
+#define SR_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef HEADERS_SHADERWATCHER_H_
+#define HEADERS_SHADERWATCHER_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+#include "FileView.h"
+
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Quiet time after the last change to a source before it is compiled, editors save in several writes
+const int SHADER_RELOAD_SETTLE_MS = 50;
+
+// A changed source run through the compiler, code is null when it failed
+struct CompiledShader
+{
+    std::filesystem::path source;
+    std::filesystem::path binary;
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+    std::unique_ptr<FileView> code;
+    // Compiler output, the errors when code is null
+    std::string log;
+    double milliseconds = 0.0;
+};
+
+/*
+    Watches a directory of GLSL sources with inotify and recompiles
+    the ones that change with SHADER_COMPILER on its own thread, so
+    neither the frame loop nor the job system waits on the compiler.
+
+    The stage comes from the extension and names the binary :
+    shader.vert is written to vert.spv, shader.frag to frag.spv.
+    Binaries are replaced only when compilation succeeds, a failed
+    edit leaves the last good one in place
+*/
+class ShaderWatcher
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    ShaderWatcher(void) = delete;
+    ShaderWatcher(const ShaderWatcher &) = delete;
+    ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+    ShaderWatcher(const std::filesystem::path &sourceDirectory, const std::filesystem::path &binaryDirectory);
+    ~ShaderWatcher(void);
+
+    // Shaders compiled since the last call, never blocks
+    std::vector<CompiledShader> takeCompiled(void);
+
+    // Directory of the running executable, shader sources and binaries are found from it
+    static std::filesystem::path getExecutableDirectory(void);
+
+private:
+    std::filesystem::path sourceDirectory;
+    std::filesystem::path binaryDirectory;
+
+    int notifyFd = -1;
+    // Written by the destructor to wake the watch thread
+    int wakeFd = -1;
+
+    std::mutex compiledMutex;
+    std::vector<CompiledShader> compiled;
+    std::thread watchThread;
+
+private:
+    void watchLoop(void);
+    CompiledShader compile(const std::string &name) const;
+
+    // Stage and binary name of a source, false for files that are not shader sources
+    static bool getStage(const std::string &name, VkShaderStageFlagBits &stage, std::string &binary);
+};
+
+#define SW_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef HEADERS_SIMULATIONCLOCK_H_
+#define HEADERS_SIMULATIONCLOCK_H_
+
+#include <chrono>
+#include <cstdint>
+
+// Ticks run at once after a stall, older time is dropped instead of simulated
+const int SIMULATION_MAX_CATCHUP_TICKS = 8;
+
+/*
+    Fixed timestep accumulator. Wall time piles up between calls to
+    advance() and is spent in whole ticks of getTickSeconds(), each
+    tick's state belongs to a point in wall time so the renderer can
+    tell how far it is between two ticks
+*/
+class SimulationClock
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SimulationClock(int tickRate);
+    ~SimulationClock(void);
+
+    // Ticks due since the last call, capped at SIMULATION_MAX_CATCHUP_TICKS
+    int advance(void);
+    // Consumes one due tick, returns the wall time its state belongs to
+    Clock::time_point step(void);
+
+    Clock::time_point getNextTickTime(void) const;
+    float getTickSeconds(void) const;
+    uint64_t getTickCount(void) const;
+
+    /*
+        Fraction of the way from the tick before tickTime to tickTime
+        that should be on screen at now; drawing one tick behind keeps
+        it within 0 and 1 while ticks arrive on time
+    */
+    float getAlpha(Clock::time_point tickTime, Clock::time_point now) const;
+
+private:
+    Clock::duration tickLength;
+    // Wall time covered by the ticks run so far, the accumulator is now minus this
+    Clock::time_point simulatedUntil;
+    uint64_t tickCount = 0;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef HEADERS_STARTUPGRAPH_H_
+#define HEADERS_STARTUPGRAPH_H_
+
+#include "ExceptionHandler.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Handle of a stage, only stages added before it can be depended on so the graph never cycles
+using StartupStage = size_t;
+
+/*
+    Startup work split into named stages, each runs as a job once
+    every stage it depends on has finished. Independent stages share
+    the job system's threads and the creating thread helps while it
+    waits in run().
+
+    A stage that throws stops the ones after it from starting, run()
+    rethrows the first exception once the running ones are done.
+    Every stage is timed, printTimings() lists them with the critical
+    path, the chain that decides time to first frame
+*/
+class StartupGraph
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    StartupGraph(const StartupGraph &) = delete;
+    StartupGraph &operator=(const StartupGraph &) = delete;
+
+    StartupGraph(void) = default;
+    ~StartupGraph(void) = default;
+
+    StartupStage add(const std::string &name, std::initializer_list<StartupStage> dependencies, std::function<void(void)> function);
+
+    // Runs every stage, returns once all have finished
+    void run(JobSystem &jobs);
+
+    // Per stage start and duration from the start of run(), then the critical path
+    void printTimings(void) const;
+
+private:
+    struct Stage
+    {
+        std::string name;
+        std::function<void(void)> function;
+        std::vector<StartupStage> dependencies;
+        std::vector<StartupStage> dependents;
+
+        double startMs = 0.0;
+        double endMs = 0.0;
+        size_t thread = 0;
+        bool ran = false;
+    };
+
+    std::vector<Stage> stages;
+    // Dependencies left per stage, only alive during run()
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining;
+
+    JobSystem *jobs = nullptr;
+    JobCounter *counter = nullptr;
+    std::chrono::high_resolution_clock::time_point start;
+    double totalMs = 0.0;
+
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+
+private:
+    void launch(StartupStage stage);
+    void execute(StartupStage stage);
+};
+
+#define SG_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
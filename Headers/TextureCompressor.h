@@ -0,0 +1,38 @@
+#ifndef HEADERS_TEXTURECOMPRESSOR_H_
+#define HEADERS_TEXTURECOMPRESSOR_H_
+
+#include "Defines.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    CPU block compressors for RGBA8 texel data
+    Inputs are width * height * 4 bytes, edges that do not fill
+    a 4x4 block are padded by repeating the last row/column
+
+    BC1 : 8 bytes per block, opaque only
+    BC3 : 16 bytes per block, BC1 color + interpolated alpha
+    BC7 : 16 bytes per block, encoded as mode 6 (single subset RGBA)
+*/
+
+bool isBlockCompressed(VkFormat format);
+
+// Bytes of one block or, for uncompressed RGBA8, one texel
+uint32_t getFormatBlockBytes(VkFormat format);
+
+// Size of a width x height level stored in format
+VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+void compressBC1(const unsigned char *rgba, uint32_t width, uint32_t height, std::vector<unsigned char> &blocks);
+void compressBC3(const unsigned char *rgba, uint32_t width, uint32_t height, std::vector<unsigned char> &blocks);
+void compressBC7(const unsigned char *rgba, uint32_t width, uint32_t height, std::vector<unsigned char> &blocks);
+
+// Dispatches on format, RGBA8 formats are copied as is
+void compressLevel(VkFormat format,
+                   const unsigned char *rgba,
+                   uint32_t width,
+                   uint32_t height,
+                   std::vector<unsigned char> &out);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef HEADERS_TEXTURECONTAINER_H_
+#define HEADERS_TEXTURECONTAINER_H_
+
+#include "Defines.h"
+#include "FileView.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    Texture container laid out after KTX2 : a fixed header, a level
+    index ordered from the base level down, and level data stored
+    smallest mip first, each level aligned to 16 bytes
+
+    Level data is stored exactly as uploaded so loading maps the file
+    and copies each level from the mapping into staging memory
+*/
+
+const char TEXTURE_CONTAINER_MAGIC[4] = {'V', 'T', 'E', 'X'};
+const uint32_t TEXTURE_CONTAINER_VERSION = 1;
+const char TEXTURE_CONTAINER_EXTENSION[] = ".vtex";
+
+struct TextureContainerHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vkFormat;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+};
+
+struct TextureContainerLevel
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+};
+
+// One mip level, texels or blocks depending on the format
+struct TextureLevel
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Texels built in memory, empty when the level is read in place from TextureData::file
+    std::vector<unsigned char> data;
+    const unsigned char *mapped = nullptr;
+    size_t mappedSize = 0;
+
+    const unsigned char *getBytes(void) const;
+    size_t getSize(void) const;
+};
+
+// Everything needed to upload a texture, levels[0] is the base level
+struct TextureData
+{
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<TextureLevel> levels;
+    // Container the levels point into, kept mapped as long as the data lives
+    std::shared_ptr<const FileView> file;
+};
+
+// Levels in a full chain down to 1x1, the most a container may hold
+uint32_t getTextureLevelCount(uint32_t width, uint32_t height);
+
+// Returns false if the file could not be written
+bool writeTextureContainer(const std::string &path, const TextureData &texture);
+
+/*
+    Levels are left in the mapping, returns false if it is truncated or
+    inconsistent, holds more levels than its size has, or is block
+    compressed without the full chain (blits cannot fill the rest)
+*/
+bool parseTextureContainer(std::shared_ptr<const FileView> file, TextureData &texture);
+
+// Returns false if the file is missing, truncated or inconsistent
+bool readTextureContainer(const std::string &path, TextureData &texture);
+
+#endif
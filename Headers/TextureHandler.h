@@ -0,0 +1,164 @@
+#ifndef HEADERS_TEXTUREHANDLER_H_
+#define HEADERS_TEXTUREHANDLER_H_
+
+#include "ExceptionHandler.h"
+#include "Defines.h"
+#include "JobSystem.h"
+#include "TextureContainer.h"
+#include "AssetPack.h"
+
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+class MemoryHandler;
+
+// GPU side texture, sampled in fragment shaders
+struct Texture
+{
+    VkImage image = nullptr;
+    VkDeviceMemory memory = nullptr;
+    VkImageView view = nullptr;
+    VkSampler sampler = nullptr;
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+};
+
+/*
+    Decodes image files on worker threads and uploads them with a full
+    mip chain; Decoded pixels are cached by path and modification time
+    so unloading and loading the same file again skips decoding
+
+    When the device samples BC formats, images are compressed with
+    their mips on first import and written beside the source as a
+    .vtex container; later runs upload those blocks without decoding
+    .vtex files can also be loaded directly when the device samples
+    their format, compressed ones only with their full mip chain
+*/
+class TextureHandler
+{
+    // Streams files through the same decode and upload steps
+    friend class AssetStreamer;
+
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    TextureHandler(void) = delete;
+    TextureHandler(const TextureHandler &) = delete;
+    TextureHandler &operator=(const TextureHandler &) = delete;
+
+    TextureHandler(MemoryHandler &memoryHandler, JobSystem &jobSystem);
+    ~TextureHandler(void);
+
+    // Starts decoding in the background, call early for files needed soon
+    void prefetch(const std::string &path);
+
+    /*
+        Waits for the decode if still running then records the upload
+        and mip generation into commandBuffer; Already loaded textures
+        are returned as is. Staging memory is kept until releaseStaging()
+    */
+    const Texture &load(VkCommandBuffer commandBuffer, const std::string &path);
+
+    const Texture &get(const std::string &path) const;
+    bool isLoaded(const std::string &path) const;
+
+    // Destroys GPU resources, decoded pixels remain cached
+    void unload(const std::string &path);
+
+    // Only call once the command buffers recorded by load() have completed
+    void releaseStaging(void);
+
+    // Drops cached pixels of files that are not in flight
+    void clearDecodeCache(void);
+
+    void cleanup(void);
+
+private:
+    using DecodeResult = std::shared_future<std::shared_ptr<const TextureData>>;
+
+    // Decided once per device, handed to workers by value
+    struct FormatSupport
+    {
+        bool linearBlit = false;
+        VkFormat opaqueFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        VkFormat alphaFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        // Block formats the device samples, containers may hold any of them
+        bool sampledBC1 = false;
+        bool sampledBC3 = false;
+        bool sampledBC7 = false;
+    };
+
+    struct DecodeEntry
+    {
+        std::filesystem::file_time_type writeTime;
+        DecodeResult result;
+    };
+
+    struct StagingBuffer
+    {
+        VkBuffer buffer = nullptr;
+        VkDeviceMemory memory = nullptr;
+    };
+
+    MemoryHandler &memory;
+    JobSystem &jobs;
+    FormatSupport support;
+
+    std::unordered_map<std::string, DecodeEntry> decodeCache;
+    std::unordered_map<std::string, Texture> textures;
+    std::vector<StagingBuffer> staging;
+
+private:
+    DecodeResult requestDecode(const std::string &path);
+    // Compressed copy when it is usable, path otherwise
+    static std::string getSourcePath(const std::string &path, FormatSupport support);
+
+    // file maps getSourcePath(path), containers are uploaded from it without a copy
+    static std::shared_ptr<const TextureData> prepare(const std::string &path,
+                                                      std::shared_ptr<const FileView> file,
+                                                      FormatSupport support);
+    static TextureLevel decode(const std::string &path, const FileView &file);
+    static bool isSampled(VkFormat format, FormatSupport support);
+    // Partial RGBA8 chains are completed on the CPU when the device cannot blit them
+    static void completeMipChain(TextureData &texture, FormatSupport support);
+
+    // Records the copies of already prepared levels, throws before recording anything
+    const Texture &upload(VkCommandBuffer commandBuffer, const std::string &path, const TextureData &data);
+
+    // CPU box filtered chain of RGBA8 levels, base level excluded
+    static std::vector<TextureLevel> buildMipChain(const TextureLevel &base, uint32_t mipLevels);
+    static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+    void querySupport(void);
+    bool hasFeatures(VkFormat format, VkFormatFeatureFlags features);
+    void recordMipBlits(VkCommandBuffer commandBuffer, Texture &texture);
+    void transitionLevels(VkCommandBuffer commandBuffer,
+                          VkImage image,
+                          uint32_t baseMip,
+                          uint32_t levelCount,
+                          VkImageLayout oldLayout,
+                          VkImageLayout newLayout,
+                          VkAccessFlags srcAccess,
+                          VkAccessFlags dstAccess,
+                          VkPipelineStageFlags srcStage,
+                          VkPipelineStageFlags dstStage);
+
+    void createView(Texture &texture);
+    void createSampler(Texture &texture);
+    void destroyTexture(Texture &texture);
+};
+
+#define TX_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
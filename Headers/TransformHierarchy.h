@@ -0,0 +1,101 @@
+#ifndef HEADERS_TRANSFORMHIERARCHY_H_
+#define HEADERS_TRANSFORMHIERARCHY_H_
+
+#include "EntityStore.h"
+#include "ExceptionHandler.h"
+#include "JobSystem.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using TransformNode = uint32_t;
+const TransformNode TRANSFORM_NODE_INVALID = UINT32_MAX;
+
+// Dirty nodes of one level per job
+const size_t TRANSFORM_BATCH_SIZE = 1024;
+// Dirty rows gathered per call into the batch math kernels, kept on the stack
+const size_t TRANSFORM_GATHER_SIZE = 64;
+
+/*
+    Parent/child transforms stored level by level, roots at depth 0
+    A parent always sits one level above its children so a level can
+    be computed once the one above it is done, and every node of a
+    level (siblings and cousins alike) independently of the others
+
+    Changing a node marks its whole subtree dirty, update() only
+    touches dirty nodes so a scene that does not move costs nothing
+*/
+class TransformHierarchy
+{
+public:
+    class Exception : public ExceptionHandler
+    {
+    public:
+        Exception(int l, std::string f, std::string message);
+        ~Exception(void);
+    };
+
+public:
+    TransformHierarchy(const TransformHierarchy &) = delete;
+    TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+
+    // Without a job system every level is computed on the calling thread
+    explicit TransformHierarchy(JobSystem *jobs = nullptr);
+    ~TransformHierarchy(void);
+
+    // The entity, if any, gets the node's world matrix on every change
+    TransformNode create(TransformNode parent = TRANSFORM_NODE_INVALID, Entity entity = ENTITY_INVALID);
+    // Destroys the node and its subtree, bound entities are left alive
+    void destroy(TransformNode node);
+    bool isAlive(TransformNode node) const;
+    size_t getNodeCount(void) const;
+
+    void setLocal(TransformNode node,
+                  const glm::vec3 &position,
+                  const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                  const glm::vec3 &scale = glm::vec3(1.0f));
+    const glm::mat4 &getWorldMatrix(TransformNode node) const;
+
+    // Recomputes dirty nodes and pushes them to their entities, returns how many were computed
+    size_t update(EntityStore &store);
+
+private:
+    // All nodes at one depth, SoA indexed by row
+    struct Level
+    {
+        std::vector<TransformNode> nodes;
+        std::vector<TransformNode> parents;
+        std::vector<Entity> entities;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::quat> rotations;
+        std::vector<glm::vec3> scales;
+        std::vector<glm::mat4> worldMatrices;
+
+        std::vector<TransformNode> dirtyNodes;
+    };
+
+    struct NodeRecord
+    {
+        uint32_t depth = UINT32_MAX;
+        uint32_t row = 0;
+        bool dirty = false;
+        std::vector<TransformNode> children;
+    };
+
+    JobSystem *jobs;
+    std::vector<Level> levels;
+    std::vector<NodeRecord> records;
+    std::vector<TransformNode> freeNodes;
+
+private:
+    const NodeRecord &getRecord(TransformNode node) const;
+    void markDirty(TransformNode node);
+    void removeNode(TransformNode node);
+    void computeNodes(uint32_t depth, size_t begin, size_t end);
+};
+
+#define TH_EXCEPT(string) throw Exception(__LINE__, __FILE__, string);
+
+#endif
@@ -2,8 +2,12 @@
 
 #include "ExceptionHandler.h"
 #include "GraphicsHandler.h"
+#include "SimulationClock.h"
 
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <thread>
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
@@ -22,9 +26,12 @@ class WindowHandler
 		WindowHandler(int w, int h, const char* title);
 		~WindowHandler();
 
+		// Simulation loop, runs the render thread alongside
 		void go(void);
 		void handleXEvent(void);
-		void draw(size_t currentFrame); // Calls GraphicsHandler to update buffers
+		// Render thread : draws the newest packet the simulation published, every frame
+		void renderLoop(void);
+		void draw(size_t currentFrame, const FramePacket &packet, float alpha); // Calls GraphicsHandler to update buffers
 
 		// Create a destroy event
 		XEvent createEvent(const char* eventType);
@@ -37,7 +44,14 @@ class WindowHandler
 		Window window;
 		XEvent event;
 		int screen;
-		bool running = true;
+		std::atomic<bool> running = true;
+
+		// Fixed simulation step, the render thread only reads the tick length
+		SimulationClock clock{SIMULATION_TICK_RATE};
+
+		// Simulation to render thread hand over
+		FrameExchange packets;
+		std::exception_ptr renderError;
 };
 
 #define W_EXCEPT(string) throw Exception(__LINE__, __FILE__, string)
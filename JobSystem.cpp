@@ -0,0 +1,291 @@
+#include "JobSystem.h"
+
+#include <iostream>
+
+namespace
+{
+    // Which system and deque the running thread belongs to
+    thread_local const JobSystem *currentSystem = nullptr;
+    thread_local size_t currentIndex = SIZE_MAX;
+}
+
+JobSystem::JobSystem(size_t workerCount)
+{
+    if (workerCount == JOB_SYSTEM_AUTO_WORKERS)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    queues.reserve(workerCount + 1);
+    for (size_t i = 0; i < workerCount + 1; i++)
+    {
+        queues.push_back(std::make_unique<JobQueue>());
+    }
+
+    currentSystem = this;
+    currentIndex = 0;
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+    }
+    return;
+}
+
+JobSystem::~JobSystem(void)
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobAvailable.notify_all();
+    }
+
+    // Queued jobs are still drained before the workers exit
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    if (currentSystem == this)
+    {
+        currentSystem = nullptr;
+        currentIndex = SIZE_MAX;
+    }
+    return;
+}
+
+void JobSystem::run(std::function<void(void)> function, JobCounter *counter)
+{
+    if (counter != nullptr)
+    {
+        counter->pending++;
+    }
+    push(Job{std::move(function), counter});
+    return;
+}
+
+void JobSystem::runAfter(JobCounter &dependency, std::function<void(void)> function, JobCounter *counter)
+{
+    if (counter != nullptr)
+    {
+        counter->pending++;
+    }
+    Job job{std::move(function), counter};
+    {
+        // finish() decrements under this lock, so pending cannot drop in between
+        std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+        if (dependency.pending != 0)
+        {
+            dependency.continuations.push_back(std::move(job));
+            return;
+        }
+    }
+    push(std::move(job));
+    return;
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+    size_t index = getThreadIndex();
+    while (!counter.isDone())
+    {
+        Job job;
+        // Background jobs only when no worker would ever take them
+        if (pop(index, job) || (workers.empty() && popBackground(job)))
+        {
+            execute(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // The last finish() may still hold the lock, the counter can go once it is released
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(counter.continuationMutex);
+        exception = std::move(counter.exception);
+        counter.exception = nullptr;
+    }
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+    return;
+}
+
+size_t JobSystem::getThreadCount(void) const
+{
+    return queues.size();
+}
+
+size_t JobSystem::getThreadIndex(void) const
+{
+    return currentSystem == this ? currentIndex : SIZE_MAX;
+}
+
+void JobSystem::push(Job job)
+{
+    size_t index = getThreadIndex();
+    if (index == SIZE_MAX)
+    {
+        index = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(std::move(job));
+    }
+    wake();
+    return;
+}
+
+void JobSystem::pushBackground(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(background.mutex);
+        background.jobs.push_back(std::move(job));
+    }
+    wake();
+    return;
+}
+
+void JobSystem::wake(void)
+{
+    // Pairs with the sleep in workerLoop, one of the two sees the other's increment
+    queuedJobs++;
+    if (sleepingWorkers > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobAvailable.notify_one();
+    }
+    return;
+}
+
+// Newest job of our own deque first, then the oldest of somebody else's
+bool JobSystem::pop(size_t index, Job &job)
+{
+    const size_t queueCount = queues.size();
+    if (index < queueCount)
+    {
+        JobQueue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queuedJobs--;
+            return true;
+        }
+    }
+
+    size_t start = index < queueCount ? index : 0;
+    for (size_t i = 1; i <= queueCount; i++)
+    {
+        JobQueue &victim = *queues[(start + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queuedJobs--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::popBackground(Job &job)
+{
+    std::lock_guard<std::mutex> lock(background.mutex);
+    if (background.jobs.empty())
+    {
+        return false;
+    }
+    job = std::move(background.jobs.front());
+    background.jobs.pop_front();
+    queuedJobs--;
+    return true;
+}
+
+// An exception must not unwind a worker, it is kept for whoever waits on the counter
+void JobSystem::execute(Job &job)
+{
+    try
+    {
+        job.function();
+    }
+    catch (...)
+    {
+        if (job.counter == nullptr)
+        {
+            std::cout << "[-] A job without a counter threw, the exception is dropped" << std::endl;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(job.counter->continuationMutex);
+            if (!job.counter->exception)
+            {
+                job.counter->exception = std::current_exception();
+            }
+        }
+    }
+    if (job.counter != nullptr)
+    {
+        finish(*job.counter);
+    }
+    return;
+}
+
+void JobSystem::finish(JobCounter &counter)
+{
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter.continuationMutex);
+        if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            ready.swap(counter.continuations);
+        }
+    }
+    for (auto &job : ready)
+    {
+        push(std::move(job));
+    }
+    return;
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+    currentSystem = this;
+    currentIndex = index;
+
+    int spins = 0;
+    while (true)
+    {
+        Job job;
+        if (pop(index, job) || popBackground(job))
+        {
+            execute(job);
+            spins = 0;
+            continue;
+        }
+        if (stopping)
+        {
+            return;
+        }
+        if (++spins < JOB_SYSTEM_SPIN_COUNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        spins = 0;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers++;
+        jobAvailable.wait(lock, [this](void) { return stopping || queuedJobs > 0; });
+        sleepingWorkers--;
+    }
+}
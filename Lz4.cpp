@@ -0,0 +1,177 @@
+#include "Lz4.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+
+const size_t LZ4_MIN_MATCH = 4;
+// The last match must start this far from the end, and end this far from it
+const size_t LZ4_MATCH_START_LIMIT = 12;
+const size_t LZ4_LAST_LITERALS = 5;
+const size_t LZ4_MAX_OFFSET = 65535;
+const uint32_t LZ4_HASH_BITS = 16;
+
+static uint32_t readWord(const unsigned char *bytes)
+{
+    uint32_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+// Lengths past the token's 15 continue in bytes of 255 and a remainder
+static void writeLength(size_t length, std::vector<unsigned char> &out)
+{
+    while (length >= 255)
+    {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<unsigned char>(length));
+    return;
+}
+
+static bool readLength(const unsigned char *source, size_t sourceSize, size_t &in, size_t &length)
+{
+    unsigned char byte = 255;
+    while (byte == 255)
+    {
+        if (in >= sourceSize)
+        {
+            return false;
+        }
+        byte = source[in++];
+        length += byte;
+    }
+    return true;
+}
+
+// matchLength 0 writes the closing sequence, literals only
+static void writeSequence(const unsigned char *literals,
+                          size_t literalLength,
+                          size_t offset,
+                          size_t matchLength,
+                          std::vector<unsigned char> &out)
+{
+    size_t matchCode = matchLength > 0 ? matchLength - LZ4_MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>((std::min<size_t>(literalLength, 15) << 4) |
+                                                     std::min<size_t>(matchCode, 15));
+    out.push_back(token);
+    if (literalLength >= 15)
+    {
+        writeLength(literalLength - 15, out);
+    }
+    out.insert(out.end(), literals, literals + literalLength);
+
+    if (matchLength == 0)
+    {
+        return;
+    }
+    out.push_back(static_cast<unsigned char>(offset & 0xFF));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (matchCode >= 15)
+    {
+        writeLength(matchCode - 15, out);
+    }
+    return;
+}
+
+void compressLz4Block(const unsigned char *source, size_t size, std::vector<unsigned char> &out)
+{
+    out.clear();
+    out.reserve(size + size / 255 + 16);
+
+    // Last position each hashed word was seen at, offset by one so 0 is empty
+    std::vector<size_t> table(size_t(1) << LZ4_HASH_BITS, 0);
+
+    size_t anchor = 0;
+    size_t position = 0;
+    while (size > LZ4_MATCH_START_LIMIT && position < size - LZ4_MATCH_START_LIMIT)
+    {
+        uint32_t word = readWord(source + position);
+        uint32_t hash = (word * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = position + 1;
+
+        if (candidate == 0 ||
+            position - (candidate - 1) > LZ4_MAX_OFFSET ||
+            readWord(source + candidate - 1) != word)
+        {
+            position++;
+            continue;
+        }
+        candidate--;
+
+        size_t matchLength = LZ4_MIN_MATCH;
+        size_t matchEnd = size - LZ4_LAST_LITERALS;
+        while (position + matchLength < matchEnd && source[candidate + matchLength] == source[position + matchLength])
+        {
+            matchLength++;
+        }
+
+        writeSequence(source + anchor, position - anchor, position - candidate, matchLength, out);
+        position += matchLength;
+        anchor = position;
+    }
+
+    writeSequence(source + anchor, size - anchor, 0, 0, out);
+    return;
+}
+
+bool decompressLz4Block(const unsigned char *source, size_t sourceSize, unsigned char *destination, size_t size)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < sourceSize)
+    {
+        unsigned char token = source[in++];
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(source, sourceSize, in, literalLength))
+        {
+            return false;
+        }
+        if (literalLength > sourceSize - in || literalLength > size - out)
+        {
+            return false;
+        }
+        std::memcpy(destination + out, source + in, literalLength);
+        in += literalLength;
+        out += literalLength;
+
+        // Only the closing sequence has no match
+        if (in == sourceSize)
+        {
+            break;
+        }
+
+        if (sourceSize - in < 2)
+        {
+            return false;
+        }
+        size_t offset = source[in] | (static_cast<size_t>(source[in + 1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > out)
+        {
+            return false;
+        }
+
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(source, sourceSize, in, matchLength))
+        {
+            return false;
+        }
+        matchLength += LZ4_MIN_MATCH;
+        if (matchLength > size - out)
+        {
+            return false;
+        }
+
+        // Matches may overlap what they write, copied a byte at a time
+        for (size_t i = 0; i < matchLength; i++)
+        {
+            destination[out + i] = destination[out - offset + i];
+        }
+        out += matchLength;
+    }
+    return out == size;
+}
@@ -1,48 +1,32 @@
 #include "MemoryHandler.h"
 
-MemoryHandler::MemoryHandler(MemoryInitParameters &params)
-{
-    memVar = params;
-    createVertexBuffer();
-    createIndexBuffer();
-}
-
-MemoryHandler::~MemoryHandler()
-{
-    cleanup();
-}
+#include <algorithm>
 
-void MemoryHandler::createVertexBuffer(void)
+const char *getUploadPathName(UploadPath path)
 {
-    std::cout << "[+] Creating vertex buffer" << std::endl;
-    VkDeviceSize bufferSize = memVar.vertexSize;
-
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                 m_VertexBuffer,
-                 m_VertexMemory);
-    return;
+    switch (path)
+    {
+    case UploadPath::Direct:
+        return "direct";
+    case UploadPath::Host:
+        return "host";
+    case UploadPath::Staged:
+        return "staged";
+    }
+    return "unknown";
 }
 
-void MemoryHandler::appendVertexData(void)
+MemoryHandler::MemoryHandler(MemoryInitParameters &params)
+    : memVar(params)
 {
-    return;
+    vkGetPhysicalDeviceMemoryProperties(memVar.m_PhysicalDevice, &memoryProperties);
+    findDirectMemory();
+    geometry = std::make_unique<GeometryPool>(*this, memVar.vertexSize, memVar.indexSize);
 }
 
-void MemoryHandler::createIndexBuffer(void)
+MemoryHandler::~MemoryHandler()
 {
-    std::cout << "[+] Creating index buffer" << std::endl;
-    // Index buffer size
-    VkDeviceSize bufferSize = memVar.indexSize;
-
-    // Create the gpu local buffer and copy our staging buffer to it
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                 m_IndexBuffer,
-                 m_IndexMemory);
-    return;
+    cleanup();
 }
 
 void MemoryHandler::createBuffer(VkDeviceSize size,
@@ -50,6 +34,20 @@ void MemoryHandler::createBuffer(VkDeviceSize size,
                                  VkMemoryPropertyFlags properties,
                                  VkBuffer &buffer,
                                  VkDeviceMemory &bufferMemory)
+{
+    if (!tryCreateBuffer(size, usage, properties, UINT32_MAX, buffer, bufferMemory))
+    {
+        M_EXCEPT("Failed to allocate memory for vertex buffer!");
+    }
+    return;
+}
+
+bool MemoryHandler::tryCreateBuffer(VkDeviceSize size,
+                                    VkBufferUsageFlags usage,
+                                    VkMemoryPropertyFlags properties,
+                                    uint32_t typeIndex,
+                                    VkBuffer &buffer,
+                                    VkDeviceMemory &bufferMemory)
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -58,6 +56,9 @@ void MemoryHandler::createBuffer(VkDeviceSize size,
     bufferInfo.size = size;
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = memVar.m_SurfaceDetails.sharingMode;
+    uint32_t indices[] = {
+        memVar.selectedDevice->graphicsFamilyIndex,
+        memVar.selectedDevice->presentIndexes[0]};
     if (memVar.m_SurfaceDetails.sharingMode == VK_SHARING_MODE_EXCLUSIVE)
     {
         bufferInfo.queueFamilyIndexCount = 1;
@@ -65,10 +66,6 @@ void MemoryHandler::createBuffer(VkDeviceSize size,
     }
     else if (memVar.m_SurfaceDetails.sharingMode == VK_SHARING_MODE_CONCURRENT)
     {
-        uint32_t indices[] = {
-            memVar.selectedDevice->graphicsFamilyIndex,
-            memVar.selectedDevice->presentIndexes[0]};
-
         bufferInfo.queueFamilyIndexCount = 2;
         bufferInfo.pQueueFamilyIndices = indices;
     }
@@ -87,40 +84,237 @@ void MemoryHandler::createBuffer(VkDeviceSize size,
     allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     allocInfo.pNext = nullptr;
     allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    allocInfo.memoryTypeIndex = typeIndex;
 
-    if (vkAllocateMemory(memVar.m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    bool found = typeIndex == UINT32_MAX
+                     ? tryFindMemoryType(memRequirements.memoryTypeBits, properties, allocInfo.memoryTypeIndex)
+                     : (memRequirements.memoryTypeBits & (1u << typeIndex)) != 0;
+    if (!found || vkAllocateMemory(memVar.m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
     {
-        M_EXCEPT("Failed to allocate memory for vertex buffer!");
+        vkDestroyBuffer(memVar.m_Device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return false;
     }
 
     if (vkBindBufferMemory(memVar.m_Device, buffer, bufferMemory, 0) != VK_SUCCESS)
     {
         M_EXCEPT("Failed to bind memory to vertex buffer");
     }
+    return true;
+}
+
+void MemoryHandler::createImage(uint32_t width,
+                                uint32_t height,
+                                uint32_t mipLevels,
+                                VkFormat format,
+                                VkImageTiling tiling,
+                                VkImageUsageFlags usage,
+                                VkMemoryPropertyFlags properties,
+                                VkImage &image,
+                                VkDeviceMemory &imageMemory,
+                                VkSampleCountFlagBits samples,
+                                VkMemoryPropertyFlags preferred)
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.pNext = nullptr;
+    imageInfo.flags = 0;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent.width = width;
+    imageInfo.extent.height = height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = samples;
+    imageInfo.tiling = tiling;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(memVar.m_Device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+    {
+        M_EXCEPT("Failed to create image!");
+    }
+
+    VkMemoryRequirements memRequirements{};
+    vkGetImageMemoryRequirements(memVar.m_Device, image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.allocationSize = memRequirements.size;
+    if (preferred == 0 ||
+        !tryFindMemoryType(memRequirements.memoryTypeBits, properties | preferred, allocInfo.memoryTypeIndex))
+    {
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    }
+
+    if (vkAllocateMemory(memVar.m_Device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+    {
+        M_EXCEPT("Failed to allocate memory for image!");
+    }
+
+    if (vkBindImageMemory(memVar.m_Device, image, imageMemory, 0) != VK_SUCCESS)
+    {
+        M_EXCEPT("Failed to bind memory to image");
+    }
     return;
 }
 
 uint32_t MemoryHandler::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
-    VkPhysicalDeviceMemoryProperties deviceMemoryProperties{};
-    vkGetPhysicalDeviceMemoryProperties(memVar.m_PhysicalDevice,
-                                        &deviceMemoryProperties);
+    uint32_t typeIndex = 0;
+    if (!tryFindMemoryType(typeFilter, properties, typeIndex))
+    {
+        M_EXCEPT("Failed to find memory type");
+    }
+    return typeIndex;
+}
 
-    for (uint32_t i = 0; i < deviceMemoryProperties.memoryTypeCount; i++)
+bool MemoryHandler::tryFindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t &typeIndex)
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
     {
         if (typeFilter & (1 << i) &&
-            (deviceMemoryProperties.memoryTypes[i].propertyFlags &
+            (memoryProperties.memoryTypes[i].propertyFlags &
              properties) == properties)
         {
-            return i;
+            typeIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MemoryHandler::findDirectMemory(void)
+{
+    const VkMemoryPropertyFlags direct = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    VkDeviceSize directHeapSize = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        const VkMemoryType &type = memoryProperties.memoryTypes[i];
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[type.heapIndex].size;
+        if ((type.propertyFlags & direct) == direct && heapSize > directHeapSize)
+        {
+            directType = i;
+            directHeapSize = heapSize;
         }
     }
-    M_EXCEPT("Failed to find memory type");
+
+    if (!DIRECT_UPLOADS || directType == UINT32_MAX || directHeapSize <= RESIZABLE_BAR_MIN_SIZE)
+    {
+        directType = UINT32_MAX;
+        std::cout << "\t[+] Per-frame data in host memory, "
+                  << (directHeapSize >> 20) << " MiB of video memory is host visible" << std::endl;
+        return;
+    }
+    directBudget = static_cast<VkDeviceSize>(directHeapSize * DIRECT_UPLOAD_HEAP_SHARE);
+    std::cout << "\t[+] Per-frame data written straight to video memory, "
+              << (directBudget >> 20) << " of " << (directHeapSize >> 20) << " MiB host visible" << std::endl;
+    return;
 }
 
-VkBuffer *MemoryHandler::createUniformBuffer(void)
+UploadPath MemoryHandler::getUniformPath(void) const
 {
+    return directType != UINT32_MAX ? UploadPath::Direct : UploadPath::Host;
+}
+
+bool MemoryHandler::createMappedBuffer(VkDeviceSize size,
+                                       VkBufferUsageFlags usage,
+                                       UploadPath path,
+                                       VkBuffer &buffer,
+                                       VkDeviceMemory &bufferMemory,
+                                       void **mapped)
+{
+    bool created = false;
+    if (path == UploadPath::Direct)
+    {
+        created = directType != UINT32_MAX &&
+                  tryCreateBuffer(size, usage, 0, directType, buffer, bufferMemory);
+    }
+    else if (path == UploadPath::Host)
+    {
+        // System memory first, with unified memory every host visible type is device local too
+        uint32_t hostType = UINT32_MAX;
+        const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+            if ((flags & host) != host)
+            {
+                continue;
+            }
+            if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+            {
+                hostType = i;
+                break;
+            }
+            if (hostType == UINT32_MAX)
+            {
+                hostType = i;
+            }
+        }
+        created = hostType != UINT32_MAX &&
+                  tryCreateBuffer(size, usage, 0, hostType, buffer, bufferMemory);
+    }
+    if (!created)
+    {
+        return false;
+    }
+
+    if (vkMapMemory(memVar.m_Device, bufferMemory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+    {
+        M_EXCEPT("Failed to map uniform buffer");
+    }
+    return true;
+}
+
+void MemoryHandler::createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, VkDeviceMemory &bufferMemory)
+{
+    createBuffer(size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+    return;
+}
+
+VkBuffer MemoryHandler::createUniformBuffer(VkDeviceSize size, void **mapped, VkBufferUsageFlags usage, UploadPath *path)
+{
+    VkBuffer buffer = nullptr;
+    VkDeviceMemory bufferMemory = nullptr;
+    void *ptr = nullptr;
+
+    // Direct until the budget is spent or the heap runs out, host memory after that
+    UploadPath placed = UploadPath::Direct;
+    if (directType == UINT32_MAX || directUsed + size > directBudget ||
+        !createMappedBuffer(size, usage, UploadPath::Direct, buffer, bufferMemory, &ptr))
+    {
+        placed = UploadPath::Host;
+        if (!createMappedBuffer(size, usage, UploadPath::Host, buffer, bufferMemory, &ptr))
+        {
+            M_EXCEPT("Failed to allocate memory for uniform buffer");
+        }
+    }
+    else
+    {
+        directUsed += size;
+    }
+
+    // Released with the buffer in cleanup
+    m_UniformBuffers.push_back(buffer);
+    m_UniformMemory.push_back(bufferMemory);
+    m_UniformPtrs.push_back(ptr);
+    *mapped = ptr;
+    if (path != nullptr)
+    {
+        *path = placed;
+    }
+    return buffer;
+}
+
+VkDeviceSize MemoryHandler::getUniformAlignment(void) const
+{
+    return std::max<VkDeviceSize>(memVar.selectedDevice->devProperties.properties.limits.minUniformBufferOffsetAlignment, 1);
 }
 
 // void MemoryHandler::createUniformBuffers(void)
@@ -171,30 +365,15 @@ void MemoryHandler::cleanup(void)
         }
     }
 
-    // m_UniformPtrs
+    // Freeing the memory unmapped it
+    m_UniformBuffers.clear();
+    m_UniformMemory.clear();
+    m_UniformPtrs.clear();
+    directUsed = 0;
 
-    if (m_VertexBuffer != nullptr)
+    if (geometry)
     {
-        vkDestroyBuffer(memVar.m_Device, m_VertexBuffer, nullptr);
+        geometry->cleanup();
     }
-
-    if (m_VertexMemory != nullptr)
-    {
-        vkFreeMemory(memVar.m_Device, m_VertexMemory, nullptr);
-    }
-
-    // m_VertexPtr;
-
-    if (m_IndexBuffer != nullptr)
-    {
-        vkDestroyBuffer(memVar.m_Device, m_IndexBuffer, nullptr);
-    }
-
-    if (m_IndexMemory != nullptr)
-    {
-        vkFreeMemory(memVar.m_Device, m_IndexMemory, nullptr);
-    }
-
-    // m_IndexPtr;
     return;
 }
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/*
+    Computes bounding sphere and normal cone of the most recent meshlet
+*/
+static void computeMeshletBounds(const std::vector<Vertex> &vertices,
+                                 MeshletData &meshletData,
+                                 Meshlet &meshlet,
+                                 VkFrontFace frontFace)
+{
+    // Sphere centered on the bounding box of the unique vertices
+    glm::vec3 minPoint = glm::vec3(vertices[meshletData.vertices[meshlet.vertexOffset]].pos);
+    glm::vec3 maxPoint = minPoint;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        glm::vec3 p = glm::vec3(vertices[meshletData.vertices[meshlet.vertexOffset + i]].pos);
+        minPoint = glm::min(minPoint, p);
+        maxPoint = glm::max(maxPoint, p);
+    }
+    meshlet.center = (minPoint + maxPoint) * 0.5f;
+
+    meshlet.radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        glm::vec3 p = glm::vec3(vertices[meshletData.vertices[meshlet.vertexOffset + i]].pos);
+        meshlet.radius = std::max(meshlet.radius, glm::length(p - meshlet.center));
+    }
+
+    // Gather triangle normals, degenerate triangles do not contribute
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+    glm::vec3 normalSum = {0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+    {
+        glm::vec3 p0 = glm::vec3(vertices[meshletData.indices[meshlet.indexOffset + i + 0]].pos);
+        glm::vec3 p1 = glm::vec3(vertices[meshletData.indices[meshlet.indexOffset + i + 1]].pos);
+        glm::vec3 p2 = glm::vec3(vertices[meshletData.indices[meshlet.indexOffset + i + 2]].pos);
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area < 1e-12f)
+        {
+            continue;
+        }
+        normal /= area;
+        if (frontFace == VK_FRONT_FACE_CLOCKWISE)
+        {
+            normal = -normal;
+        }
+        normals.push_back(normal);
+        normalSum += normal;
+    }
+
+    meshlet.coneAxis = {0.0f, 0.0f, 0.0f};
+    meshlet.coneCutoff = 1.0f;
+
+    float sumLength = glm::length(normalSum);
+    if (normals.empty() || sumLength < 1e-6f)
+    {
+        return;
+    }
+    meshlet.coneAxis = normalSum / sumLength;
+
+    float minDot = 1.0f;
+    for (const auto &normal : normals)
+    {
+        minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+    }
+
+    // Normals spread over more than a hemisphere, cannot be culled
+    if (minDot <= 0.0f)
+    {
+        return;
+    }
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    return;
+}
+
+bool buildMeshlets(const std::vector<Vertex> &vertices,
+                   const std::vector<uint16_t> &indices,
+                   MeshletData &meshletData,
+                   VkFrontFace frontFace)
+{
+    meshletData = MeshletData{};
+
+    if (indices.size() % 3 != 0)
+    {
+        std::cout << "\t[-] Self check : Index count is not a triangle list, meshlets not built" << std::endl;
+        return false;
+    }
+    for (const auto &index : indices)
+    {
+        if (index >= vertices.size())
+        {
+            std::cout << "\t[-] Self check : Index out of vertex range, meshlets not built" << std::endl;
+            return false;
+        }
+    }
+
+    meshletData.indices.reserve(indices.size());
+
+    // Maps a vertex to its slot within the meshlet being built, -1 if absent
+    std::vector<int32_t> localSlot(vertices.size(), -1);
+    Meshlet current{};
+
+    auto flush = [&](void) {
+        if (current.indexCount == 0)
+        {
+            return;
+        }
+        computeMeshletBounds(vertices, meshletData, current, frontFace);
+        for (uint32_t i = 0; i < current.vertexCount; i++)
+        {
+            localSlot[meshletData.vertices[current.vertexOffset + i]] = -1;
+        }
+        meshletData.meshlets.push_back(current);
+
+        current = Meshlet{};
+        current.vertexOffset = static_cast<uint32_t>(meshletData.vertices.size());
+        current.indexOffset = static_cast<uint32_t>(meshletData.indices.size());
+    };
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const uint16_t triangle[3] = {indices[i], indices[i + 1], indices[i + 2]};
+
+        // Count vertices this triangle would add, a vertex
+        // repeated within a degenerate triangle counts once
+        uint32_t newVertices = 0;
+        for (int v = 0; v < 3; v++)
+        {
+            bool repeated = (v > 0 && triangle[v] == triangle[0]) ||
+                            (v > 1 && triangle[v] == triangle[1]);
+            if (localSlot[triangle[v]] < 0 && !repeated)
+            {
+                newVertices++;
+            }
+        }
+
+        if (current.vertexCount + newVertices > MESHLET_MAX_VERTICES ||
+            current.indexCount / 3 + 1 > MESHLET_MAX_TRIANGLES)
+        {
+            flush();
+        }
+
+        for (int v = 0; v < 3; v++)
+        {
+            if (localSlot[triangle[v]] < 0)
+            {
+                localSlot[triangle[v]] = static_cast<int32_t>(current.vertexCount);
+                meshletData.vertices.push_back(triangle[v]);
+                current.vertexCount++;
+            }
+            meshletData.indices.push_back(triangle[v]);
+        }
+        current.indexCount += 3;
+    }
+    flush();
+
+    return true;
+}
+
+bool validateMeshletCoverage(const std::vector<uint16_t> &originalIndices,
+                             const MeshletData &meshletData)
+{
+    // Smallest rotation of a triangle, keeps winding intact
+    auto canonical = [](uint16_t a, uint16_t b, uint16_t c) -> uint64_t {
+        auto pack = [](uint64_t x, uint64_t y, uint64_t z) {
+            return (x << 32) | (y << 16) | z;
+        };
+        return std::min(pack(a, b, c), std::min(pack(b, c, a), pack(c, a, b)));
+    };
+
+    if (originalIndices.size() != meshletData.indices.size())
+    {
+        std::cout << "\t[-] Self check : Meshlet index count differs from source" << std::endl;
+        return false;
+    }
+
+    // Meshlets must tile the index list in order and respect limits
+    uint32_t expectedIndexOffset = 0;
+    uint32_t expectedVertexOffset = 0;
+    for (const auto &meshlet : meshletData.meshlets)
+    {
+        if (meshlet.indexOffset != expectedIndexOffset ||
+            meshlet.vertexOffset != expectedVertexOffset)
+        {
+            std::cout << "\t[-] Self check : Meshlet ranges are not contiguous" << std::endl;
+            return false;
+        }
+        if (meshlet.vertexCount > MESHLET_MAX_VERTICES ||
+            meshlet.indexCount / 3 > MESHLET_MAX_TRIANGLES ||
+            meshlet.indexCount % 3 != 0)
+        {
+            std::cout << "\t[-] Self check : Meshlet exceeds cluster limits" << std::endl;
+            return false;
+        }
+
+        // Every index must reference a vertex owned by the meshlet
+        auto first = meshletData.vertices.begin() + meshlet.vertexOffset;
+        auto last = first + meshlet.vertexCount;
+        for (uint32_t i = 0; i < meshlet.indexCount; i++)
+        {
+            if (std::find(first, last, meshletData.indices[meshlet.indexOffset + i]) == last)
+            {
+                std::cout << "\t[-] Self check : Meshlet references a vertex it does not own" << std::endl;
+                return false;
+            }
+        }
+
+        expectedIndexOffset += meshlet.indexCount;
+        expectedVertexOffset += meshlet.vertexCount;
+    }
+    if (expectedIndexOffset != meshletData.indices.size())
+    {
+        std::cout << "\t[-] Self check : Meshlets do not cover every index" << std::endl;
+        return false;
+    }
+
+    // Both lists must contain the same triangles, including duplicates
+    std::vector<uint64_t> source;
+    std::vector<uint64_t> clustered;
+    source.reserve(originalIndices.size() / 3);
+    clustered.reserve(originalIndices.size() / 3);
+    for (size_t i = 0; i + 2 < originalIndices.size(); i += 3)
+    {
+        source.push_back(canonical(originalIndices[i], originalIndices[i + 1], originalIndices[i + 2]));
+        clustered.push_back(canonical(meshletData.indices[i], meshletData.indices[i + 1], meshletData.indices[i + 2]));
+    }
+    std::sort(source.begin(), source.end());
+    std::sort(clustered.begin(), clustered.end());
+
+    if (source != clustered)
+    {
+        std::cout << "\t[-] Self check : Meshlet triangles differ from source triangles" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void cullMeshlets(const MeshletData &meshletData,
+                  const glm::mat4 &model,
+                  const Frustum &frustum,
+                  const glm::vec3 &cameraPosition,
+                  std::vector<MeshletDrawRange> &drawRanges)
+{
+    // Largest axis scale grows the bounding spheres conservatively
+    float scale = std::max(glm::length(glm::vec3(model[0])),
+                           std::max(glm::length(glm::vec3(model[1])),
+                                    glm::length(glm::vec3(model[2]))));
+    glm::mat3 rotation = glm::mat3(model);
+
+    size_t firstNewRange = drawRanges.size();
+    for (const auto &meshlet : meshletData.meshlets)
+    {
+        glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+        float radius = meshlet.radius * scale;
+
+        if (!frustum.intersectsSphere(center, radius))
+        {
+            continue;
+        }
+
+        // Back facing when every triangle normal points away from the camera
+        if (meshlet.coneCutoff < 1.0f)
+        {
+            glm::vec3 axis = glm::normalize(rotation * meshlet.coneAxis);
+            glm::vec3 toCenter = center - cameraPosition;
+            if (glm::dot(toCenter, axis) >= meshlet.coneCutoff * glm::length(toCenter) + radius)
+            {
+                continue;
+            }
+        }
+
+        // Neighbouring visible meshlets become one draw
+        if (drawRanges.size() > firstNewRange &&
+            drawRanges.back().firstIndex + drawRanges.back().indexCount == meshlet.indexOffset)
+        {
+            drawRanges.back().indexCount += meshlet.indexCount;
+        }
+        else
+        {
+            drawRanges.push_back({meshlet.indexOffset, meshlet.indexCount});
+        }
+    }
+    return;
+}
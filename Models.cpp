@@ -1,21 +1,11 @@
 #include "Models.h"
 
-HumanClass::HumanClass(void) {
-    position = {0.0f, 0.0f, 0.0f};
-    worldMatrix = glm::mat4();
-    worldMatrix = glm::translate(worldMatrix, position);
-    return;
-}
-
-HumanClass::~HumanClass(void) {
-    return;
-}
-
 /*
 ** Just validates existence of file
  */
-ModelClass::ModelClass(std::string modelTypeName) {
+ModelClass::ModelClass(std::string modelTypeName, std::string modelTexturePath) {
     typeName = modelTypeName;
+    texturePath = modelTexturePath;
     return;
 }
 
@@ -29,11 +19,7 @@ ModelClass::~ModelClass(void) {
 ** But later will read into specified file and
 ** validate/fill vertices container with data from file
  */
-std::pair<int, int> ModelClass::loadModelData(std::pair<int, int> vertexAndIndexOffsets) {
-    // Store the given start location
-    vertexStartOffset = vertexAndIndexOffsets.first;
-    indexStartOffset = vertexAndIndexOffsets.second;
-
+bool ModelClass::loadModelData(void) {
     vertices = {
         {{-0.5f, -0.5f, -0.5f}, {1.0, 1.0, 1.0, 1.0}},
         {{ 0.5f, -0.5f, -0.5f}, {1.0, 1.0, 1.0, 1.0}},
@@ -82,22 +68,37 @@ std::pair<int, int> ModelClass::loadModelData(std::pair<int, int> vertexAndIndex
         0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36
     };
 
-    // We know we cannot exceed INITIAL_BUFFER_SIZE so lets ensure
-    // our model data will not do so
-    vertexDataSize = sizeof(Vertex) * vertices.size();
-    indexDataSize = sizeof(uint16_t) * indices.size();
-
-    int vertexEndOffset = vertexStartOffset + vertexDataSize;
-    int indexEndOffset = indexStartOffset + indexDataSize;
-
-    if(vertexEndOffset > VERTEX_BUFFER_SIZE) {
-        std::cout << "\t[-] Self check : Model data will exceed vertex buffer size" << std::endl;
-        return { -1, -1 };
+    // Dense meshes are clustered so they can be culled per meshlet
+    if(indices.size() / 3 > MESHLET_MAX_TRIANGLES) {
+        if(buildMeshlets(vertices, indices, meshlets)) {
+#ifndef NDEBUG
+            if(!validateMeshletCoverage(indices, meshlets)) {
+                std::cout << "\t[-] Self check : Meshlets of " << typeName << " do not match source mesh" << std::endl;
+                meshlets = MeshletData{};
+            }
+#endif
+        }
+        // Same triangles, reordered so each meshlet is a contiguous range
+        if(!meshlets.meshlets.empty()) {
+            indices = meshlets.indices;
+        }
     }
 
-    if(indexEndOffset > INDEX_BUFFER_SIZE) {
-        std::cout << "\t[-] Self check : Model index data will exceed index buffer size" << std::endl;
-        return { -1, -1 };
+    // Sphere centered on the bounding box, used to cull whole instances
+    glm::vec3 minimum = glm::vec3(vertices.front().pos);
+    glm::vec3 maximum = minimum;
+    for(const auto &vertex : vertices) {
+        minimum = glm::min(minimum, glm::vec3(vertex.pos));
+        maximum = glm::max(maximum, glm::vec3(vertex.pos));
+    }
+    boundsCenter = (minimum + maximum) * 0.5f;
+    boundsRadius = 0.0f;
+    for(const auto &vertex : vertices) {
+        boundsRadius = std::max(boundsRadius, glm::length(glm::vec3(vertex.pos) - boundsCenter));
     }
-    return { vertexEndOffset, indexEndOffset };
+
+    vertexDataSize = sizeof(Vertex) * vertices.size();
+    indexDataSize = sizeof(uint16_t) * indices.size();
+    // No size limit here, the geometry pool sizes a new heap to fit a model larger than its blocks
+    return true;
 }
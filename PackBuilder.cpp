@@ -0,0 +1,79 @@
+// Builds an asset pack from directories of loose files, see AssetPack.h
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+/*
+    packbuilder <pack> <root> <directory>... [--store]
+
+    Packs every file under each directory, named by its path relative
+    to root, e.g. packbuilder build/assets.vpak build shaders textures.
+    --store leaves contents uncompressed
+*/
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    bool compress = true;
+    auto store = std::find(arguments.begin(), arguments.end(), "--store");
+    if (store != arguments.end())
+    {
+        compress = false;
+        arguments.erase(store);
+    }
+    if (arguments.size() < 3)
+    {
+        std::cout << "Usage : packbuilder <pack> <root> <directory>... [--store]" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path root = arguments[1];
+    AssetPackWriter writer;
+    try
+    {
+        for (size_t i = 2; i < arguments.size(); i++)
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(root / arguments[i]))
+            {
+                const std::filesystem::path &path = entry.path();
+                if (!entry.is_regular_file() || path.extension() == ".tmp")
+                {
+                    continue;
+                }
+
+                // A compressed texture older than its source would be rebuilt at runtime anyway
+                std::filesystem::path source = path;
+                source.replace_extension();
+                if (path.extension() == ".vtex" && std::filesystem::exists(source) &&
+                    std::filesystem::last_write_time(source) > std::filesystem::last_write_time(path))
+                {
+                    std::cout << "\t[-] Skipping stale " << path.string() << std::endl;
+                    continue;
+                }
+
+                writer.add(std::filesystem::relative(path, root).generic_string(), path.string());
+            }
+        }
+
+        if (!writer.write(arguments[0], compress))
+        {
+            std::cout << "[-] Failed to write " << arguments[0] << std::endl;
+            return 1;
+        }
+        AssetPack pack(arguments[0]);
+        std::cout << "[+] Packed " << pack.getFileCount() << " files into " << arguments[0] << std::endl;
+    }
+    catch (ExceptionHandler &e)
+    {
+        std::cout << e.getType() << std::endl
+                  << e.getErrorDescription() << std::endl;
+        return 1;
+    }
+    catch (std::filesystem::filesystem_error &e)
+    {
+        std::cout << "[-] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
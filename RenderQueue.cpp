@@ -0,0 +1,199 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+RenderStats &RenderStats::operator+=(const RenderStats &other)
+{
+    drawCalls += other.drawCalls;
+    pushConstants += other.pushConstants;
+    pipelineBinds += other.pipelineBinds;
+    descriptorBinds += other.descriptorBinds;
+    vertexBufferBinds += other.vertexBufferBinds;
+    indexBufferBinds += other.indexBufferBinds;
+    skippedBinds += other.skippedBinds;
+    return *this;
+}
+
+uint64_t makeDrawKey(uint8_t pipeline, uint8_t descriptorSet, uint8_t vertexHeap, uint16_t mesh, float depth)
+{
+    // Positive floats order the same as their bit patterns, negative ones clamp to 0
+    uint32_t depthBits = 0;
+    if (depth > 0.0f)
+    {
+        std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    }
+    // Sign bit is clear, the next 24 bits are exponent and top of the mantissa
+    uint64_t depthKey = (depthBits >> 7) & 0xFFFFFF;
+
+    return (static_cast<uint64_t>(pipeline) << 56) |
+           (static_cast<uint64_t>(descriptorSet) << 48) |
+           (static_cast<uint64_t>(vertexHeap) << 40) |
+           (static_cast<uint64_t>(mesh) << 24) |
+           depthKey;
+}
+
+RenderQueue::RenderQueue(void)
+{
+    return;
+}
+
+RenderQueue::~RenderQueue(void)
+{
+    return;
+}
+
+void RenderQueue::clear(void)
+{
+    items.clear();
+    return;
+}
+
+void RenderQueue::push(const DrawItem &item)
+{
+    items.push_back(item);
+    return;
+}
+
+void RenderQueue::sort(void)
+{
+    const size_t RADIX_MIN_ITEMS = 256;
+    if (items.size() < RADIX_MIN_ITEMS)
+    {
+        std::sort(items.begin(), items.end(), [](const DrawItem &a, const DrawItem &b)
+                  { return a.key < b.key; });
+        return;
+    }
+
+    // Least significant byte first, stable, so every pass keeps the order of the ones before it
+    scratch.resize(items.size());
+    uint64_t allOr = 0;
+    uint64_t allAnd = ~0ull;
+    for (const DrawItem &item : items)
+    {
+        allOr |= item.key;
+        allAnd &= item.key;
+    }
+    // Bits set in some keys but not all, bytes without any are the same everywhere and skipped
+    uint64_t varying = allOr ^ allAnd;
+
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        if (((varying >> shift) & 0xFF) == 0)
+        {
+            continue;
+        }
+
+        std::array<size_t, 256> offsets{};
+        for (const DrawItem &item : items)
+        {
+            offsets[(item.key >> shift) & 0xFF]++;
+        }
+        size_t total = 0;
+        for (size_t &offset : offsets)
+        {
+            size_t count = offset;
+            offset = total;
+            total += count;
+        }
+        for (const DrawItem &item : items)
+        {
+            scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+    return;
+}
+
+const std::vector<DrawItem> &RenderQueue::getItems(void) const
+{
+    return items;
+}
+
+size_t RenderQueue::size(void) const
+{
+    return items.size();
+}
+
+BindCache::BindCache(VkCommandBuffer commandBuffer, RenderStats &stats)
+    : commandBuffer(commandBuffer), stats(stats)
+{
+    return;
+}
+
+BindCache::~BindCache(void)
+{
+    return;
+}
+
+void BindCache::bindPipeline(VkPipeline pipeline)
+{
+    if (pipeline == this->pipeline)
+    {
+        stats.skippedBinds++;
+        return;
+    }
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    this->pipeline = pipeline;
+    stats.pipelineBinds++;
+    return;
+}
+
+void BindCache::bindDescriptorSet(VkPipelineLayout layout,
+                                  uint32_t setIndex,
+                                  VkDescriptorSet set,
+                                  uint32_t dynamicOffsetCount,
+                                  const uint32_t *dynamicOffsets)
+{
+    // Dynamic offsets change what the set points at, they have to match as well
+    bool cacheable = setIndex < MAX_BOUND_SETS && dynamicOffsetCount <= MAX_DYNAMIC_OFFSETS;
+    if (cacheable &&
+        set == sets[setIndex].set &&
+        dynamicOffsetCount == sets[setIndex].dynamicOffsetCount &&
+        std::equal(dynamicOffsets, dynamicOffsets + dynamicOffsetCount, sets[setIndex].dynamicOffsets))
+    {
+        stats.skippedBinds++;
+        return;
+    }
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, setIndex, 1, &set,
+                            dynamicOffsetCount, dynamicOffsets);
+    stats.descriptorBinds++;
+    if (!cacheable)
+    {
+        return;
+    }
+    sets[setIndex].set = set;
+    sets[setIndex].dynamicOffsetCount = dynamicOffsetCount;
+    std::copy(dynamicOffsets, dynamicOffsets + dynamicOffsetCount, sets[setIndex].dynamicOffsets);
+    return;
+}
+
+void BindCache::bindVertexBuffer(VkBuffer buffer, VkDeviceSize offset)
+{
+    if (buffer == vertexBuffer && offset == vertexOffset)
+    {
+        stats.skippedBinds++;
+        return;
+    }
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+    vertexBuffer = buffer;
+    vertexOffset = offset;
+    stats.vertexBufferBinds++;
+    return;
+}
+
+void BindCache::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    if (buffer == indexBuffer && offset == indexOffset && indexType == this->indexType)
+    {
+        stats.skippedBinds++;
+        return;
+    }
+    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+    indexBuffer = buffer;
+    indexOffset = offset;
+    this->indexType = indexType;
+    stats.indexBufferBinds++;
+    return;
+}
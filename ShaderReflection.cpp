@@ -0,0 +1,668 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+
+// SPIR-V opcodes, decorations and storage classes read here, from the unified specification
+namespace
+{
+    const uint32_t SPIRV_MAGIC = 0x07230203;
+    const size_t SPIRV_HEADER_WORDS = 5;
+
+    enum Op : uint32_t
+    {
+        OpEntryPoint = 15,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstant = 50,
+        OpFunction = 54,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructure = 5341
+    };
+
+    enum Decoration : uint32_t
+    {
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBuiltIn = 11,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35
+    };
+
+    enum StorageClass : uint32_t
+    {
+        StorageClassUniformConstant = 0,
+        StorageClassInput = 1,
+        StorageClassUniform = 2,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12
+    };
+
+    const uint32_t DIM_BUFFER = 5;
+    const uint32_t DIM_SUBPASS_DATA = 6;
+    // Sampled operand of OpTypeImage, 2 for images read and written without a sampler
+    const uint32_t IMAGE_STORAGE = 2;
+
+    VkShaderStageFlagBits getStageOfModel(uint32_t executionModel)
+    {
+        switch (executionModel)
+        {
+        case 0:
+            return VK_SHADER_STAGE_VERTEX_BIT;
+        case 3:
+            return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4:
+            return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5:
+            return VK_SHADER_STAGE_COMPUTE_BIT;
+        default:
+            return VK_SHADER_STAGE_ALL;
+        }
+    }
+
+    // Float, signed or unsigned, and the component count of an attribute format
+    bool describeFormat(VkFormat format, char &numeric, uint32_t &components)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R32_SFLOAT:
+            numeric = 'f', components = 1;
+            return true;
+        case VK_FORMAT_R32G32_SFLOAT:
+            numeric = 'f', components = 2;
+            return true;
+        case VK_FORMAT_R32G32B32_SFLOAT:
+            numeric = 'f', components = 3;
+            return true;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            numeric = 'f', components = 4;
+            return true;
+        case VK_FORMAT_R32_SINT:
+            numeric = 'i', components = 1;
+            return true;
+        case VK_FORMAT_R32G32_SINT:
+            numeric = 'i', components = 2;
+            return true;
+        case VK_FORMAT_R32G32B32_SINT:
+            numeric = 'i', components = 3;
+            return true;
+        case VK_FORMAT_R32G32B32A32_SINT:
+            numeric = 'i', components = 4;
+            return true;
+        case VK_FORMAT_R32_UINT:
+            numeric = 'u', components = 1;
+            return true;
+        case VK_FORMAT_R32G32_UINT:
+            numeric = 'u', components = 2;
+            return true;
+        case VK_FORMAT_R32G32B32_UINT:
+            numeric = 'u', components = 3;
+            return true;
+        case VK_FORMAT_R32G32B32A32_UINT:
+            numeric = 'u', components = 4;
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+ShaderReflection::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Shader Reflection Exception";
+    errorDescription = description;
+    return;
+}
+
+ShaderReflection::Exception::~Exception(void)
+{
+    return;
+}
+
+ShaderReflection::ShaderReflection(const uint32_t *code, size_t size)
+{
+    if (size < SPIRV_HEADER_WORDS * sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+    {
+        SR_EXCEPT("Shader code is not a whole number of SPIR-V words");
+    }
+    if (reinterpret_cast<uintptr_t>(code) % alignof(uint32_t) != 0)
+    {
+        SR_EXCEPT("Shader code is not aligned to a word");
+    }
+    if (code[0] != SPIRV_MAGIC)
+    {
+        SR_EXCEPT("Shader code does not start with the SPIR-V magic number");
+    }
+
+    parse(code, size / sizeof(uint32_t));
+    reflectVariables();
+
+    // Lookup tables are only needed while reflecting
+    types.clear();
+    decorations.clear();
+    constants.clear();
+    variables.clear();
+    return;
+}
+
+ShaderReflection::~ShaderReflection(void)
+{
+    return;
+}
+
+void ShaderReflection::parse(const uint32_t *words, size_t wordCount)
+{
+    bool foundEntryPoint = false;
+    size_t position = SPIRV_HEADER_WORDS;
+    while (position < wordCount)
+    {
+        uint32_t opcode = words[position] & 0xFFFF;
+        uint32_t length = words[position] >> 16;
+        if (length == 0 || position + length > wordCount)
+        {
+            SR_EXCEPT("Malformed SPIR-V instruction");
+        }
+        const uint32_t *operands = words + position + 1;
+        uint32_t operandCount = length - 1;
+        position += length;
+
+        // Types, constants, decorations and globals all come before the first function
+        if (opcode == OpFunction)
+        {
+            break;
+        }
+
+        auto operand = [&](uint32_t index) {
+            if (index >= operandCount)
+            {
+                SR_EXCEPT("SPIR-V instruction is missing operands");
+            }
+            return operands[index];
+        };
+
+        switch (opcode)
+        {
+        case OpEntryPoint:
+            // Modules with several entry points are reflected as their first one
+            if (!foundEntryPoint)
+            {
+                stage = getStageOfModel(operand(0));
+                foundEntryPoint = true;
+            }
+            break;
+        case OpTypeInt:
+            types[operand(0)] = {opcode, 0, operand(1), operand(2), 0, {}};
+            break;
+        case OpTypeFloat:
+            types[operand(0)] = {opcode, 0, operand(1), 0, 0, {}};
+            break;
+        case OpTypeVector:
+        case OpTypeMatrix:
+            types[operand(0)] = {opcode, operand(1), operand(2), 0, 0, {}};
+            break;
+        case OpTypeImage:
+            // Sampled type, dim, depth, arrayed, ms, sampled
+            types[operand(0)] = {opcode, operand(1), 0, operand(6), operand(2), {}};
+            break;
+        case OpTypeSampler:
+        case OpTypeAccelerationStructure:
+            types[operand(0)] = {opcode, 0, 0, 0, 0, {}};
+            break;
+        case OpTypeSampledImage:
+        case OpTypeRuntimeArray:
+            types[operand(0)] = {opcode, operand(1), 0, 0, 0, {}};
+            break;
+        case OpTypeArray:
+            // Length is the id of a constant, resolved once all are known
+            types[operand(0)] = {opcode, operand(1), operand(2), 0, 0, {}};
+            break;
+        case OpTypeStruct:
+            types[operand(0)] = {opcode, 0, operandCount - 1, 0, 0, std::vector<uint32_t>(operands + 1, operands + operandCount)};
+            break;
+        case OpTypePointer:
+            types[operand(0)] = {opcode, operand(2), 0, operand(1), 0, {}};
+            break;
+        case OpConstant:
+        case OpSpecConstant:
+            // Array lengths are 32 bit, specialization constants reflect as their defaults
+            if (operandCount >= 3)
+            {
+                constants[operand(1)] = operand(2);
+            }
+            break;
+        case OpVariable:
+            variables.push_back({operand(1), operand(0), operand(2)});
+            break;
+        case OpDecorate:
+        {
+            Decorations &target = decorations[operand(0)];
+            switch (operand(1))
+            {
+            case DecorationBlock:
+                target.block = true;
+                break;
+            case DecorationBufferBlock:
+                target.bufferBlock = true;
+                break;
+            case DecorationArrayStride:
+                target.arrayStride = operand(2);
+                break;
+            case DecorationBuiltIn:
+                target.builtIn = true;
+                break;
+            case DecorationLocation:
+                target.location = operand(2);
+                break;
+            case DecorationBinding:
+                target.binding = operand(2);
+                break;
+            case DecorationDescriptorSet:
+                target.set = operand(2);
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+        case OpMemberDecorate:
+        {
+            Decorations &target = decorations[operand(0)];
+            uint32_t member = operand(1);
+            if (operand(2) == DecorationOffset || operand(2) == DecorationMatrixStride)
+            {
+                target.memberOffsets.resize(std::max<size_t>(target.memberOffsets.size(), member + 1), 0);
+                target.matrixStrides.resize(target.memberOffsets.size(), 0);
+                (operand(2) == DecorationOffset ? target.memberOffsets : target.matrixStrides)[member] = operand(3);
+            }
+            if (operand(2) == DecorationBuiltIn)
+            {
+                target.builtIn = true;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    if (!foundEntryPoint)
+    {
+        SR_EXCEPT("SPIR-V module has no entry point");
+    }
+    return;
+}
+
+void ShaderReflection::reflectVariables(void)
+{
+    uint32_t pushBegin = UINT32_MAX;
+    uint32_t pushEnd = 0;
+
+    for (const Variable &variable : variables)
+    {
+        const Type &pointer = getType(variable.pointerType);
+        uint32_t typeId = pointer.element;
+        const Decorations &decorated = decorations[variable.id];
+
+        switch (variable.storageClass)
+        {
+        case StorageClassUniformConstant:
+        case StorageClassUniform:
+        case StorageClassStorageBuffer:
+        {
+            if (decorated.set == UINT32_MAX || decorated.binding == UINT32_MAX)
+            {
+                break;
+            }
+            ReflectedBinding binding;
+            binding.set = decorated.set;
+            binding.binding = decorated.binding;
+            binding.count = getArrayCount(typeId);
+            binding.type = getDescriptorType(typeId, variable.storageClass);
+            bindings.push_back(binding);
+            break;
+        }
+        case StorageClassPushConstant:
+        {
+            // Offsets of the block's members, the range starts at the first used
+            const Type &block = getType(typeId);
+            const Decorations &members = decorations[typeId];
+            for (size_t i = 0; i < block.members.size() && i < members.memberOffsets.size(); i++)
+            {
+                pushBegin = std::min(pushBegin, members.memberOffsets[i]);
+            }
+            pushEnd = std::max(pushEnd, getSize(typeId));
+            break;
+        }
+        case StorageClassInput:
+        {
+            if (stage != VK_SHADER_STAGE_VERTEX_BIT || decorated.builtIn || decorated.location == UINT32_MAX)
+            {
+                break;
+            }
+            // Matrices and arrays of inputs take consecutive locations
+            uint32_t locations = getArrayCount(typeId);
+            const Type &type = getType(typeId);
+            uint32_t columnType = typeId;
+            if (type.opcode == OpTypeMatrix)
+            {
+                locations *= type.count;
+                columnType = type.element;
+            }
+            VkFormat format = getInputFormat(columnType);
+            for (uint32_t i = 0; i < locations; i++)
+            {
+                inputs.push_back({decorated.location + i, format});
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    if (pushEnd > 0)
+    {
+        pushConstants.stageFlags = stage;
+        pushConstants.offset = pushBegin == UINT32_MAX ? 0 : pushBegin;
+        // Ranges are whole words
+        pushConstants.size = ((pushEnd - pushConstants.offset) + 3) & ~3u;
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b)
+              { return a.set != b.set ? a.set < b.set : a.binding < b.binding; });
+    std::sort(inputs.begin(), inputs.end(), [](const ReflectedInput &a, const ReflectedInput &b)
+              { return a.location < b.location; });
+    return;
+}
+
+const ShaderReflection::Type &ShaderReflection::getType(uint32_t id) const
+{
+    auto found = types.find(id);
+    if (found == types.end())
+    {
+        SR_EXCEPT("SPIR-V references an undeclared type");
+    }
+    return found->second;
+}
+
+// Strips arrays from typeId, returning the descriptors they hold or 0 when runtime sized
+uint32_t ShaderReflection::getArrayCount(uint32_t &typeId) const
+{
+    uint32_t count = 1;
+    while (true)
+    {
+        const Type &type = getType(typeId);
+        if (type.opcode == OpTypeArray)
+        {
+            auto length = constants.find(type.count);
+            if (length == constants.end())
+            {
+                SR_EXCEPT("SPIR-V array length is not a constant");
+            }
+            count *= length->second;
+        }
+        else if (type.opcode == OpTypeRuntimeArray)
+        {
+            count = 0;
+        }
+        else
+        {
+            return count;
+        }
+        typeId = type.element;
+    }
+}
+
+VkDescriptorType ShaderReflection::getDescriptorType(uint32_t typeId, uint32_t storageClass) const
+{
+    const Type &type = getType(typeId);
+    if (storageClass == StorageClassStorageBuffer)
+    {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    if (storageClass == StorageClassUniform)
+    {
+        // Older GLSL marks storage blocks BufferBlock in the uniform class
+        auto found = decorations.find(typeId);
+        bool bufferBlock = found != decorations.end() && found->second.bufferBlock;
+        return bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+
+    switch (type.opcode)
+    {
+    case OpTypeSampler:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+    case OpTypeSampledImage:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case OpTypeImage:
+        if (type.dimension == DIM_BUFFER)
+        {
+            return type.flags == IMAGE_STORAGE ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                                               : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        }
+        if (type.dimension == DIM_SUBPASS_DATA)
+        {
+            return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        }
+        return type.flags == IMAGE_STORAGE ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    default:
+        SR_EXCEPT("Shader declares a resource type the engine cannot bind");
+    }
+}
+
+// Bytes a type spans in a block, following the Offset and stride decorations the compiler wrote
+uint32_t ShaderReflection::getSize(uint32_t typeId) const
+{
+    const Type &type = getType(typeId);
+    switch (type.opcode)
+    {
+    case OpTypeInt:
+    case OpTypeFloat:
+        return type.count / 8;
+    case OpTypeVector:
+        return getSize(type.element) * type.count;
+    case OpTypeMatrix:
+        return getSize(type.element) * type.count;
+    case OpTypeArray:
+    {
+        auto found = decorations.find(typeId);
+        uint32_t stride = found != decorations.end() && found->second.arrayStride > 0 ? found->second.arrayStride
+                                                                                     : getSize(type.element);
+        auto length = constants.find(type.count);
+        return length == constants.end() ? 0 : stride * length->second;
+    }
+    case OpTypeStruct:
+    {
+        auto found = decorations.find(typeId);
+        uint32_t end = 0;
+        for (size_t i = 0; i < type.members.size(); i++)
+        {
+            uint32_t offset = 0;
+            uint32_t size = getSize(type.members[i]);
+            if (found != decorations.end() && i < found->second.memberOffsets.size())
+            {
+                offset = found->second.memberOffsets[i];
+                // Matrix columns are MatrixStride apart, often wider than the column
+                const Type &member = getType(type.members[i]);
+                if (member.opcode == OpTypeMatrix && found->second.matrixStrides[i] > 0)
+                {
+                    size = found->second.matrixStrides[i] * member.count;
+                }
+            }
+            end = std::max(end, offset + size);
+        }
+        return end;
+    }
+    default:
+        return 0;
+    }
+}
+
+VkFormat ShaderReflection::getInputFormat(uint32_t typeId) const
+{
+    const Type &type = getType(typeId);
+    uint32_t components = 1;
+    const Type *scalar = &type;
+    if (type.opcode == OpTypeVector)
+    {
+        components = type.count;
+        scalar = &getType(type.element);
+    }
+
+    // 32 bit inputs only, which is all Vertex provides
+    if (scalar->count != 32)
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+    if (scalar->opcode == OpTypeFloat)
+    {
+        const VkFormat formats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        return formats[components - 1];
+    }
+    if (scalar->opcode == OpTypeInt && scalar->flags != 0)
+    {
+        const VkFormat formats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        return formats[components - 1];
+    }
+    if (scalar->opcode == OpTypeInt)
+    {
+        const VkFormat formats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+        return formats[components - 1];
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+VkShaderStageFlagBits ShaderReflection::getStage(void) const
+{
+    return stage;
+}
+
+const std::vector<ReflectedBinding> &ShaderReflection::getBindings(void) const
+{
+    return bindings;
+}
+
+const std::vector<ReflectedInput> &ShaderReflection::getInputs(void) const
+{
+    return inputs;
+}
+
+VkPushConstantRange ShaderReflection::getPushConstants(void) const
+{
+    return pushConstants;
+}
+
+/*
+    Attributes may have more or fewer components than the input reads,
+    extra ones are dropped and missing ones filled with 0, 0, 1. Only a
+    missing location or a different numeric type is an error
+*/
+void ShaderReflection::checkVertexInput(const std::vector<VkVertexInputAttributeDescription> &attributes) const
+{
+    for (const ReflectedInput &input : inputs)
+    {
+        auto attribute = std::find_if(attributes.begin(), attributes.end(), [&input](const VkVertexInputAttributeDescription &a)
+                                      { return a.location == input.location; });
+        if (attribute == attributes.end())
+        {
+            SR_EXCEPT("Vertex shader reads location " + std::to_string(input.location) + " which no attribute provides");
+        }
+
+        char inputNumeric = 0;
+        char attributeNumeric = 0;
+        uint32_t inputComponents = 0;
+        uint32_t attributeComponents = 0;
+        if (!describeFormat(input.format, inputNumeric, inputComponents) ||
+            !describeFormat(attribute->format, attributeNumeric, attributeComponents))
+        {
+            continue;
+        }
+        if (inputNumeric != attributeNumeric)
+        {
+            SR_EXCEPT("Vertex shader reads location " + std::to_string(input.location) + " as another numeric type than its attribute");
+        }
+        if (inputComponents != attributeComponents)
+        {
+            std::cout << "[/] Vertex input " << input.location << " reads " << inputComponents
+                      << " of its attribute's " << attributeComponents << " components" << std::endl;
+        }
+    }
+    return;
+}
+
+std::vector<std::vector<VkDescriptorSetLayoutBinding>> ShaderReflection::mergeBindings(const std::vector<ShaderReflection> &stages)
+{
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+    for (const ShaderReflection &reflection : stages)
+    {
+        for (const ReflectedBinding &binding : reflection.bindings)
+        {
+            if (binding.set >= sets.size())
+            {
+                sets.resize(binding.set + 1);
+            }
+            std::vector<VkDescriptorSetLayoutBinding> &set = sets[binding.set];
+            auto existing = std::find_if(set.begin(), set.end(), [&binding](const VkDescriptorSetLayoutBinding &b)
+                                         { return b.binding == binding.binding; });
+            if (existing != set.end())
+            {
+                if (existing->descriptorType != binding.type || existing->descriptorCount != binding.count)
+                {
+                    SR_EXCEPT("Stages disagree on set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding));
+                }
+                existing->stageFlags |= reflection.stage;
+                continue;
+            }
+
+            VkDescriptorSetLayoutBinding layoutBinding{};
+            layoutBinding.binding = binding.binding;
+            layoutBinding.descriptorType = binding.type;
+            layoutBinding.descriptorCount = binding.count;
+            layoutBinding.stageFlags = reflection.stage;
+            layoutBinding.pImmutableSamplers = nullptr;
+            set.push_back(layoutBinding);
+        }
+    }
+
+    for (auto &set : sets)
+    {
+        std::sort(set.begin(), set.end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+                  { return a.binding < b.binding; });
+    }
+    return sets;
+}
+
+VkPushConstantRange ShaderReflection::mergePushConstants(const std::vector<ShaderReflection> &stages)
+{
+    VkPushConstantRange merged{};
+    uint32_t end = 0;
+    for (const ShaderReflection &reflection : stages)
+    {
+        if (reflection.pushConstants.size == 0)
+        {
+            continue;
+        }
+        merged.offset = merged.stageFlags == 0 ? reflection.pushConstants.offset
+                                               : std::min(merged.offset, reflection.pushConstants.offset);
+        merged.stageFlags |= reflection.pushConstants.stageFlags;
+        end = std::max(end, reflection.pushConstants.offset + reflection.pushConstants.size);
+    }
+    merged.size = end - merged.offset;
+    return merged;
+}
@@ -0,0 +1,226 @@
+#include "ShaderWatcher.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <set>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+ShaderWatcher::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Shader Watcher Exception";
+    errorDescription = description;
+    return;
+}
+
+ShaderWatcher::Exception::~Exception(void)
+{
+    return;
+}
+
+ShaderWatcher::ShaderWatcher(const std::filesystem::path &sourceDirectory, const std::filesystem::path &binaryDirectory)
+    : sourceDirectory(sourceDirectory), binaryDirectory(binaryDirectory)
+{
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0)
+    {
+        SW_EXCEPT("Failed to create inotify instance");
+    }
+
+    // Editors either write the file in place or rename a new one over it
+    if (inotify_add_watch(notifyFd, sourceDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(notifyFd);
+        SW_EXCEPT("Failed to watch " + sourceDirectory.string());
+    }
+
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0)
+    {
+        close(notifyFd);
+        SW_EXCEPT("Failed to create watcher wake event");
+    }
+
+    watchThread = std::thread(&ShaderWatcher::watchLoop, this);
+    return;
+}
+
+ShaderWatcher::~ShaderWatcher(void)
+{
+    if (eventfd_write(wakeFd, 1) == 0 && watchThread.joinable())
+    {
+        watchThread.join();
+    }
+    close(wakeFd);
+    close(notifyFd);
+    return;
+}
+
+std::vector<CompiledShader> ShaderWatcher::takeCompiled(void)
+{
+    std::vector<CompiledShader> taken;
+    std::lock_guard<std::mutex> lock(compiledMutex);
+    taken.swap(compiled);
+    return taken;
+}
+
+std::filesystem::path ShaderWatcher::getExecutableDirectory(void)
+{
+    std::error_code error;
+    std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (error)
+    {
+        return std::filesystem::current_path();
+    }
+    return executable.parent_path();
+}
+
+bool ShaderWatcher::getStage(const std::string &name, VkShaderStageFlagBits &stage, std::string &binary)
+{
+    // Stages the pipelines are built from
+    const std::array<std::pair<const char *, VkShaderStageFlagBits>, 2> stages = {{
+        {"vert", VK_SHADER_STAGE_VERTEX_BIT},
+        {"frag", VK_SHADER_STAGE_FRAGMENT_BIT},
+    }};
+
+    std::string extension = std::filesystem::path(name).extension().string();
+    for (const auto &[stageName, stageBit] : stages)
+    {
+        if (extension == std::string(".") + stageName)
+        {
+            stage = stageBit;
+            binary = std::string(stageName) + ".spv";
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShaderWatcher::watchLoop(void)
+{
+    std::array<pollfd, 2> fds{};
+    fds[0].fd = notifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd;
+    fds[1].events = POLLIN;
+
+    alignas(inotify_event) char events[4096];
+    std::set<std::string> changed;
+
+    while (true)
+    {
+        // Sleeps until a source changes, then until the writes to it settle
+        int timeout = changed.empty() ? -1 : SHADER_RELOAD_SETTLE_MS;
+        int ready = poll(fds.data(), fds.size(), timeout);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cout << "[-] Shader watcher stopped, polling failed" << std::endl;
+            return;
+        }
+        if (fds[1].revents & POLLIN)
+        {
+            return;
+        }
+
+        if (ready == 0)
+        {
+            for (const auto &name : changed)
+            {
+                CompiledShader shader = compile(name);
+                std::lock_guard<std::mutex> lock(compiledMutex);
+                compiled.push_back(std::move(shader));
+            }
+            changed.clear();
+            continue;
+        }
+
+        ssize_t length = read(notifyFd, events, sizeof(events));
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(events + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            VkShaderStageFlagBits stage;
+            std::string binary;
+            if (event->len > 0 && getStage(event->name, stage, binary))
+            {
+                changed.insert(event->name);
+            }
+        }
+    }
+}
+
+CompiledShader ShaderWatcher::compile(const std::string &name) const
+{
+    CompiledShader shader;
+    std::string binary;
+    getStage(name, shader.stage, binary);
+    shader.source = sourceDirectory / name;
+    shader.binary = binaryDirectory / binary;
+
+    // Written beside the binary then renamed over it, nothing reads half a file
+    std::filesystem::path output = shader.binary;
+    output += ".tmp";
+
+    auto quote = [](const std::filesystem::path &path) {
+        std::string quoted = "'";
+        for (char c : path.string())
+        {
+            quoted += (c == '\'') ? std::string("'\\''") : std::string(1, c);
+        }
+        return quoted + "'";
+    };
+    std::string command = std::string(SHADER_COMPILER) + " -O " + quote(shader.source) +
+                          " -o " + quote(output) + " 2>&1";
+
+    auto start = std::chrono::steady_clock::now();
+    FILE *pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr)
+    {
+        shader.log = std::string("Failed to run ") + SHADER_COMPILER;
+        return shader;
+    }
+    std::array<char, 256> line;
+    while (fgets(line.data(), static_cast<int>(line.size()), pipe) != nullptr)
+    {
+        shader.log += line.data();
+    }
+    int status = pclose(pipe);
+    shader.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::error_code error;
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::filesystem::remove(output, error);
+        return shader;
+    }
+
+    // The mapping outlives the rename, it follows the file rather than its name
+    try
+    {
+        shader.code = std::make_unique<FileView>(output.string());
+    }
+    catch (ExceptionHandler &e)
+    {
+        shader.log += e.getErrorDescription() + "\n";
+        return shader;
+    }
+
+    std::filesystem::rename(output, shader.binary, error);
+    if (error)
+    {
+        shader.log += "Failed to replace " + shader.binary.string() + " : " + error.message() + "\n";
+        shader.code.reset();
+    }
+    return shader;
+}
@@ -0,0 +1,56 @@
+#include "SimulationClock.h"
+
+#include <algorithm>
+
+SimulationClock::SimulationClock(int tickRate)
+    : tickLength(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tickRate))),
+      simulatedUntil(Clock::now())
+{
+    return;
+}
+
+SimulationClock::~SimulationClock(void)
+{
+    return;
+}
+
+int SimulationClock::advance(void)
+{
+    Clock::time_point now = Clock::now();
+    auto due = (now - simulatedUntil) / tickLength;
+    if (due > SIMULATION_MAX_CATCHUP_TICKS)
+    {
+        // Long stall (debugger, window drag), resume from now instead of fast forwarding
+        simulatedUntil = now - tickLength * SIMULATION_MAX_CATCHUP_TICKS;
+        due = SIMULATION_MAX_CATCHUP_TICKS;
+    }
+    return static_cast<int>(due);
+}
+
+SimulationClock::Clock::time_point SimulationClock::step(void)
+{
+    simulatedUntil += tickLength;
+    tickCount++;
+    return simulatedUntil;
+}
+
+SimulationClock::Clock::time_point SimulationClock::getNextTickTime(void) const
+{
+    return simulatedUntil + tickLength;
+}
+
+float SimulationClock::getTickSeconds(void) const
+{
+    return std::chrono::duration<float>(tickLength).count();
+}
+
+uint64_t SimulationClock::getTickCount(void) const
+{
+    return tickCount;
+}
+
+float SimulationClock::getAlpha(Clock::time_point tickTime, Clock::time_point now) const
+{
+    float alpha = std::chrono::duration<float>(now - tickTime) / std::chrono::duration<float>(tickLength);
+    return std::clamp(alpha, 0.0f, 1.0f);
+}
@@ -0,0 +1,199 @@
+#include "StartupGraph.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+StartupGraph::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Startup Graph Exception";
+    errorDescription = description;
+    return;
+}
+
+StartupGraph::Exception::~Exception(void)
+{
+    return;
+}
+
+StartupStage StartupGraph::add(const std::string &name, std::initializer_list<StartupStage> dependencies, std::function<void(void)> function)
+{
+    StartupStage index = stages.size();
+    for (StartupStage dependency : dependencies)
+    {
+        if (dependency >= index)
+        {
+            SG_EXCEPT("Stage " + name + " depends on a stage added after it");
+        }
+        stages[dependency].dependents.push_back(index);
+    }
+
+    Stage stage;
+    stage.name = name;
+    stage.function = std::move(function);
+    stage.dependencies = dependencies;
+    stages.push_back(std::move(stage));
+    return index;
+}
+
+void StartupGraph::run(JobSystem &jobSystem)
+{
+    JobCounter done;
+    jobs = &jobSystem;
+    counter = &done;
+    failure = nullptr;
+
+    remaining = std::make_unique<std::atomic<uint32_t>[]>(stages.size());
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        remaining[i].store(static_cast<uint32_t>(stages[i].dependencies.size()), std::memory_order_relaxed);
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        if (stages[i].dependencies.empty())
+        {
+            launch(i);
+        }
+    }
+    jobs->wait(done);
+    totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    remaining.reset();
+    jobs = nullptr;
+    counter = nullptr;
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+    return;
+}
+
+void StartupGraph::launch(StartupStage stage)
+{
+    jobs->run([this, stage](void)
+              { execute(stage); },
+              counter);
+    return;
+}
+
+void StartupGraph::execute(StartupStage index)
+{
+    Stage &stage = stages[index];
+
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        failed = failure != nullptr;
+        if (!failed)
+        {
+            std::cout << "[+] " << stage.name << std::endl;
+        }
+    }
+
+    if (!failed)
+    {
+        stage.thread = jobs->getThreadIndex();
+        stage.startMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        try
+        {
+            stage.function();
+            stage.ran = true;
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (failure == nullptr)
+            {
+                failure = std::current_exception();
+            }
+        }
+        stage.endMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Dependents still pass through after a failure, they skip their work so run() can finish
+    for (StartupStage dependent : stage.dependents)
+    {
+        if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            launch(dependent);
+        }
+    }
+    return;
+}
+
+void StartupGraph::printTimings(void) const
+{
+    std::vector<StartupStage> order;
+    for (StartupStage i = 0; i < stages.size(); i++)
+    {
+        if (stages[i].ran)
+        {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](StartupStage a, StartupStage b)
+              { return stages[a].startMs < stages[b].startMs; });
+
+    double busyMs = 0.0;
+    for (StartupStage i : order)
+    {
+        busyMs += stages[i].endMs - stages[i].startMs;
+    }
+    // Formatted apart so std::cout keeps its own precision
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "[+] Startup took " << totalMs << " ms, "
+        << busyMs << " ms of work over " << order.size() << " stages" << std::endl;
+
+    for (StartupStage i : order)
+    {
+        const Stage &stage = stages[i];
+        out << "\t[+] " << std::setw(8) << stage.startMs << " +" << std::setw(8) << stage.endMs - stage.startMs
+            << " ms  thread " << stage.thread << "  " << stage.name << std::endl;
+    }
+
+    // Longest chain of durations through the dependencies, stages are added in dependency order
+    std::vector<double> pathMs(stages.size(), 0.0);
+    std::vector<StartupStage> previous(stages.size(), SIZE_MAX);
+    StartupStage last = SIZE_MAX;
+    for (StartupStage i = 0; i < stages.size(); i++)
+    {
+        for (StartupStage dependency : stages[i].dependencies)
+        {
+            if (pathMs[dependency] > pathMs[i])
+            {
+                pathMs[i] = pathMs[dependency];
+                previous[i] = dependency;
+            }
+        }
+        pathMs[i] += stages[i].endMs - stages[i].startMs;
+        if (last == SIZE_MAX || pathMs[i] > pathMs[last])
+        {
+            last = i;
+        }
+    }
+    if (last == SIZE_MAX)
+    {
+        std::cout << out.str();
+        return;
+    }
+
+    std::vector<StartupStage> path;
+    for (StartupStage i = last; i != SIZE_MAX; i = previous[i])
+    {
+        path.push_back(i);
+    }
+    out << "\t[+] Critical path " << pathMs[last] << " ms :";
+    for (auto i = path.rbegin(); i != path.rend(); i++)
+    {
+        out << (i == path.rbegin() ? " " : " -> ") << stages[*i].name;
+    }
+    out << std::endl;
+    std::cout << out.str();
+    return;
+}
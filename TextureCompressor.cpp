@@ -0,0 +1,471 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+using Block = std::array<std::array<float, 4>, 16>;
+
+bool isBlockCompressed(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t getFormatBlockBytes(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return 8;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+VkDeviceSize getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+    if (!isBlockCompressed(format))
+    {
+        return static_cast<VkDeviceSize>(width) * height * getFormatBlockBytes(format);
+    }
+    VkDeviceSize blocksWide = (width + 3) / 4;
+    VkDeviceSize blocksHigh = (height + 3) / 4;
+    return blocksWide * blocksHigh * getFormatBlockBytes(format);
+}
+
+/*
+    Gathers a 4x4 block, texels past the edge repeat the last row/column
+*/
+static void loadBlock(const unsigned char *rgba, uint32_t width, uint32_t height,
+                      uint32_t blockX, uint32_t blockY, Block &block)
+{
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        uint32_t sy = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            uint32_t sx = std::min(blockX * 4 + x, width - 1);
+            const unsigned char *texel = &rgba[(static_cast<size_t>(sy) * width + sx) * 4];
+            for (int c = 0; c < 4; c++)
+            {
+                block[y * 4 + x][c] = texel[c];
+            }
+        }
+    }
+    return;
+}
+
+/*
+    Endpoints at the extremes of the block projected onto its principal axis
+    channels selects how many of RGBA take part
+*/
+static void fitEndpoints(const Block &block, int channels,
+                         std::array<float, 4> &low, std::array<float, 4> &high)
+{
+    std::array<float, 4> mean = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (const auto &texel : block)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            mean[c] += texel[c] / 16.0f;
+        }
+    }
+
+    float covariance[4][4] = {};
+    for (const auto &texel : block)
+    {
+        for (int i = 0; i < channels; i++)
+        {
+            for (int j = 0; j < channels; j++)
+            {
+                covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+    }
+
+    // Power iteration converges to the dominant eigenvector
+    std::array<float, 4> axis = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        std::array<float, 4> next = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int i = 0; i < channels; i++)
+        {
+            for (int j = 0; j < channels; j++)
+            {
+                next[i] += covariance[i][j] * axis[j];
+            }
+        }
+        float length = 0.0f;
+        for (int c = 0; c < channels; c++)
+        {
+            length += next[c] * next[c];
+        }
+        length = std::sqrt(length);
+        if (length < 1e-6f)
+        {
+            break;
+        }
+        for (int c = 0; c < channels; c++)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float minT = 0.0f;
+    float maxT = 0.0f;
+    for (const auto &texel : block)
+    {
+        float t = 0.0f;
+        for (int c = 0; c < channels; c++)
+        {
+            t += (texel[c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    for (int c = 0; c < 4; c++)
+    {
+        low[c] = c < channels ? std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f) : 255.0f;
+        high[c] = c < channels ? std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f) : 255.0f;
+    }
+    return;
+}
+
+static float texelError(const std::array<float, 4> &a, const std::array<float, 4> &b, int channels)
+{
+    float error = 0.0f;
+    for (int c = 0; c < channels; c++)
+    {
+        error += (a[c] - b[c]) * (a[c] - b[c]);
+    }
+    return error;
+}
+
+static uint16_t packRGB565(const std::array<float, 4> &color)
+{
+    uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+    uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+    uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static std::array<float, 4> unpackRGB565(uint16_t packed)
+{
+    uint32_t r = (packed >> 11) & 31;
+    uint32_t g = (packed >> 5) & 63;
+    uint32_t b = packed & 31;
+    return {static_cast<float>((r << 3) | (r >> 2)),
+            static_cast<float>((g << 2) | (g >> 4)),
+            static_cast<float>((b << 3) | (b >> 2)),
+            255.0f};
+}
+
+// BC1 style color half, always in four color mode
+static void encodeColorBlock(const Block &block, unsigned char *out)
+{
+    std::array<float, 4> low{};
+    std::array<float, 4> high{};
+    fitEndpoints(block, 3, low, high);
+
+    uint16_t color0 = packRGB565(high);
+    uint16_t color1 = packRGB565(low);
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        std::array<float, 4> c0 = unpackRGB565(color0);
+        std::array<float, 4> c1 = unpackRGB565(color1);
+        std::array<std::array<float, 4>, 4> palette;
+        for (int c = 0; c < 4; c++)
+        {
+            palette[0][c] = c0[c];
+            palette[1][c] = c1[c];
+            palette[2][c] = (2.0f * c0[c] + c1[c]) / 3.0f;
+            palette[3][c] = (c0[c] + 2.0f * c1[c]) / 3.0f;
+        }
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t best = 0;
+            float bestError = texelError(block[i], palette[0], 3);
+            for (uint32_t p = 1; p < 4; p++)
+            {
+                float error = texelError(block[i], palette[p], 3);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(color0 & 0xFF);
+    out[1] = static_cast<unsigned char>(color0 >> 8);
+    out[2] = static_cast<unsigned char>(color1 & 0xFF);
+    out[3] = static_cast<unsigned char>(color1 >> 8);
+    for (int i = 0; i < 4; i++)
+    {
+        out[4 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xFF);
+    }
+    return;
+}
+
+// BC3 alpha half, eight value interpolation between min and max
+static void encodeAlphaBlock(const Block &block, unsigned char *out)
+{
+    float minAlpha = 255.0f;
+    float maxAlpha = 0.0f;
+    for (const auto &texel : block)
+    {
+        minAlpha = std::min(minAlpha, texel[3]);
+        maxAlpha = std::max(maxAlpha, texel[3]);
+    }
+    uint32_t alpha0 = static_cast<uint32_t>(std::lround(maxAlpha));
+    uint32_t alpha1 = static_cast<uint32_t>(std::lround(minAlpha));
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1)
+    {
+        std::array<float, 8> palette;
+        palette[0] = static_cast<float>(alpha0);
+        palette[1] = static_cast<float>(alpha1);
+        for (int i = 1; i < 7; i++)
+        {
+            palette[i + 1] = ((7 - i) * static_cast<float>(alpha0) + i * static_cast<float>(alpha1)) / 7.0f;
+        }
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint64_t best = 0;
+            float bestError = std::fabs(block[i][3] - palette[0]);
+            for (uint64_t p = 1; p < 8; p++)
+            {
+                float error = std::fabs(block[i][3] - palette[p]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(alpha0);
+    out[1] = static_cast<unsigned char>(alpha1);
+    for (int i = 0; i < 6; i++)
+    {
+        out[2 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xFF);
+    }
+    return;
+}
+
+// Writes count bits of value LSB first starting at bit offset
+static void writeBits(unsigned char *out, uint32_t &offset, uint32_t count, uint32_t value)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (value & (1u << i))
+        {
+            out[(offset + i) / 8] |= static_cast<unsigned char>(1u << ((offset + i) % 8));
+        }
+    }
+    offset += count;
+    return;
+}
+
+/*
+    BC7 mode 6 : 7 bit RGBA endpoints each with a shared p-bit
+    and 4 bit indices; Every p-bit pair is tried and the best kept
+*/
+static void encodeBC7Block(const Block &block, unsigned char *out)
+{
+    static const uint32_t weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    std::array<float, 4> low{};
+    std::array<float, 4> high{};
+    fitEndpoints(block, 4, low, high);
+
+    std::array<uint32_t, 4> bestEndpoints[2];
+    uint32_t bestPBits[2] = {0, 0};
+    uint32_t bestIndices[16] = {};
+    float bestTotal = -1.0f;
+
+    for (uint32_t pBits = 0; pBits < 4; pBits++)
+    {
+        uint32_t p[2] = {pBits & 1, pBits >> 1};
+        std::array<uint32_t, 4> quantized[2];
+        std::array<float, 4> expanded[2];
+        for (int e = 0; e < 2; e++)
+        {
+            const std::array<float, 4> &source = e == 0 ? low : high;
+            for (int c = 0; c < 4; c++)
+            {
+                float q = std::round((source[c] - static_cast<float>(p[e])) / 2.0f);
+                quantized[e][c] = static_cast<uint32_t>(std::clamp(q, 0.0f, 127.0f));
+                expanded[e][c] = static_cast<float>((quantized[e][c] << 1) | p[e]);
+            }
+        }
+
+        std::array<std::array<float, 4>, 16> palette;
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                uint32_t e0 = static_cast<uint32_t>(expanded[0][c]);
+                uint32_t e1 = static_cast<uint32_t>(expanded[1][c]);
+                palette[i][c] = static_cast<float>(((64 - weights[i]) * e0 + weights[i] * e1 + 32) >> 6);
+            }
+        }
+
+        uint32_t indices[16];
+        float total = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            uint32_t best = 0;
+            float bestError = texelError(block[i], palette[0], 4);
+            for (uint32_t k = 1; k < 16; k++)
+            {
+                float error = texelError(block[i], palette[k], 4);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = k;
+                }
+            }
+            indices[i] = best;
+            total += bestError;
+        }
+
+        if (bestTotal < 0.0f || total < bestTotal)
+        {
+            bestTotal = total;
+            bestEndpoints[0] = quantized[0];
+            bestEndpoints[1] = quantized[1];
+            bestPBits[0] = p[0];
+            bestPBits[1] = p[1];
+            std::copy(std::begin(indices), std::end(indices), std::begin(bestIndices));
+        }
+    }
+
+    // The anchor index drops its top bit, swap endpoints so it is below 8
+    if (bestIndices[0] >= 8)
+    {
+        std::swap(bestEndpoints[0], bestEndpoints[1]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (auto &index : bestIndices)
+        {
+            index = 15 - index;
+        }
+    }
+
+    std::memset(out, 0, 16);
+    uint32_t offset = 0;
+    writeBits(out, offset, 7, 1u << 6);
+    for (int c = 0; c < 4; c++)
+    {
+        writeBits(out, offset, 7, bestEndpoints[0][c]);
+        writeBits(out, offset, 7, bestEndpoints[1][c]);
+    }
+    writeBits(out, offset, 1, bestPBits[0]);
+    writeBits(out, offset, 1, bestPBits[1]);
+    writeBits(out, offset, 3, bestIndices[0]);
+    for (int i = 1; i < 16; i++)
+    {
+        writeBits(out, offset, 4, bestIndices[i]);
+    }
+    return;
+}
+
+template <typename Encoder>
+static void compressBlocks(const unsigned char *rgba, uint32_t width, uint32_t height,
+                           uint32_t blockBytes, std::vector<unsigned char> &blocks, Encoder encoder)
+{
+    uint32_t blocksWide = (width + 3) / 4;
+    uint32_t blocksHigh = (height + 3) / 4;
+    blocks.assign(static_cast<size_t>(blocksWide) * blocksHigh * blockBytes, 0);
+
+    Block block;
+    for (uint32_t by = 0; by < blocksHigh; by++)
+    {
+        for (uint32_t bx = 0; bx < blocksWide; bx++)
+        {
+            loadBlock(rgba, width, height, bx, by, block);
+            encoder(block, &blocks[(static_cast<size_t>(by) * blocksWide + bx) * blockBytes]);
+        }
+    }
+    return;
+}
+
+void compressBC1(const unsigned char *rgba, uint32_t width, uint32_t height, std::vector<unsigned char> &blocks)
+{
+    compressBlocks(rgba, width, height, 8, blocks, encodeColorBlock);
+    return;
+}
+
+void compressBC3(const unsigned char *rgba, uint32_t width, uint32_t height, std::vector<unsigned char> &blocks)
+{
+    compressBlocks(rgba, width, height, 16, blocks, [](const Block &block, unsigned char *out) {
+        encodeAlphaBlock(block, out);
+        encodeColorBlock(block, out + 8);
+    });
+    return;
+}
+
+void compressBC7(const unsigned char *rgba, uint32_t width, uint32_t height, std::vector<unsigned char> &blocks)
+{
+    compressBlocks(rgba, width, height, 16, blocks, encodeBC7Block);
+    return;
+}
+
+void compressLevel(VkFormat format,
+                   const unsigned char *rgba,
+                   uint32_t width,
+                   uint32_t height,
+                   std::vector<unsigned char> &out)
+{
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        compressBC1(rgba, width, height, out);
+        break;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        compressBC3(rgba, width, height, out);
+        break;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        compressBC7(rgba, width, height, out);
+        break;
+    default:
+        out.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+        break;
+    }
+    return;
+}
@@ -0,0 +1,160 @@
+#include "TextureContainer.h"
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+const uint64_t TEXTURE_CONTAINER_ALIGNMENT = 16;
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+}
+
+const unsigned char *TextureLevel::getBytes(void) const
+{
+    return mapped != nullptr ? mapped : data.data();
+}
+
+size_t TextureLevel::getSize(void) const
+{
+    return mapped != nullptr ? mappedSize : data.size();
+}
+
+uint32_t getTextureLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+bool writeTextureContainer(const std::string &path, const TextureData &texture)
+{
+    TextureContainerHeader header{};
+    std::memcpy(header.magic, TEXTURE_CONTAINER_MAGIC, sizeof(header.magic));
+    header.version = TEXTURE_CONTAINER_VERSION;
+    header.vkFormat = static_cast<uint32_t>(texture.format);
+    header.width = texture.width;
+    header.height = texture.height;
+    header.levelCount = static_cast<uint32_t>(texture.levels.size());
+
+    // Smallest level is written first, right after the level index
+    std::vector<TextureContainerLevel> index(texture.levels.size());
+    uint64_t offset = alignOffset(sizeof(header) + sizeof(TextureContainerLevel) * index.size());
+    for (size_t i = texture.levels.size(); i-- > 0;)
+    {
+        index[i].byteOffset = offset;
+        index[i].byteLength = texture.levels[i].getSize();
+        offset = alignOffset(offset + index[i].byteLength);
+    }
+
+    // Written beside the target then renamed so readers never see a partial file
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(index.data()), sizeof(TextureContainerLevel) * index.size());
+
+        const char padding[TEXTURE_CONTAINER_ALIGNMENT] = {};
+        for (size_t i = texture.levels.size(); i-- > 0;)
+        {
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(index[i].byteOffset - position));
+            file.write(reinterpret_cast<const char *>(texture.levels[i].getBytes()),
+                       static_cast<std::streamsize>(index[i].byteLength));
+        }
+        if (!file.good())
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+bool parseTextureContainer(std::shared_ptr<const FileView> file, TextureData &texture)
+{
+    const unsigned char *bytes = file->getData();
+    size_t size = file->getSize();
+
+    TextureContainerHeader header{};
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, TEXTURE_CONTAINER_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TEXTURE_CONTAINER_VERSION ||
+        header.width == 0 || header.height == 0 ||
+        header.levelCount == 0 || header.levelCount > getTextureLevelCount(header.width, header.height))
+    {
+        return false;
+    }
+    if (isBlockCompressed(static_cast<VkFormat>(header.vkFormat)) &&
+        header.levelCount != getTextureLevelCount(header.width, header.height))
+    {
+        return false;
+    }
+
+    std::vector<TextureContainerLevel> index(header.levelCount);
+    size_t indexBytes = sizeof(TextureContainerLevel) * index.size();
+    if (size < sizeof(header) + indexBytes)
+    {
+        return false;
+    }
+    std::memcpy(index.data(), bytes + sizeof(header), indexBytes);
+
+    texture = TextureData{};
+    texture.format = static_cast<VkFormat>(header.vkFormat);
+    texture.width = header.width;
+    texture.height = header.height;
+    texture.levels.resize(header.levelCount);
+    texture.file = file;
+
+    uint32_t levelWidth = header.width;
+    uint32_t levelHeight = header.height;
+    for (uint32_t i = 0; i < header.levelCount; i++)
+    {
+        // Every level must hold exactly the bytes its dimensions need
+        if (index[i].byteLength != getLevelSize(texture.format, levelWidth, levelHeight) ||
+            index[i].byteOffset > size ||
+            index[i].byteLength > size - index[i].byteOffset)
+        {
+            return false;
+        }
+
+        TextureLevel &level = texture.levels[i];
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.mapped = bytes + index[i].byteOffset;
+        level.mappedSize = static_cast<size_t>(index[i].byteLength);
+
+        levelWidth = std::max(levelWidth / 2, 1u);
+        levelHeight = std::max(levelHeight / 2, 1u);
+    }
+    return true;
+}
+
+bool readTextureContainer(const std::string &path, TextureData &texture)
+{
+    std::shared_ptr<const FileView> file;
+    try
+    {
+        file = std::make_shared<const FileView>(path);
+    }
+    catch (ExceptionHandler &)
+    {
+        return false;
+    }
+    return parseTextureContainer(file, texture);
+}
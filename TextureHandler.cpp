@@ -0,0 +1,736 @@
+#include "TextureHandler.h"
+#include "MemoryHandler.h"
+#include "TextureCompressor.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+
+TextureHandler::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Texture Handler Exception";
+    errorDescription = description;
+    return;
+}
+
+TextureHandler::Exception::~Exception(void)
+{
+    return;
+}
+
+TextureHandler::TextureHandler(MemoryHandler &memoryHandler, JobSystem &jobSystem)
+    : memory(memoryHandler), jobs(jobSystem)
+{
+    querySupport();
+    return;
+}
+
+TextureHandler::~TextureHandler(void)
+{
+    cleanup();
+    return;
+}
+
+uint32_t TextureHandler::getMipLevelCount(uint32_t width, uint32_t height)
+{
+    return getTextureLevelCount(width, height);
+}
+
+TextureLevel TextureHandler::decode(const std::string &path, const FileView &file)
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_uc *pixels = stbi_load_from_memory(file.getData(),
+                                            static_cast<int>(file.getSize()),
+                                            &width, &height, &channels,
+                                            STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        TX_EXCEPT("Failed to decode texture " + path + " : " + stbi_failure_reason());
+    }
+
+    TextureLevel image{};
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.data.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    return image;
+}
+
+bool TextureHandler::isSampled(VkFormat format, FormatSupport support)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        return true;
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return support.sampledBC1;
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        return support.sampledBC3;
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return support.sampledBC7;
+    default:
+        return false;
+    }
+}
+
+void TextureHandler::completeMipChain(TextureData &texture, FormatSupport support)
+{
+    uint32_t mipLevels = getMipLevelCount(texture.width, texture.height);
+    if (texture.levels.size() >= mipLevels || support.linearBlit)
+    {
+        return;
+    }
+
+    // Filtered down from the smallest stored level, which is copied out of the mapping
+    TextureLevel last{};
+    last.width = texture.levels.back().width;
+    last.height = texture.levels.back().height;
+    last.data.assign(texture.levels.back().getBytes(), texture.levels.back().getBytes() + texture.levels.back().getSize());
+    std::vector<TextureLevel> chain = buildMipChain(last, mipLevels - static_cast<uint32_t>(texture.levels.size()) + 1);
+    std::move(chain.begin(), chain.end(), std::back_inserter(texture.levels));
+    return;
+}
+
+std::string TextureHandler::getSourcePath(const std::string &path, FormatSupport support)
+{
+    if (std::filesystem::path(path).extension() == TEXTURE_CONTAINER_EXTENSION ||
+        (!isBlockCompressed(support.opaqueFormat) && !isBlockCompressed(support.alphaFormat)))
+    {
+        return path;
+    }
+
+    // Packs only hold compressed copies that were current when packed
+    std::string compressedPath = path + TEXTURE_CONTAINER_EXTENSION;
+    if (isAssetPacked(compressedPath))
+    {
+        return compressedPath;
+    }
+    if (isAssetPacked(path))
+    {
+        return path;
+    }
+
+    // A compressed copy newer than its source is used instead
+    std::error_code error;
+    if (std::filesystem::exists(compressedPath, error) &&
+        std::filesystem::last_write_time(compressedPath, error) >= std::filesystem::last_write_time(path, error) &&
+        !error)
+    {
+        return compressedPath;
+    }
+    return path;
+}
+
+/*
+    Runs on a worker thread, must not touch any handler state
+    Produces every level that will be uploaded, for blittable
+    RGBA8 textures that is the base level alone
+*/
+std::shared_ptr<const TextureData> TextureHandler::prepare(const std::string &path,
+                                                           std::shared_ptr<const FileView> file,
+                                                           FormatSupport support)
+{
+    auto texture = std::make_shared<TextureData>();
+    bool direct = std::filesystem::path(path).extension() == TEXTURE_CONTAINER_EXTENSION;
+
+    std::shared_ptr<const FileView> image = file;
+    if (direct || (file->getSize() >= sizeof(TEXTURE_CONTAINER_MAGIC) &&
+                   std::memcmp(file->getData(), TEXTURE_CONTAINER_MAGIC, sizeof(TEXTURE_CONTAINER_MAGIC)) == 0))
+    {
+        bool parsed = parseTextureContainer(file, *texture);
+        if (direct && !parsed)
+        {
+            TX_EXCEPT("Invalid texture container : " + path);
+        }
+        if (direct && !isSampled(texture->format, support))
+        {
+            TX_EXCEPT("Texture container format " + std::to_string(texture->format) + " is not sampled by the device : " + path);
+        }
+        if (direct ||
+            (parsed && (texture->format == support.opaqueFormat || texture->format == support.alphaFormat)))
+        {
+            // The parser only lets RGBA8 through with a partial chain
+            completeMipChain(*texture, support);
+            return texture;
+        }
+
+        // Compressed copy is unreadable or made for another device, start over from the source
+        image = openAsset(path);
+    }
+
+    TextureLevel base = decode(path, *image);
+    bool opaque = true;
+    for (size_t i = 3; i < base.data.size() && opaque; i += 4)
+    {
+        opaque = base.data[i] == 255;
+    }
+
+    *texture = TextureData{};
+    texture->format = opaque ? support.opaqueFormat : support.alphaFormat;
+    texture->width = base.width;
+    texture->height = base.height;
+
+    if (!isBlockCompressed(texture->format))
+    {
+        uint32_t mipLevels = getMipLevelCount(base.width, base.height);
+        std::vector<TextureLevel> chain;
+        if (!support.linearBlit)
+        {
+            chain = buildMipChain(base, mipLevels);
+        }
+        texture->levels.push_back(std::move(base));
+        std::move(chain.begin(), chain.end(), std::back_inserter(texture->levels));
+        return texture;
+    }
+
+    std::vector<TextureLevel> chain = buildMipChain(base, getMipLevelCount(base.width, base.height));
+    chain.insert(chain.begin(), std::move(base));
+    for (const auto &level : chain)
+    {
+        TextureLevel compressed{};
+        compressed.width = level.width;
+        compressed.height = level.height;
+        compressLevel(texture->format, level.data.data(), level.width, level.height, compressed.data);
+        texture->levels.push_back(std::move(compressed));
+    }
+
+    std::string compressedPath = path + TEXTURE_CONTAINER_EXTENSION;
+    if (!writeTextureContainer(compressedPath, *texture))
+    {
+        std::cout << "\t[-] Self check : Could not write compressed texture " << compressedPath << std::endl;
+    }
+    return texture;
+}
+
+TextureHandler::DecodeResult TextureHandler::requestDecode(const std::string &path)
+{
+    // Packed files do not change while mounted, only loose ones are checked
+    std::filesystem::file_time_type writeTime{};
+    if (!isAssetPacked(path))
+    {
+        if (!std::filesystem::exists(path))
+        {
+            TX_EXCEPT("Texture file not found : " + path);
+        }
+        writeTime = std::filesystem::last_write_time(path);
+    }
+
+    // Reuse pixels unless the file changed since they were decoded
+    auto cached = decodeCache.find(path);
+    if (cached != decodeCache.end() && cached->second.writeTime == writeTime)
+    {
+        return cached->second.result;
+    }
+
+    FormatSupport formats = support;
+    DecodeResult result = jobs.submit([path, formats](void) {
+                                      return prepare(path, openAsset(getSourcePath(path, formats)), formats);
+                                  })
+                              .share();
+    decodeCache[path] = {writeTime, result};
+    return result;
+}
+
+void TextureHandler::prefetch(const std::string &path)
+{
+    requestDecode(path);
+    return;
+}
+
+const Texture &TextureHandler::load(VkCommandBuffer commandBuffer, const std::string &path)
+{
+    auto loaded = textures.find(path);
+    if (loaded != textures.end())
+    {
+        return loaded->second;
+    }
+
+    // Rethrows anything the worker threw while decoding
+    std::shared_ptr<const TextureData> data = requestDecode(path).get();
+    return upload(commandBuffer, path, *data);
+}
+
+const Texture &TextureHandler::upload(VkCommandBuffer commandBuffer, const std::string &path, const TextureData &data)
+{
+    auto loaded = textures.find(path);
+    if (loaded != textures.end())
+    {
+        return loaded->second;
+    }
+
+    std::cout << "[+] Uploading texture " << path << " (" << data.width << "x" << data.height << ")" << std::endl;
+
+    Texture texture{};
+    texture.format = data.format;
+    texture.width = data.width;
+    texture.height = data.height;
+    texture.mipLevels = getMipLevelCount(data.width, data.height);
+
+    // Only blittable RGBA8 textures arrive without their mip chain, blits cannot write compressed levels
+    bool gpuMips = data.levels.size() < texture.mipLevels;
+    if (gpuMips && (isBlockCompressed(texture.format) || !support.linearBlit))
+    {
+        TX_EXCEPT("Texture " + path + " has " + std::to_string(data.levels.size()) + " of " +
+                  std::to_string(texture.mipLevels) + " mip levels and they cannot be blitted");
+    }
+
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (gpuMips)
+    {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    memory.createImage(texture.width,
+                       texture.height,
+                       texture.mipLevels,
+                       texture.format,
+                       VK_IMAGE_TILING_OPTIMAL,
+                       usage,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                       texture.image,
+                       texture.memory);
+
+    // Everything that can throw runs before recording, a failed upload leaves no image behind
+    StagingBuffer stage{};
+    std::vector<VkBufferImageCopy> regions;
+    try
+    {
+        createView(texture);
+        createSampler(texture);
+
+        // Compressed blocks are copied as they are, offsets stay block aligned
+        VkDeviceSize stagingSize = 0;
+        for (const auto &level : data.levels)
+        {
+            stagingSize += level.getSize();
+        }
+
+        memory.createBuffer(stagingSize,
+                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            stage.buffer,
+                            stage.memory);
+        staging.push_back(stage);
+
+        void *mapped = nullptr;
+        if (vkMapMemory(memory.memVar.m_Device, stage.memory, 0, stagingSize, 0, &mapped) != VK_SUCCESS)
+        {
+            TX_EXCEPT("Failed to map texture staging memory");
+        }
+
+        VkDeviceSize stagingOffset = 0;
+        for (uint32_t i = 0; i < data.levels.size(); i++)
+        {
+            const TextureLevel &level = data.levels[i];
+            // Container levels come straight from the file mapping
+            memcpy(static_cast<char *>(mapped) + stagingOffset, level.getBytes(), level.getSize());
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = stagingOffset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = i;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {level.width, level.height, 1};
+            regions.push_back(region);
+
+            stagingOffset += level.getSize();
+        }
+        vkUnmapMemory(memory.memVar.m_Device, stage.memory);
+    }
+    catch (...)
+    {
+        destroyTexture(texture);
+        throw;
+    }
+
+    transitionLevels(commandBuffer, texture.image, 0, texture.mipLevels,
+                     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    vkCmdCopyBufferToImage(commandBuffer,
+                           stage.buffer,
+                           texture.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()),
+                           regions.data());
+
+    if (gpuMips)
+    {
+        recordMipBlits(commandBuffer, texture);
+    }
+    else
+    {
+        transitionLevels(commandBuffer, texture.image, 0, texture.mipLevels,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    return textures.emplace(path, texture).first->second;
+}
+
+const Texture &TextureHandler::get(const std::string &path) const
+{
+    auto loaded = textures.find(path);
+    if (loaded == textures.end())
+    {
+        TX_EXCEPT("Texture was never loaded : " + path);
+    }
+    return loaded->second;
+}
+
+bool TextureHandler::isLoaded(const std::string &path) const
+{
+    return textures.find(path) != textures.end();
+}
+
+void TextureHandler::unload(const std::string &path)
+{
+    auto loaded = textures.find(path);
+    if (loaded == textures.end())
+    {
+        return;
+    }
+    destroyTexture(loaded->second);
+    textures.erase(loaded);
+    return;
+}
+
+bool TextureHandler::hasFeatures(VkFormat format, VkFormatFeatureFlags features)
+{
+    VkFormatProperties properties{};
+    vkGetPhysicalDeviceFormatProperties(memory.memVar.selectedDevice->devHandle, format, &properties);
+    return (properties.optimalTilingFeatures & features) == features;
+}
+
+/*
+    BC7 covers both opaque and translucent images, BC1 and BC3 are
+    the fallbacks; Uncompressed RGBA8 is used when none can be sampled
+*/
+void TextureHandler::querySupport(void)
+{
+    const VkFormatFeatureFlags sampled = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                         VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    support = FormatSupport{};
+    support.linearBlit = hasFeatures(VK_FORMAT_R8G8B8A8_SRGB,
+                                     VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                         VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                         VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+
+    support.sampledBC1 = hasFeatures(VK_FORMAT_BC1_RGBA_SRGB_BLOCK, sampled);
+    support.sampledBC3 = hasFeatures(VK_FORMAT_BC3_SRGB_BLOCK, sampled);
+    support.sampledBC7 = hasFeatures(VK_FORMAT_BC7_SRGB_BLOCK, sampled);
+
+    if (support.sampledBC7)
+    {
+        support.opaqueFormat = VK_FORMAT_BC7_SRGB_BLOCK;
+        support.alphaFormat = VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+    else
+    {
+        if (support.sampledBC1)
+        {
+            support.opaqueFormat = VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        }
+        if (support.sampledBC3)
+        {
+            support.alphaFormat = VK_FORMAT_BC3_SRGB_BLOCK;
+        }
+    }
+
+    std::cout << "\t[+] Texture formats : opaque " << support.opaqueFormat
+              << " / alpha " << support.alphaFormat
+              << (support.linearBlit ? " , mips blitted" : " , mips built on CPU") << std::endl;
+    return;
+}
+
+void TextureHandler::transitionLevels(VkCommandBuffer commandBuffer,
+                                      VkImage image,
+                                      uint32_t baseMip,
+                                      uint32_t levelCount,
+                                      VkImageLayout oldLayout,
+                                      VkImageLayout newLayout,
+                                      VkAccessFlags srcAccess,
+                                      VkAccessFlags dstAccess,
+                                      VkPipelineStageFlags srcStage,
+                                      VkPipelineStageFlags dstStage)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseMip;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         srcStage,
+                         dstStage,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         1, &barrier);
+    return;
+}
+
+/*
+    Each level is blitted from the previous one, which is then
+    moved to shader read; Expects every level in TRANSFER_DST
+*/
+void TextureHandler::recordMipBlits(VkCommandBuffer commandBuffer, Texture &texture)
+{
+    int32_t mipWidth = static_cast<int32_t>(texture.width);
+    int32_t mipHeight = static_cast<int32_t>(texture.height);
+
+    for (uint32_t i = 1; i < texture.mipLevels; i++)
+    {
+        transitionLevels(commandBuffer, texture.image, i - 1, 1,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        int32_t nextWidth = std::max(mipWidth / 2, 1);
+        int32_t nextHeight = std::max(mipHeight / 2, 1);
+
+        VkImageBlit blit{};
+        blit.srcOffsets[0] = {0, 0, 0};
+        blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[0] = {0, 0, 0};
+        blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+
+        vkCmdBlitImage(commandBuffer,
+                       texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blit,
+                       VK_FILTER_LINEAR);
+
+        transitionLevels(commandBuffer, texture.image, i - 1, 1,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        mipWidth = nextWidth;
+        mipHeight = nextHeight;
+    }
+
+    // Last level was only ever written to
+    transitionLevels(commandBuffer, texture.image, texture.mipLevels - 1, 1,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    return;
+}
+
+/*
+    2x2 box filter per level, color is averaged in linear space
+    since the texture is sampled as sRGB; Odd edges reuse the last texel
+*/
+std::vector<TextureLevel> TextureHandler::buildMipChain(const TextureLevel &base, uint32_t mipLevels)
+{
+    static const auto toLinear = [](void) {
+        std::array<float, 256> table{};
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            float c = static_cast<float>(i) / 255.0f;
+            table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+    auto toSrgb = [](float c) -> unsigned char {
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        return static_cast<unsigned char>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+
+    std::vector<TextureLevel> chain;
+    chain.reserve(mipLevels > 0 ? mipLevels - 1 : 0);
+
+    const TextureLevel *previous = &base;
+    for (uint32_t level = 1; level < mipLevels; level++)
+    {
+        TextureLevel next{};
+        next.width = std::max(previous->width / 2, 1u);
+        next.height = std::max(previous->height / 2, 1u);
+        next.data.resize(static_cast<size_t>(next.width) * next.height * 4);
+
+        for (uint32_t y = 0; y < next.height; y++)
+        {
+            uint32_t y0 = std::min(y * 2, previous->height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, previous->height - 1);
+            for (uint32_t x = 0; x < next.width; x++)
+            {
+                uint32_t x0 = std::min(x * 2, previous->width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, previous->width - 1);
+
+                const unsigned char *texels[4] = {
+                    &previous->data[(static_cast<size_t>(y0) * previous->width + x0) * 4],
+                    &previous->data[(static_cast<size_t>(y0) * previous->width + x1) * 4],
+                    &previous->data[(static_cast<size_t>(y1) * previous->width + x0) * 4],
+                    &previous->data[(static_cast<size_t>(y1) * previous->width + x1) * 4]};
+
+                unsigned char *out = &next.data[(static_cast<size_t>(y) * next.width + x) * 4];
+                for (int c = 0; c < 3; c++)
+                {
+                    float sum = 0.0f;
+                    for (const auto *texel : texels)
+                    {
+                        sum += toLinear[texel[c]];
+                    }
+                    out[c] = toSrgb(sum * 0.25f);
+                }
+                // Alpha is stored linearly
+                out[3] = static_cast<unsigned char>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+            }
+        }
+
+        chain.push_back(std::move(next));
+        previous = &chain.back();
+    }
+    return chain;
+}
+
+void TextureHandler::createView(Texture &texture)
+{
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.pNext = nullptr;
+    viewInfo.flags = 0;
+    viewInfo.image = texture.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = texture.format;
+    viewInfo.components = {
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+        VK_COMPONENT_SWIZZLE_IDENTITY,
+        VK_COMPONENT_SWIZZLE_IDENTITY};
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = texture.mipLevels;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(memory.memVar.m_Device, &viewInfo, nullptr, &texture.view) != VK_SUCCESS)
+    {
+        TX_EXCEPT("Failed to create texture image view");
+    }
+    return;
+}
+
+void TextureHandler::createSampler(Texture &texture)
+{
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext = nullptr;
+    samplerInfo.flags = 0;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.mipLodBias = 0.0f;
+    // Anisotropy is not enabled at device creation
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(texture.mipLevels);
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+    if (vkCreateSampler(memory.memVar.m_Device, &samplerInfo, nullptr, &texture.sampler) != VK_SUCCESS)
+    {
+        TX_EXCEPT("Failed to create texture sampler");
+    }
+    return;
+}
+
+void TextureHandler::destroyTexture(Texture &texture)
+{
+    if (texture.sampler != nullptr)
+    {
+        vkDestroySampler(memory.memVar.m_Device, texture.sampler, nullptr);
+    }
+    if (texture.view != nullptr)
+    {
+        vkDestroyImageView(memory.memVar.m_Device, texture.view, nullptr);
+    }
+    if (texture.image != nullptr)
+    {
+        vkDestroyImage(memory.memVar.m_Device, texture.image, nullptr);
+    }
+    if (texture.memory != nullptr)
+    {
+        vkFreeMemory(memory.memVar.m_Device, texture.memory, nullptr);
+    }
+    texture = Texture{};
+    return;
+}
+
+void TextureHandler::releaseStaging(void)
+{
+    for (auto &stage : staging)
+    {
+        vkDestroyBuffer(memory.memVar.m_Device, stage.buffer, nullptr);
+        vkFreeMemory(memory.memVar.m_Device, stage.memory, nullptr);
+    }
+    staging.clear();
+    return;
+}
+
+void TextureHandler::clearDecodeCache(void)
+{
+    for (auto it = decodeCache.begin(); it != decodeCache.end();)
+    {
+        bool finished = it->second.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        it = finished ? decodeCache.erase(it) : std::next(it);
+    }
+    return;
+}
+
+void TextureHandler::cleanup(void)
+{
+    releaseStaging();
+    for (auto &texture : textures)
+    {
+        destroyTexture(texture.second);
+    }
+    textures.clear();
+
+    // Outstanding decodes still reference the job system, let them finish
+    for (auto &entry : decodeCache)
+    {
+        entry.second.result.wait();
+    }
+    decodeCache.clear();
+    return;
+}
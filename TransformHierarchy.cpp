@@ -0,0 +1,288 @@
+#include "TransformHierarchy.h"
+#include "BatchMath.h"
+#include "EntitySystems.h"
+
+#include <algorithm>
+#include <array>
+
+TransformHierarchy::Exception::Exception(int l, std::string f, std::string description)
+    : ExceptionHandler(l, f, description)
+{
+    type = "Transform Hierarchy Exception";
+    errorDescription = description;
+    return;
+}
+
+TransformHierarchy::Exception::~Exception(void)
+{
+    return;
+}
+
+TransformHierarchy::TransformHierarchy(JobSystem *jobs)
+    : jobs(jobs)
+{
+    return;
+}
+
+TransformHierarchy::~TransformHierarchy(void)
+{
+    return;
+}
+
+TransformNode TransformHierarchy::create(TransformNode parent, Entity entity)
+{
+    uint32_t depth = 0;
+    if (parent != TRANSFORM_NODE_INVALID)
+    {
+        depth = getRecord(parent).depth + 1;
+    }
+
+    TransformNode node;
+    if (!freeNodes.empty())
+    {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<TransformNode>(records.size());
+        records.push_back(NodeRecord{});
+    }
+
+    if (depth >= levels.size())
+    {
+        levels.resize(depth + 1);
+    }
+    Level &level = levels[depth];
+    NodeRecord &record = records[node];
+    record.depth = depth;
+    record.row = static_cast<uint32_t>(level.nodes.size());
+    record.dirty = false;
+
+    level.nodes.push_back(node);
+    level.parents.push_back(parent);
+    level.entities.push_back(entity);
+    level.positions.push_back(glm::vec3(0.0f));
+    level.rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    level.scales.push_back(glm::vec3(1.0f));
+    level.worldMatrices.push_back(glm::mat4(1.0f));
+
+    if (parent != TRANSFORM_NODE_INVALID)
+    {
+        records[parent].children.push_back(node);
+    }
+    markDirty(node);
+    return node;
+}
+
+void TransformHierarchy::destroy(TransformNode node)
+{
+    if (!isAlive(node))
+    {
+        return;
+    }
+
+    std::vector<TransformNode> subtree = {node};
+    for (size_t i = 0; i < subtree.size(); i++)
+    {
+        const auto &children = records[subtree[i]].children;
+        subtree.insert(subtree.end(), children.begin(), children.end());
+    }
+
+    const NodeRecord &record = records[node];
+    TransformNode parent = levels[record.depth].parents[record.row];
+    if (parent != TRANSFORM_NODE_INVALID)
+    {
+        auto &siblings = records[parent].children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+    }
+
+    // Children first so no row is left pointing at a removed parent
+    for (auto it = subtree.rbegin(); it != subtree.rend(); it++)
+    {
+        removeNode(*it);
+    }
+    return;
+}
+
+// Swap removes the row, the node must have no children left alive
+void TransformHierarchy::removeNode(TransformNode node)
+{
+    NodeRecord &record = records[node];
+    Level &level = levels[record.depth];
+    if (record.dirty)
+    {
+        level.dirtyNodes.erase(std::find(level.dirtyNodes.begin(), level.dirtyNodes.end(), node));
+    }
+
+    auto swapRemove = [row = record.row](auto &column) {
+        column[row] = column.back();
+        column.pop_back();
+    };
+    TransformNode last = level.nodes.back();
+    records[last].row = record.row;
+
+    swapRemove(level.nodes);
+    swapRemove(level.parents);
+    swapRemove(level.entities);
+    swapRemove(level.positions);
+    swapRemove(level.rotations);
+    swapRemove(level.scales);
+    swapRemove(level.worldMatrices);
+
+    record.depth = UINT32_MAX;
+    record.dirty = false;
+    record.children.clear();
+    freeNodes.push_back(node);
+    return;
+}
+
+bool TransformHierarchy::isAlive(TransformNode node) const
+{
+    return node < records.size() && records[node].depth != UINT32_MAX;
+}
+
+size_t TransformHierarchy::getNodeCount(void) const
+{
+    return records.size() - freeNodes.size();
+}
+
+const TransformHierarchy::NodeRecord &TransformHierarchy::getRecord(TransformNode node) const
+{
+    if (!isAlive(node))
+    {
+        TH_EXCEPT("Transform node is not alive");
+    }
+    return records[node];
+}
+
+void TransformHierarchy::setLocal(TransformNode node,
+                                  const glm::vec3 &position,
+                                  const glm::quat &rotation,
+                                  const glm::vec3 &scale)
+{
+    const NodeRecord &record = getRecord(node);
+    Level &level = levels[record.depth];
+    level.positions[record.row] = position;
+    level.rotations[record.row] = rotation;
+    level.scales[record.row] = scale;
+    markDirty(node);
+    return;
+}
+
+const glm::mat4 &TransformHierarchy::getWorldMatrix(TransformNode node) const
+{
+    const NodeRecord &record = getRecord(node);
+    return levels[record.depth].worldMatrices[record.row];
+}
+
+/*
+    A dirty node always has a dirty subtree, so the walk stops at
+    nodes that are already dirty
+*/
+void TransformHierarchy::markDirty(TransformNode node)
+{
+    std::vector<TransformNode> pending = {node};
+    while (!pending.empty())
+    {
+        TransformNode current = pending.back();
+        pending.pop_back();
+
+        NodeRecord &record = records[current];
+        if (record.dirty)
+        {
+            continue;
+        }
+        record.dirty = true;
+        levels[record.depth].dirtyNodes.push_back(current);
+        pending.insert(pending.end(), record.children.begin(), record.children.end());
+    }
+    return;
+}
+
+/*
+    Only reads the level above, safe to run on disjoint ranges of a level at once
+    Dirty rows are scattered, they are gathered so the local and parent
+    products of a chunk each go through the batch kernels in one call
+*/
+void TransformHierarchy::computeNodes(uint32_t depth, size_t begin, size_t end)
+{
+    Level &level = levels[depth];
+    std::array<uint32_t, TRANSFORM_GATHER_SIZE> rows;
+    std::array<glm::vec3, TRANSFORM_GATHER_SIZE> positions;
+    std::array<glm::quat, TRANSFORM_GATHER_SIZE> rotations;
+    std::array<glm::vec3, TRANSFORM_GATHER_SIZE> scales;
+    std::array<glm::mat4, TRANSFORM_GATHER_SIZE> parentMatrices;
+    std::array<glm::mat4, TRANSFORM_GATHER_SIZE> worldMatrices;
+
+    for (size_t chunk = begin; chunk < end; chunk += TRANSFORM_GATHER_SIZE)
+    {
+        const size_t count = std::min(end - chunk, TRANSFORM_GATHER_SIZE);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t row = records[level.dirtyNodes[chunk + i]].row;
+            rows[i] = row;
+            positions[i] = level.positions[row];
+            rotations[i] = level.rotations[row];
+            scales[i] = level.scales[row];
+        }
+        composeTransforms(positions.data(), rotations.data(), scales.data(), worldMatrices.data(), count);
+
+        if (depth > 0)
+        {
+            const Level &above = levels[depth - 1];
+            for (size_t i = 0; i < count; i++)
+            {
+                parentMatrices[i] = above.worldMatrices[records[level.parents[rows[i]]].row];
+            }
+            multiplyMatrices(parentMatrices.data(), worldMatrices.data(), worldMatrices.data(), count);
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            level.worldMatrices[rows[i]] = worldMatrices[i];
+        }
+    }
+    return;
+}
+
+size_t TransformHierarchy::update(EntityStore &store)
+{
+    size_t computed = 0;
+    for (uint32_t depth = 0; depth < levels.size(); depth++)
+    {
+        Level &level = levels[depth];
+        const size_t count = level.dirtyNodes.size();
+        if (count == 0)
+        {
+            continue;
+        }
+
+        // Small levels are not worth a round trip through the queues
+        if (jobs == nullptr || count <= TRANSFORM_BATCH_SIZE)
+        {
+            computeNodes(depth, 0, count);
+        }
+        else
+        {
+            JobCounter counter;
+            auto compute = [this, depth](size_t begin, size_t end) { computeNodes(depth, begin, end); };
+            jobs->parallelFor(count, TRANSFORM_BATCH_SIZE, compute, counter);
+            jobs->wait(counter);
+        }
+
+        for (TransformNode node : level.dirtyNodes)
+        {
+            const NodeRecord &record = records[node];
+            Entity entity = level.entities[record.row];
+            if (store.isAlive(entity))
+            {
+                store.setWorldMatrix(entity, level.worldMatrices[record.row]);
+            }
+            records[node].dirty = false;
+        }
+        computed += count;
+        level.dirtyNodes.clear();
+    }
+    return computed;
+}
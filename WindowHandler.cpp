@@ -120,68 +120,137 @@ WindowHandler::~WindowHandler(void)
 
 void WindowHandler::go(void)
 {
-	size_t currentFrame = 0;
-	auto startTime = std::chrono::high_resolution_clock::now();
-	uint32_t frames = 0;
-	while (running)
-	{
-		while (XPending(display))
-		{
-			handleXEvent();
-		} // End of X11 Event loop
-
-		// Fetch keyboard and mouse events
-		Keyboard::Event kbdEvent = kbd.readKey();
-		Mouse::Event mouseEvent = mouse.read();
+	// Rendering is paced by the GPU, the simulation by its own tick
+	std::thread renderThread(&WindowHandler::renderLoop, this);
 
-		// Process events
-		if (mouseEvent.getType() == Mouse::Event::Type::Move)
-		{
-			std::pair<int, int> mDelta = mouse.getPosDelta();
-			glm::vec4 mouseRotate = {mDelta.second * 0.8f, mDelta.first * 0.8f, 0.0f, 0.0f};
-			gfx->camera->rotate(mouseRotate);
-		}
-
-		/* Process movement */
-		if (kbd.isKeyPressed('w'))
-		{
-			gfx->camera->moveForward();
-		}
-		if (kbd.isKeyPressed('a'))
-		{
-			gfx->camera->moveLeft();
-		}
-		if (kbd.isKeyPressed('s'))
-		{
-			gfx->camera->moveBackward();
-		}
-		if (kbd.isKeyPressed('d'))
+	const float tickSeconds = clock.getTickSeconds();
+	// Mouse look since the last tick, applied by the next one
+	glm::vec3 pendingRotate = {0.0f, 0.0f, 0.0f};
+	try
+	{
+		while (running)
 		{
-			gfx->camera->moveRight();
-		}
-
-		draw(currentFrame);
-
-		frames += 1;
+			while (XPending(display))
+			{
+				handleXEvent();
+			} // End of X11 Event loop
+
+			// Fetch keyboard and mouse events
+			Keyboard::Event kbdEvent = kbd.readKey();
+			Mouse::Event mouseEvent = mouse.read();
+
+			// Process events
+			if (mouseEvent.getType() == Mouse::Event::Type::Move)
+			{
+				std::pair<int, int> mDelta = mouse.getPosDelta();
+				glm::vec3 mouseRotate = {mDelta.second * 0.8f, mDelta.first * 0.8f, 0.0f};
+				pendingRotate += mouseRotate;
+			}
+
+			// Whole fixed ticks for the time that passed, so movement does not depend on the frame rate
+			for (int due = clock.advance(); due > 0; due--)
+			{
+				glm::vec3 previousCameraPosition = gfx->camera->getPosition();
+				glm::vec3 previousCameraForward = gfx->camera->getForward();
+
+				// After the previous forward is taken, so the renderer blends the turn and sees the camera moved
+				gfx->camera->rotate(pendingRotate);
+				pendingRotate = glm::vec3(0.0f);
+
+				/* Process movement */
+				if (kbd.isKeyPressed('w'))
+				{
+					gfx->camera->moveForward(tickSeconds);
+				}
+				if (kbd.isKeyPressed('a'))
+				{
+					gfx->camera->moveLeft(tickSeconds);
+				}
+				if (kbd.isKeyPressed('s'))
+				{
+					gfx->camera->moveBackward(tickSeconds);
+				}
+				if (kbd.isKeyPressed('d'))
+				{
+					gfx->camera->moveRight(tickSeconds);
+				}
+
+				// Camera and instances go out as one packet, the renderer picks up the newest
+				FramePacket &packet = packets.getWritePacket();
+				packet.tick = clock.getTickCount();
+				packet.previousCameraPosition = previousCameraPosition;
+				packet.previousCameraForward = previousCameraForward;
+				gfx->updateEntities(packet);
+				packet.tickTime = clock.step();
+				packets.publish();
+			}
+
+			std::this_thread::sleep_until(clock.getNextTickTime());
+		} // End of game loop
+	}
+	catch (...)
+	{
+		packets.stop();
+		renderThread.join();
+		throw;
+	}
 
-		auto endTime = std::chrono::high_resolution_clock::now();
-		auto duration = std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count();
+	packets.stop();
+	renderThread.join();
+	if (renderError)
+	{
+		std::rethrow_exception(renderError);
+	}
+	return;
+}
 
-		if (duration >= 0.25 && frames >= 10)
+void WindowHandler::renderLoop(void)
+{
+	size_t currentFrame = 0;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	uint32_t frames = 0;
+	try
+	{
+		while (const FramePacket *packet = packets.acquire())
 		{
-			float fps = frames / duration;
-			std::cout << "FPS -> " << std::fixed << std::setprecision(14) << fps << std::endl;
-
-			// Reset frames/start time
-			frames = 0;
-			startTime = std::chrono::high_resolution_clock::now();
+			// Runs one tick behind the simulation, blending towards the newest packet as time passes
+			float alpha = clock.getAlpha(packet->tickTime, SimulationClock::Clock::now());
+			draw(currentFrame, *packet, alpha);
+
+			frames += 1;
+
+			auto endTime = std::chrono::high_resolution_clock::now();
+			auto duration = std::chrono::duration<float, std::chrono::seconds::period>(endTime - startTime).count();
+
+			if (duration >= 0.25 && frames >= 10)
+			{
+				float fps = frames / duration;
+				std::cout << "FPS -> " << std::fixed << std::setprecision(14) << fps << std::endl;
+
+				RenderStats stats = gfx->getFrameStats();
+				std::cout << "[+] Draws " << stats.drawCalls
+						  << " | pipeline binds " << stats.pipelineBinds
+						  << " | descriptor binds " << stats.descriptorBinds
+						  << " | vertex binds " << stats.vertexBufferBinds
+						  << " | index binds " << stats.indexBufferBinds
+						  << " | skipped " << stats.skippedBinds << std::endl;
+
+				// Reset frames/start time
+				frames = 0;
+				startTime = std::chrono::high_resolution_clock::now();
+			}
 		}
-	} // End of game loop
-
+	}
+	catch (...)
+	{
+		// Raised again on the simulation thread once it has stopped
+		renderError = std::current_exception();
+		running = false;
+	}
 	return;
 }
 
-void WindowHandler::draw(size_t currentFrame)
+void WindowHandler::draw(size_t currentFrame, const FramePacket &packet, float alpha)
 {
 	VkResult result;
 	uint32_t imageIndex;
@@ -220,10 +289,11 @@ void WindowHandler::draw(size_t currentFrame)
 		break;
 	}
 
-	// Update
-	gfx->camera->update();
+	// Uploads assets that finished decoding, never blocks
+	gfx->streamAssets(packet.getCameraPosition(alpha));
+	// Recompiled shaders take effect from this frame on, nothing waits for the device
+	gfx->reloadShaders();
 	gfx->updateUniformModelBuffer(imageIndex);
-	gfx->updateUniformVPBuffer(imageIndex);
 
 	// If image still use, wait for it
 	if (gfx->m_imagesInFlight[imageIndex] != VK_NULL_HANDLE)
@@ -231,11 +301,14 @@ void WindowHandler::draw(size_t currentFrame)
 		vkWaitForFences(gfx->m_Device, 1, &gfx->m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
 	}
 
+	// The camera this frame is drawn from, into the image's buffer now nothing reads it
+	gfx->updateUniformVPBuffer(imageIndex, packet, alpha);
+
 	// Now mark the image as in use
 	gfx->m_imagesInFlight[imageIndex] = gfx->m_inFlightFences[currentFrame];
 
 	// Record command buffer
-	gfx->recordCommandBuffer(imageIndex);
+	gfx->recordCommandBuffer(imageIndex, packet, alpha);
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -290,6 +363,8 @@ void WindowHandler::draw(size_t currentFrame)
 		W_EXCEPT("There was an unhandled exception while acquiring a swapchain image for rendering!");
 		break;
 	}
+
+	gfx->reportFirstFrame();
 	return;
 }
 
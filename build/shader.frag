@@ -1,10 +1,22 @@
-#version 450
-#extension GL_ARB_separate_shader_objects : enable
-
-layout(location = 0) in vec4 fragColor;
-
-layout(location = 0) out vec4 outColor;
-
-void main() {
-    outColor = fragColor;
-}
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+const uint NO_TEXTURE = 0xFFFFFFFFu;
+
+// Bindless textures, every draw's texture is one slot of the global set
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = fragColor;
+    if (fragTextureIndex != NO_TEXTURE) {
+        // Flat per draw, but draws of different slots may share a subgroup
+        outColor *= texture(textures[nonuniformEXT(fragTextureIndex)], fragTexCoord);
+    }
+}
@@ -1,44 +1,83 @@
-#version 450
-#extension GL_ARB_separate_shader_objects : enable
-
-/*
-	Whenever a new model is being drawn the buffer
-	will be rebound in the CommandBuffer at a new offset
-
-	The shader only needs to grab 64 bytes per vertex and apply the math
-
-	CPU side code will handle putting the correct 64 bytes in front of the shader
-*/
-layout(binding = 0) uniform uniformModelBuffer {
-	mat4 model;
-} m; // Converting this to push constant
-
-layout(push_constant) uniform pushConstant {
-	mat4 model;
-} pConst;
-
-layout(binding = 1) uniform viewProjectionBuffer {
-	mat4 view;
-	mat4 proj;
-} vp;
-
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec4 inColor;
-
-// Will add a uniform buffer that will contain View and project matrices
-// 128 bytes of data should fit into a push constant for high speed updates of camera view
-
-
-/* OUTPUT */
-layout(location = 0) out vec4 fragColor;
-
-void main() {
-	gl_Position = vp.proj * vp.view * pConst.model * vec4(inPosition, 1.0);
-	// if(inPosition[0] == 0 || inPosition[1] == 0 || inPosition[2] == 0) {
-	// 	gl_Position = vec4(hp[gl_VertexIndex], 1.0);
-	// } else {
-	// 	gl_Position = vec4(inPosition, 1.0);
-	// }
-	// passthru
-	fragColor = inColor;
-}
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+/*
+	Per-draw data, laid out as DrawConstants in Primitives.h :
+	the bindless indexes first, the model matrix at offset 16
+
+	The CPU side hands the same constants over one of three ways,
+	specialization constant 0 is the DrawDataPath this pipeline
+	was built for and picks where they are read from
+*/
+layout(constant_id = 0) const uint drawDataPath = 0;
+const uint PATH_DYNAMIC_UNIFORM = 1;
+const uint PATH_INSTANCE_TABLE = 2;
+
+struct DrawConstants {
+	uint drawTable;
+	uint textureIndex;
+	uint materialIndex;
+	mat4 model;
+};
+
+// Whole constants per draw, only drawTable under the instance table
+layout(push_constant) uniform pushConstant {
+	uint drawTable;
+	uint textureIndex;
+	uint materialIndex;
+	mat4 model;
+} pConst;
+
+// Rebound at each draw's dynamic offset
+layout(set = 0, binding = 0) uniform uniformDrawBuffer {
+	uint drawTable;
+	uint textureIndex;
+	uint materialIndex;
+	mat4 model;
+} m;
+
+layout(set = 0, binding = 1) uniform viewProjectionBuffer {
+	mat4 view;
+	mat4 proj;
+} vp;
+
+// Bindless storage buffers, pConst.drawTable is the slot of the frame's instance table
+layout(set = 2, binding = 1) readonly buffer drawTableBuffer {
+	DrawConstants draws[];
+} drawTables[];
+
+// The colour pass tests EQUAL against the depth pre-pass, both must compute the same depth
+invariant gl_Position;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+
+/* OUTPUT */
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+// Slot in the bindless texture array, UINT32_MAX for none
+layout(location = 2) flat out uint fragTextureIndex;
+
+void main() {
+	mat4 model;
+	uint textureIndex;
+	if (drawDataPath == PATH_DYNAMIC_UNIFORM) {
+		model = m.model;
+		textureIndex = m.textureIndex;
+	} else if (drawDataPath == PATH_INSTANCE_TABLE) {
+		// Draws pass their row of the table as firstInstance
+		model = drawTables[pConst.drawTable].draws[gl_InstanceIndex].model;
+		textureIndex = drawTables[pConst.drawTable].draws[gl_InstanceIndex].textureIndex;
+	} else {
+		model = pConst.model;
+		textureIndex = pConst.textureIndex;
+	}
+
+	gl_Position = vp.proj * vp.view * model * vec4(inPosition, 1.0);
+	// passthru
+	fragColor = inColor;
+	// Vertex has no texture coordinates yet, models are mapped flat across x and y
+	fragTexCoord = inPosition.xy + 0.5;
+	fragTextureIndex = textureIndex;
+}
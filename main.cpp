@@ -1,8 +1,12 @@
 // Copyright 2021 .. fake
 #include "WindowHandler.h"
-
+#include "Benchmark.h"
 
 int main(__attribute__((unused))int argc, __attribute__((unused))char *argv[]) {
+#ifdef ENGINE_BENCHMARKS
+  runBenchmarks();
+  return 0;
+#endif
   try {
     WindowHandler wnd(WINDOW_WIDTH, WINDOW_HEIGHT, "Bloody Day");
     if (wnd.goodInit) {